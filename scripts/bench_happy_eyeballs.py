@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+
+"""Dual-stack broker connection benchmark for the Native Sim build.
+
+Runs a Native Sim build made with overlay-happy-eyeballs-native_sim.conf against a local
+broker that listens on both address families, with neither family, the IPv4 family or the
+IPv6 family black-holed. Each case is run once racing the families, and once trying one
+address at a time with --serial-timeout as the time given to each attempt, which stands in for
+a TCP connection timeout. Each run races the connection --runs times and prints a
+HAPPY_EYEBALLS_RESULT line per race. The first race starts with IPv6, and the later ones
+with the family that won before. The results are written as JSON.
+
+A family is black-holed in the Native Sim build, by replacing its broker addresses with an
+unused address on the zeth subnet, so that its connection attempts get no answer at all. The
+Native Sim build reaches the host at 192.0.2.2 and 2001:db8::2 through the zeth interface,
+which must be set up first with the net-setup.sh script from the Zephyr net-tools repository.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import subprocess
+import sys
+
+from bench_native_sim import MinimalBroker, git_describe
+
+RESULT_PREFIX = 'HAPPY_EYEBALLS_RESULT '
+
+BLACKHOLES = ['none', 'ipv4', 'ipv6']
+
+
+def run_once(args, blackhole, serial):
+    command = [args.exe, f'--he-bench-runs={args.runs}']
+
+    if blackhole != 'none':
+        command.append(f'--he-blackhole={blackhole}')
+
+    if serial:
+        command += ['--he-serial', f'--he-attempt-delay={args.serial_timeout}']
+
+    try:
+        completed = subprocess.run(command, capture_output=True, text=True,
+                                   timeout=args.timeout, check=False)
+        output = completed.stdout
+    except subprocess.TimeoutExpired as e:
+        output = e.stdout.decode(errors='replace') if isinstance(e.stdout, bytes) else e.stdout
+
+    results = []
+
+    for line in (output or '').splitlines():
+        index = line.find(RESULT_PREFIX)
+        if index >= 0:
+            results.append(json.loads(line[index + len(RESULT_PREFIX):]))
+
+    return results
+
+
+def summarize(blackhole, serial, races):
+    connected = [r for r in races if r['error'] == 0]
+    later = [r['connect_ms'] for r in connected[1:]]
+
+    return {
+        'blackhole': blackhole,
+        'mode': 'serial' if serial else 'race',
+        'races': len(races),
+        'failures': len(races) - len(connected),
+        'first_ms': connected[0]['connect_ms'] if connected else None,
+        'first_family': connected[0]['family'] if connected else None,
+        'later_mean_ms': round(sum(later) / len(later), 1) if later else None,
+        'later_family': connected[-1]['family'] if len(connected) > 1 else None,
+        'results': races,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--exe', default='build/zephyr/zephyr.exe',
+                        help='Native Sim executable built with '
+                             'overlay-happy-eyeballs-native_sim.conf')
+    parser.add_argument('--runs', type=int, default=5, help='Races per run')
+    parser.add_argument('--serial-timeout', type=int, default=5000,
+                        help='Time given to each attempt in serial mode, in milliseconds')
+    parser.add_argument('--timeout', type=int, default=120, help='Timeout per run in seconds')
+    parser.add_argument('--external-broker', action='store_true',
+                        help='Use a broker that is already running on both families')
+    parser.add_argument('--port', type=int, default=1883, help='Port that the broker listens on')
+    parser.add_argument('--output', default='bench_results.json', help='JSON output file')
+    args = parser.parse_args()
+
+    if not os.access(args.exe, os.X_OK):
+        sys.exit(f'{args.exe} not found, build with overlay-happy-eyeballs-native_sim.conf first')
+
+    broker = None
+    summaries = []
+    failed = False
+
+    if not args.external_broker:
+        # No host, to listen on all addresses of both families
+        broker = MinimalBroker(None, args.port)
+        broker.start()
+
+    try:
+        print(f'{"Blackhole":>9} {"Mode":>6} {"First ms":>9} {"Family":>6} '
+              f'{"Later ms":>9} {"Family":>6} {"Fail":>5}')
+
+        for blackhole in BLACKHOLES:
+            for serial in (False, True):
+                races = run_once(args, blackhole, serial)
+                summary = summarize(blackhole, serial, races)
+                summaries.append(summary)
+
+                if not races or summary['failures']:
+                    failed = True
+
+                print(f'{blackhole:>9} {summary["mode"]:>6} {str(summary["first_ms"]):>9} '
+                      f'{str(summary["first_family"]):>6} {str(summary["later_mean_ms"]):>9} '
+                      f'{str(summary["later_family"]):>6} {summary["failures"]:>5}')
+    finally:
+        if broker:
+            broker.stop()
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump({
+            'timestamp': datetime.datetime.now(datetime.timezone.utc).isoformat(),
+            'revision': git_describe(os.path.dirname(os.path.abspath(__file__))),
+            'runs': args.runs,
+            'serial_timeout_ms': args.serial_timeout,
+            'results': summaries,
+        }, f, indent=2)
+        f.write('\n')
+
+    print(f'Results written to {args.output}')
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
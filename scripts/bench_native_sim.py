@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+
+"""End-to-end publish benchmark for the Native Sim build.
+
+Runs a Native Sim build made with overlay-bench-native_sim.conf once for each combination of
+publish rate and payload size, against a local broker, and collects the BENCH_RESULT line
+that each run prints. The results are written as JSON so that they can be tracked over time.
+
+By default a minimal in-tree MQTT 3.1.1 broker is started, which acknowledges everything and
+routes nothing. Use --broker mosquitto to start mosquitto instead, or --broker external to use
+a broker that is already running. The Native Sim build reaches the host at 192.0.2.2 through
+the zeth interface, which must be set up first with the net-setup.sh script from the Zephyr
+net-tools repository.
+
+With --profile, the runs go through the impairment proxy in net_impair.py, which adds the
+latency, jitter, loss and bandwidth limit of the profile. The broker then listens on the next
+port on the loopback interface, and the proxy on the broker's place. Link outages of the
+profile are scheduled in the Native Sim build, which needs CONFIG_MQTT_SAMPLE_LINK_OUTAGE.
+"""
+
+import argparse
+import asyncio
+import datetime
+import json
+import os
+import shutil
+import subprocess
+import sys
+import threading
+import time
+
+import net_impair
+
+RESULT_PREFIX = 'BENCH_RESULT '
+
+CONNECT = 1
+PUBLISH = 3
+SUBSCRIBE = 8
+PINGREQ = 12
+DISCONNECT = 14
+
+
+class MinimalBroker:
+    """MQTT 3.1.1 broker stand-in. Accepts any client, acknowledges publishes and subscriptions,
+    and answers pings. Messages are counted but not routed."""
+
+    def __init__(self, host, port):
+        self.host = host
+        self.port = port
+        self.publishes = 0
+        self.loop = None
+        self.server = None
+        self.ready = threading.Event()
+
+    async def read_packet(self, reader):
+        header = (await reader.readexactly(1))[0]
+        length = 0
+        shift = 0
+
+        while True:
+            byte = (await reader.readexactly(1))[0]
+            length |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+
+        body = await reader.readexactly(length) if length else b''
+
+        return header >> 4, header & 0x0f, body
+
+    async def handle(self, reader, writer):
+        try:
+            while True:
+                packet_type, flags, body = await self.read_packet(reader)
+
+                if packet_type == CONNECT:
+                    writer.write(bytes([0x20, 0x02, 0x00, 0x00]))
+                elif packet_type == PUBLISH:
+                    self.publishes += 1
+                    qos = (flags >> 1) & 0x03
+                    if qos > 0:
+                        topic_len = int.from_bytes(body[0:2], 'big')
+                        packet_id = body[2 + topic_len:4 + topic_len]
+                        writer.write(bytes([0x40 if qos == 1 else 0x50, 0x02]) + packet_id)
+                elif packet_type == SUBSCRIBE:
+                    packet_id = body[0:2]
+                    granted = []
+                    pos = 2
+                    while pos < len(body):
+                        topic_len = int.from_bytes(body[pos:pos + 2], 'big')
+                        pos += 2 + topic_len
+                        granted.append(min(body[pos], 1))
+                        pos += 1
+                    writer.write(bytes([0x90, 2 + len(granted)]) + packet_id + bytes(granted))
+                elif packet_type == PINGREQ:
+                    writer.write(bytes([0xd0, 0x00]))
+                elif packet_type == DISCONNECT:
+                    break
+
+                await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            writer.close()
+
+    def run(self):
+        self.loop = asyncio.new_event_loop()
+        self.server = self.loop.run_until_complete(
+            asyncio.start_server(self.handle, self.host, self.port))
+        self.ready.set()
+        self.loop.run_forever()
+
+    def start(self):
+        threading.Thread(target=self.run, daemon=True).start()
+        self.ready.wait()
+
+    def stop(self):
+        self.loop.call_soon_threadsafe(self.server.close)
+        self.loop.call_soon_threadsafe(self.loop.stop)
+
+
+def start_broker(args, host, port):
+    if args.broker == 'internal':
+        broker = MinimalBroker(host, port)
+        broker.start()
+        return broker.stop
+
+    if args.broker == 'mosquitto':
+        mosquitto = shutil.which('mosquitto')
+        if not mosquitto:
+            sys.exit('mosquitto not found')
+
+        config = os.path.join(args.work_dir, 'mosquitto.conf')
+        with open(config, 'w', encoding='utf-8') as f:
+            f.write(f'listener {port} {host}\nallow_anonymous true\n')
+
+        process = subprocess.Popen([mosquitto, '-c', config], stdout=subprocess.DEVNULL,
+                                   stderr=subprocess.DEVNULL)
+        time.sleep(1)
+        return process.terminate
+
+    return lambda: None
+
+
+def run_once(args, rate, size, profile):
+    command = [args.exe, f'--bench-rate={rate}', f'--bench-size={size}',
+               f'--bench-count={args.count}']
+
+    if profile:
+        command += net_impair.outage_args(profile)
+
+    try:
+        completed = subprocess.run(command, capture_output=True, text=True,
+                                   timeout=args.timeout, check=False)
+        output = completed.stdout
+    except subprocess.TimeoutExpired as e:
+        output = e.stdout.decode(errors='replace') if isinstance(e.stdout, bytes) else e.stdout
+
+    for line in (output or '').splitlines():
+        index = line.find(RESULT_PREFIX)
+        if index >= 0:
+            return json.loads(line[index + len(RESULT_PREFIX):])
+
+    return None
+
+
+def git_describe(path):
+    try:
+        return subprocess.run(['git', 'describe', '--always', '--dirty'], cwd=path,
+                              capture_output=True, text=True, check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--exe', default='build/zephyr/zephyr.exe',
+                        help='Native Sim executable built with overlay-bench-native_sim.conf')
+    parser.add_argument('--rates', default='10,100,0',
+                        help='Comma separated publish rates in messages per second, '
+                             '0 for back to back')
+    parser.add_argument('--sizes', default='16,256,1000',
+                        help='Comma separated payload sizes in bytes')
+    parser.add_argument('--count', type=int, default=200, help='Messages per run')
+    parser.add_argument('--timeout', type=int, default=300, help='Timeout per run in seconds')
+    parser.add_argument('--broker', choices=['internal', 'mosquitto', 'external'],
+                        default='internal')
+    parser.add_argument('--host', default='0.0.0.0', help='Address that the broker listens on')
+    parser.add_argument('--port', type=int, default=1883, help='Port that the broker listens on')
+    parser.add_argument('--output', default='bench_results.json', help='JSON output file')
+    parser.add_argument('--profile',
+                        help='Network profile from net_profiles.json. With --broker external, '
+                             'the broker must listen on 127.0.0.1 on the port after --port')
+    parser.add_argument('--profiles-file', default=net_impair.PROFILES_FILE)
+    parser.add_argument('--seed', type=int, default=1, help='Random seed of the network profile')
+    args = parser.parse_args()
+
+    args.work_dir = os.path.dirname(os.path.abspath(args.output))
+    rates = [int(r) for r in args.rates.split(',')]
+    sizes = [int(s) for s in args.sizes.split(',')]
+
+    if not os.access(args.exe, os.X_OK):
+        sys.exit(f'{args.exe} not found, build with overlay-bench-native_sim.conf first')
+
+    profile = None
+    broker_host, broker_port = args.host, args.port
+
+    if args.profile:
+        profile = net_impair.load_profile(args.profile, args.profiles_file)
+        broker_host, broker_port = '127.0.0.1', args.port + 1
+
+    stop_broker = start_broker(args, broker_host, broker_port)
+    proxy = None
+    results = []
+    failed = False
+
+    try:
+        if profile:
+            proxy = net_impair.ImpairProxy(args.host, args.port, broker_host, broker_port,
+                                           profile, args.seed)
+            proxy.start()
+
+        print(f'{"Rate":>6} {"Size":>6} {"Acked":>9} {"msg/s":>9} {"p50 us":>9} {"p99 us":>9} '
+              f'{"CPU us":>8} {"Heap B":>8} {"Disc":>5}')
+
+        for rate in rates:
+            for size in sizes:
+                result = run_once(args, rate, size, profile)
+                if result is None:
+                    print(f'{rate:>6} {size:>6} no result')
+                    results.append({'rate': rate, 'size': size, 'error': 'no result'})
+                    failed = True
+                    continue
+
+                results.append(result)
+                print(f'{rate:>6} {size:>6} {result["acked"]:>4}/{result["count"]:<4} '
+                      f'{result["msgs_per_sec"]:>9} {result["p50_us"]:>9} '
+                      f'{result["p99_us"]:>9} {result["cpu_us_per_msg"]:>8} '
+                      f'{result["peak_heap_bytes"]:>8} {result.get("disconnects", 0):>5}')
+    finally:
+        if proxy:
+            proxy.stop()
+        stop_broker()
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump({
+            'timestamp': datetime.datetime.now(datetime.timezone.utc).isoformat(),
+            'revision': git_describe(os.path.dirname(os.path.abspath(__file__))),
+            'broker': args.broker,
+            'profile': args.profile,
+            'network': profile,
+            'results': results,
+        }, f, indent=2)
+        f.write('\n')
+
+    print(f'Results written to {args.output}')
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+
+"""Static memory budget report per module.
+
+Parses the linker map file of a build and attributes every input section that comes from the
+sample's own sources to the module directory that the source file lives in: src/common, or
+src/modules/<module>. Thread stacks defined with K_THREAD_DEFINE() and K_THREAD_STACK_DEFINE()
+live in .noinit sections and are reported separately, as they usually dominate RAM usage.
+zbus channel storage is attributed to src/common, where the channels are defined.
+
+The result is compared against a budget file, which holds the RAM and ROM budget of each
+module for each build configuration. The script fails if a module uses more than its budget, or
+if the configuration or one of its modules has no budget, so that no build goes unchecked.
+Run with --update to write the current usage to the budget file, after a change that reduces
+memory usage or when an increase is intended.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+# Output section header: "name  0xaddr  0xsize [load address 0xlma]"
+OUTPUT_SECTION_RE = re.compile(
+    r'^(?P<name>[^\s*]\S*)?\s+0x(?P<addr>[0-9a-f]+)\s+0x(?P<size>[0-9a-f]+)'
+    r'(?:\s+load address 0x(?P<lma>[0-9a-f]+))?\s*$')
+# Input section: " name  0xaddr  0xsize  object"
+INPUT_SECTION_RE = re.compile(
+    r'^ (?P<name>\S+)?\s+0x(?P<addr>[0-9a-f]+)\s+0x(?P<size>[0-9a-f]+)\s+(?P<obj>\S.*)$')
+MEMORY_REGION_RE = re.compile(
+    r'^(?P<name>\S+)\s+0x(?P<origin>[0-9a-f]+)\s+0x(?P<length>[0-9a-f]+)')
+# Object file name, as a member of an archive or on its own
+OBJECT_RE = re.compile(r'(?:\(|/|^)(?P<source>[^/()]+)\.obj\)?$')
+
+MODULES_PREFIX = 'modules'
+
+
+class Usage:
+    def __init__(self):
+        self.rom = 0
+        self.ram = 0
+        self.stacks = 0
+        self.symbols = {}
+
+    def add(self, section, ram, rom, stack):
+        self.ram += ram
+        self.rom += rom
+        if stack:
+            self.stacks += ram
+
+        self.symbols[section] = self.symbols.get(section, 0) + max(ram, rom)
+
+
+def source_modules(source_dir):
+    """Map source file names to the module directory that they belong to."""
+    modules = {}
+
+    for root, _, files in os.walk(source_dir):
+        rel = os.path.relpath(root, source_dir).split(os.sep)
+
+        if rel[0] == MODULES_PREFIX and len(rel) > 1:
+            module = rel[1]
+        else:
+            module = rel[0]
+
+        for name in files:
+            if name.endswith('.c'):
+                if name in modules and modules[name] != module:
+                    sys.exit(f'Source file name {name} is not unique, cannot attribute it')
+                modules[name] = module
+
+    return modules
+
+
+def memory_regions(lines):
+    """Parse the memory configuration table at the start of the map file."""
+    regions = []
+    in_table = False
+
+    for line in lines:
+        if line.startswith('Memory Configuration'):
+            in_table = True
+            continue
+        if line.startswith('Linker script and memory map'):
+            break
+        if not in_table:
+            continue
+
+        match = MEMORY_REGION_RE.match(line)
+        if match and match['name'] not in ('Name', '*default*'):
+            origin = int(match['origin'], 16)
+            regions.append((match['name'], origin, origin + int(match['length'], 16)))
+
+    return regions
+
+
+def region_kind(regions, addr):
+    """Return 'rom' or 'ram' for an address, or None if it is in neither."""
+    for name, start, end in regions:
+        if start <= addr < end:
+            upper = name.upper()
+            if 'FLASH' in upper or 'ROM' in upper:
+                return 'rom'
+            if 'RAM' in upper:
+                return 'ram'
+            return None
+
+    return None
+
+
+def parse_map(map_file, modules):
+    with open(map_file, encoding='utf-8', errors='replace') as f:
+        lines = f.read().splitlines()
+
+    regions = memory_regions(lines)
+    if not regions:
+        sys.exit(f'No memory configuration found in {map_file}')
+
+    usage = {}
+    output_lma = None
+    output_discarded = False
+    pending_output = None
+    pending_input = None
+    in_map = False
+
+    for line in lines:
+        if line.startswith('Linker script and memory map'):
+            in_map = True
+            continue
+        if not in_map or not line.strip():
+            continue
+
+        # Output section names that are too long are on a line of their own. The
+        # /DISCARD/ section has no address, so it only ever appears like this.
+        if not line.startswith(' ') and len(line.split()) == 1:
+            pending_output = line.strip()
+            output_discarded = pending_output == '/DISCARD/'
+            continue
+
+        match = OUTPUT_SECTION_RE.match(line)
+        if match and (not line.startswith(' ') or pending_output):
+            name = pending_output if line.startswith(' ') else match['name']
+            output_discarded = name == '/DISCARD/'
+            output_lma = int(match['lma'], 16) if match['lma'] else None
+            pending_output = None
+            continue
+
+        # Input section names that are too long are on a line of their own
+        stripped = line.strip()
+        if line.startswith(' ') and not line.startswith('  ') and len(line.split()) == 1:
+            pending_input = stripped
+            continue
+
+        match = INPUT_SECTION_RE.match(line)
+        if not match:
+            pending_input = None
+            continue
+
+        section = match['name'] or pending_input
+        pending_input = None
+
+        if output_discarded or not section or section.startswith('*'):
+            continue
+
+        size = int(match['size'], 16)
+        obj = OBJECT_RE.search(match['obj'].strip())
+        if size == 0 or not obj or obj['source'] not in modules:
+            continue
+
+        module = modules[obj['source']]
+        kind = region_kind(regions, int(match['addr'], 16))
+        ram = size if kind == 'ram' else 0
+        rom = size if kind == 'rom' else 0
+
+        # Initialized data is also stored in flash, to be copied to RAM at boot
+        if kind == 'ram' and output_lma is not None and region_kind(regions, output_lma) == 'rom':
+            rom = size
+
+        stack = section.startswith('.noinit') or section.startswith('.user_stacks')
+
+        usage.setdefault(module, Usage()).add(section, ram, rom, stack)
+
+    return usage
+
+
+def report(usage, budget, details):
+    failed = False
+
+    print(f'{"Module":<20} {"ROM":>8} {"RAM":>8} {"Stacks":>8} {"ROM budget":>11} '
+          f'{"RAM budget":>11}')
+
+    for module in sorted(usage):
+        entry = usage[module]
+        limits = budget.get(module) if budget is not None else None
+        status = ''
+
+        if limits is None:
+            rom_budget = ram_budget = '-'
+            if budget is not None:
+                status = 'NO BUDGET'
+                failed = True
+        else:
+            rom_budget = str(limits['rom'])
+            ram_budget = str(limits['ram'])
+            over = []
+            if entry.rom > limits['rom']:
+                over.append(f'ROM +{entry.rom - limits["rom"]}')
+            if entry.ram > limits['ram']:
+                over.append(f'RAM +{entry.ram - limits["ram"]}')
+            if over:
+                status = 'OVER BUDGET: ' + ', '.join(over)
+                failed = True
+            elif entry.rom < limits['rom'] or entry.ram < limits['ram']:
+                status = 'below budget, consider --update'
+
+        print(f'{module:<20} {entry.rom:>8} {entry.ram:>8} {entry.stacks:>8} {rom_budget:>11} '
+              f'{ram_budget:>11}  {status}'.rstrip())
+
+        if details:
+            for section, size in sorted(entry.symbols.items(), key=lambda s: -s[1])[:details]:
+                print(f'    {size:>8}  {section}')
+
+    print(f'{"Total":<20} {sum(u.rom for u in usage.values()):>8} '
+          f'{sum(u.ram for u in usage.values()):>8} '
+          f'{sum(u.stacks for u in usage.values()):>8}')
+
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--map', required=True, help='Linker map file, zephyr.map')
+    parser.add_argument('--source', required=True, help='Source directory of the sample, src/')
+    parser.add_argument('--budget', required=True, help='Budget file')
+    parser.add_argument('--config', required=True,
+                        help='Build configuration that the budget applies to')
+    parser.add_argument('--update', action='store_true',
+                        help='Write the current usage to the budget file')
+    parser.add_argument('--details', type=int, default=0, metavar='N',
+                        help='List the N largest sections of each module')
+    args = parser.parse_args()
+
+    usage = parse_map(args.map, source_modules(args.source))
+
+    try:
+        with open(args.budget, encoding='utf-8') as f:
+            budget_file = json.load(f)
+    except FileNotFoundError:
+        budget_file = {'configurations': {}}
+
+    configurations = budget_file.setdefault('configurations', {})
+
+    if args.update:
+        configurations[args.config] = {
+            module: {'rom': entry.rom, 'ram': entry.ram}
+            for module, entry in sorted(usage.items())
+        }
+
+        with open(args.budget, 'w', encoding='utf-8') as f:
+            json.dump(budget_file, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+        print(f'Budget for {args.config} updated in {args.budget}')
+
+    budget = configurations.get(args.config)
+
+    print(f'Memory usage of {args.config} in bytes')
+    failed = report(usage, budget, args.details)
+
+    if budget is None:
+        print(f'No budget for {args.config}, run with --update to add it')
+        return 1
+    if failed:
+        print('Memory budget exceeded, or a module has no budget')
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
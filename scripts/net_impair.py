@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+
+"""Network impairment proxy for the Native Sim build.
+
+Forwards TCP connections from the Native Sim build to the broker, and delays the data in each
+direction to emulate a slower link:
+
+  latency    One-way delay added to all data, in milliseconds
+  jitter     Random extra one-way delay, up to this many milliseconds
+  loss       Segments lost, in percent. A TCP connection hides the loss but not its cost, so a
+             lost segment is delivered after a retransmission timeout instead
+  bandwidth  Link rate in kbit/s, 0 for unlimited. Data queues up behind earlier data
+
+Data is read in segments of at most MSS bytes, and delivered in order. The random generator
+is seeded, so that runs can be reproduced. Outages of the device's link are scheduled in the
+device with CONFIG_MQTT_SAMPLE_LINK_OUTAGE, so that they are reported to the application with
+NET_EVENT_L4_DISCONNECTED. The outage fields of a profile are passed to the Native Sim build on
+the command line, see outage_args().
+
+Profiles are read from net_profiles.json next to this script. The proxy can be run on its own,
+or started by scripts/bench_native_sim.py with --profile.
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import random
+import sys
+import threading
+
+MSS = 1460
+
+# Lowest retransmission timeout of the Zephyr and Linux TCP stacks, in milliseconds
+MIN_RTO_MS = 200
+
+PROFILES_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'net_profiles.json')
+
+PROFILE_DEFAULTS = {
+    'latency_ms': 0,
+    'jitter_ms': 0,
+    'loss_percent': 0.0,
+    'bandwidth_kbps': 0,
+    'outage_start_s': 0,
+    'outage_period_s': 0,
+    'outage_duration_s': 0,
+}
+
+
+def load_profile(name, profiles_file=PROFILES_FILE):
+    with open(profiles_file, encoding='utf-8') as f:
+        profiles = json.load(f)
+
+    if name not in profiles:
+        sys.exit(f'Unknown profile {name}, available: {", ".join(sorted(profiles))}')
+
+    profile = dict(PROFILE_DEFAULTS)
+    profile.update(profiles[name])
+
+    return profile
+
+
+def outage_args(profile):
+    """Command line options that schedule the profile's link outages in the Native Sim build."""
+    if not profile['outage_start_s']:
+        return []
+
+    return [f'--outage-start={profile["outage_start_s"]}',
+            f'--outage-period={profile["outage_period_s"]}',
+            f'--outage-duration={profile["outage_duration_s"]}']
+
+
+class Link:
+    """One direction of a connection. Schedules the delivery time of each segment."""
+
+    def __init__(self, profile, rng):
+        self.profile = profile
+        self.rng = rng
+        self.link_free = 0.0
+        self.last_delivery = 0.0
+
+    def delivery_time(self, now, size):
+        latency = self.profile['latency_ms'] / 1000
+        jitter = self.profile['jitter_ms'] / 1000
+        bandwidth = self.profile['bandwidth_kbps'] * 1000
+
+        # Serialization delay, segments queue up behind each other on the link
+        start = max(now, self.link_free)
+        self.link_free = start + (size * 8 / bandwidth if bandwidth else 0)
+
+        delivery = self.link_free + latency + self.rng.uniform(0, jitter)
+
+        if self.rng.random() * 100 < self.profile['loss_percent']:
+            delivery += max(MIN_RTO_MS / 1000, 2 * latency)
+
+        # TCP delivers in order
+        self.last_delivery = max(self.last_delivery, delivery)
+
+        return self.last_delivery
+
+
+class ImpairProxy:
+    def __init__(self, listen_host, listen_port, target_host, target_port, profile, seed=1):
+        self.listen_host = listen_host
+        self.listen_port = listen_port
+        self.target_host = target_host
+        self.target_port = target_port
+        self.profile = profile
+        self.rng = random.Random(seed)
+        self.connections = 0
+        self.loop = None
+        self.server = None
+        self.ready = threading.Event()
+
+    async def pump(self, reader, writer, link):
+        loop = asyncio.get_running_loop()
+        queue = asyncio.Queue()
+
+        async def deliver():
+            while True:
+                when, data = await queue.get()
+                if data is None:
+                    break
+                await asyncio.sleep(max(0, when - loop.time()))
+                writer.write(data)
+                await writer.drain()
+
+        delivery = asyncio.create_task(deliver())
+
+        try:
+            while True:
+                data = await reader.read(MSS)
+                if not data:
+                    break
+                await queue.put((link.delivery_time(loop.time(), len(data)), data))
+        except ConnectionError:
+            pass
+        finally:
+            await queue.put((0, None))
+            try:
+                await delivery
+            except ConnectionError:
+                pass
+            writer.close()
+
+    async def handle(self, client_reader, client_writer):
+        self.connections += 1
+
+        try:
+            broker_reader, broker_writer = await asyncio.open_connection(self.target_host,
+                                                                         self.target_port)
+        except OSError:
+            client_writer.close()
+            return
+
+        await asyncio.gather(
+            self.pump(client_reader, broker_writer, Link(self.profile, self.rng)),
+            self.pump(broker_reader, client_writer, Link(self.profile, self.rng)))
+
+    def run(self):
+        self.loop = asyncio.new_event_loop()
+        self.server = self.loop.run_until_complete(
+            asyncio.start_server(self.handle, self.listen_host, self.listen_port))
+        self.ready.set()
+        self.loop.run_forever()
+
+    def start(self):
+        threading.Thread(target=self.run, daemon=True).start()
+        self.ready.wait()
+
+    def stop(self):
+        self.loop.call_soon_threadsafe(self.server.close)
+        self.loop.call_soon_threadsafe(self.loop.stop)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--listen', default='0.0.0.0:1883', help='Address to listen on')
+    parser.add_argument('--target', default='127.0.0.1:1884', help='Broker address')
+    parser.add_argument('--profile', help='Profile from net_profiles.json')
+    parser.add_argument('--profiles-file', default=PROFILES_FILE)
+    parser.add_argument('--latency', type=int, help='One-way latency in ms')
+    parser.add_argument('--jitter', type=int, help='One-way jitter in ms')
+    parser.add_argument('--loss', type=float, help='Segment loss in percent')
+    parser.add_argument('--bandwidth', type=int, help='Link rate in kbit/s, 0 for unlimited')
+    parser.add_argument('--seed', type=int, default=1, help='Random seed')
+    args = parser.parse_args()
+
+    profile = load_profile(args.profile, args.profiles_file) if args.profile else \
+        dict(PROFILE_DEFAULTS)
+
+    for key, value in (('latency_ms', args.latency), ('jitter_ms', args.jitter),
+                       ('loss_percent', args.loss), ('bandwidth_kbps', args.bandwidth)):
+        if value is not None:
+            profile[key] = value
+
+    listen_host, listen_port = args.listen.rsplit(':', 1)
+    target_host, target_port = args.target.rsplit(':', 1)
+
+    proxy = ImpairProxy(listen_host, int(listen_port), target_host, int(target_port), profile,
+                        args.seed)
+
+    print(f'Forwarding {args.listen} to {args.target} with {profile}')
+    if outage_args(profile):
+        print(f'Run the Native Sim build with {" ".join(outage_args(profile))}')
+
+    try:
+        proxy.run()
+    except KeyboardInterrupt:
+        pass
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BENCH_CLOCK_H_
+#define _BENCH_CLOCK_H_
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* Implemented on the host side of the native simulator, see bench_clock_native.c. */
+uint64_t bench_clock_host_ns(void);
+uint64_t bench_clock_host_cpu_ns(void);
+uint32_t bench_host_max_rss_kb(void);
+#endif
+
+/** @brief Get a timestamp suitable for timing short, CPU bound code sections.
+ *
+ *	   On Native Sim, code runs in zero simulated time, so the host's monotonic clock is
+ *	   used instead of the kernel cycle counter. On hardware the kernel cycle counter is used.
+ *
+ *  @return Timestamp in nanoseconds. Only the difference between two timestamps is meaningful.
+ */
+static inline uint64_t bench_clock_ns(void)
+{
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	return bench_clock_host_ns();
+#elif defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+	return k_cyc_to_ns_floor64(k_cycle_get_64());
+#else
+	return k_cyc_to_ns_floor64(k_cycle_get_32());
+#endif
+}
+
+/** @brief Get the CPU time consumed so far, excluding idle time.
+ *
+ *	   On Native Sim, this is the CPU time of the simulator process on the host. On hardware
+ *	   it requires CONFIG_SCHED_THREAD_USAGE_ALL, and is otherwise always 0.
+ *
+ *  @return CPU time in nanoseconds. Only the difference between two readings is meaningful.
+ */
+static inline uint64_t bench_clock_cpu_ns(void)
+{
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	return bench_clock_host_cpu_ns();
+#elif defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+	k_thread_runtime_stats_t stats;
+
+	if (k_thread_runtime_stats_all_get(&stats)) {
+		return 0;
+	}
+
+	return k_cyc_to_ns_floor64(stats.total_cycles);
+#else
+	return 0;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BENCH_CLOCK_H_ */
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* This file is compiled as part of the native simulator runner and has access to the
+ * host's C library.
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+
+uint64_t bench_clock_host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t bench_clock_host_cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t bench_host_max_rss_kb(void)
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage)) {
+		return 0;
+	}
+
+	return (uint32_t)usage.ru_maxrss;
+}
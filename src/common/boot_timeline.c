@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/math_extras.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "message_channel.h"
+#include "boot_timeline.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(boot_timeline, CONFIG_MQTT_SAMPLE_BOOT_TIMELINE_LOG_LEVEL);
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+	[BOOT_PHASE_APP_INIT] = "app_init",
+	[BOOT_PHASE_CLIENT_ID] = "client_id",
+	[BOOT_PHASE_PROVISIONING_INIT] = "prov_init",
+	[BOOT_PHASE_IF_UP] = "if_up",
+	[BOOT_PHASE_PROVISIONED] = "provisioned",
+	[BOOT_PHASE_DHCP_BOUND] = "dhcp_bound",
+	[BOOT_PHASE_L4_CONNECTED] = "l4_connected",
+	[BOOT_PHASE_BROKER_RESOLVED] = "resolved",
+	[BOOT_PHASE_MQTT_CONNECT] = "mqtt_connect",
+	[BOOT_PHASE_CONNACK] = "connack",
+	[BOOT_PHASE_FIRST_PUBLISH] = "first_publish",
+	[BOOT_PHASE_FIRST_PUBACK] = "first_puback",
+};
+
+/* Phases that each phase waits for. A phase that was not reached is replaced by the phases
+ * that it waits for, and a phase that was reached after the one waiting for it, such as a DHCP
+ * lease bound after L4 connectivity with fast rejoin, is not part of its path.
+ */
+static const uint16_t phase_deps[BOOT_PHASE_COUNT] = {
+	[BOOT_PHASE_APP_INIT] = 0,
+	[BOOT_PHASE_CLIENT_ID] = BIT(BOOT_PHASE_APP_INIT),
+	[BOOT_PHASE_PROVISIONING_INIT] = BIT(BOOT_PHASE_APP_INIT),
+	[BOOT_PHASE_IF_UP] = BIT(BOOT_PHASE_PROVISIONING_INIT),
+	[BOOT_PHASE_PROVISIONED] = BIT(BOOT_PHASE_IF_UP),
+	[BOOT_PHASE_DHCP_BOUND] = BIT(BOOT_PHASE_PROVISIONED),
+	[BOOT_PHASE_L4_CONNECTED] = BIT(BOOT_PHASE_PROVISIONED) | BIT(BOOT_PHASE_DHCP_BOUND),
+	[BOOT_PHASE_BROKER_RESOLVED] = BIT(BOOT_PHASE_L4_CONNECTED),
+	[BOOT_PHASE_MQTT_CONNECT] = BIT(BOOT_PHASE_BROKER_RESOLVED) | BIT(BOOT_PHASE_CLIENT_ID),
+	[BOOT_PHASE_CONNACK] = BIT(BOOT_PHASE_MQTT_CONNECT),
+	[BOOT_PHASE_FIRST_PUBLISH] = BIT(BOOT_PHASE_CONNACK),
+	[BOOT_PHASE_FIRST_PUBACK] = BIT(BOOT_PHASE_FIRST_PUBLISH),
+};
+
+/* Time that each phase was first reached at, in microseconds of uptime, 0 if not reached */
+static uint64_t phase_us[BOOT_PHASE_COUNT];
+
+/* Phases on the critical path, from the first to the first PUBACK */
+static enum boot_phase path[BOOT_PHASE_COUNT];
+static size_t path_len;
+
+/* Protects the timestamps. Phases may be marked from any context. */
+static struct k_spinlock lock;
+
+static void publish_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, as the first PUBACK is marked from the MQTT thread */
+static K_WORK_DEFINE(publish_work, publish_work_fn);
+
+/* Reached phase that a phase waited for the longest, or BOOT_PHASE_COUNT if there is none */
+static enum boot_phase predecessor_get(enum boot_phase phase)
+{
+	uint32_t pending = phase_deps[phase];
+	enum boot_phase latest = BOOT_PHASE_COUNT;
+
+	while (pending) {
+		enum boot_phase dep = u32_count_trailing_zeros(pending);
+
+		pending &= ~BIT(dep);
+
+		if ((phase_us[dep] == 0) || (phase_us[dep] > phase_us[phase])) {
+			/* Not waited for, look at what it waits for itself */
+			pending |= phase_deps[dep];
+			continue;
+		}
+
+		if ((latest == BOOT_PHASE_COUNT) || (phase_us[dep] > phase_us[latest])) {
+			latest = dep;
+		}
+	}
+
+	return latest;
+}
+
+static void path_compute(void)
+{
+	enum boot_phase phase = BOOT_PHASE_FIRST_PUBACK;
+
+	path_len = 0;
+
+	while (phase != BOOT_PHASE_COUNT) {
+		path[path_len++] = phase;
+		phase = predecessor_get(phase);
+	}
+
+	/* Collected from the end, reversed to run from the start */
+	for (size_t i = 0; i < path_len / 2; i++) {
+		enum boot_phase tmp = path[i];
+
+		path[i] = path[path_len - 1 - i];
+		path[path_len - 1 - i] = tmp;
+	}
+}
+
+static void publish_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	size_t longest = 0;
+	uint64_t longest_us = 0;
+
+	path_compute();
+
+	for (size_t i = 1; i < path_len; i++) {
+		uint64_t step_us = phase_us[path[i]] - phase_us[path[i - 1]];
+
+		if (step_us > longest_us) {
+			longest = i;
+			longest_us = step_us;
+		}
+	}
+
+	LOG_INF("First PUBACK %u ms after boot",
+		(uint32_t)(phase_us[BOOT_PHASE_FIRST_PUBACK] / USEC_PER_MSEC));
+
+	for (size_t i = 0; i < path_len; i++) {
+		LOG_INF("%-14s %8u ms  +%u ms", phase_names[path[i]],
+			(uint32_t)(phase_us[path[i]] / USEC_PER_MSEC),
+			i ? (uint32_t)((phase_us[path[i]] - phase_us[path[i - 1]]) /
+				       USEC_PER_MSEC) : 0);
+	}
+
+	if (longest) {
+		LOG_INF("Longest step on the critical path: %s to %s, %u ms",
+			phase_names[path[longest - 1]], phase_names[path[longest]],
+			(uint32_t)(longest_us / USEC_PER_MSEC));
+	}
+
+	printk("BOOT_TIMELINE {\"us\":{");
+	for (size_t i = 0, n = 0; i < BOOT_PHASE_COUNT; i++) {
+		if (phase_us[i]) {
+			printk("%s\"%s\":%llu", n++ ? "," : "", phase_names[i], phase_us[i]);
+		}
+	}
+	printk("},\"path\":[");
+	for (size_t i = 0; i < path_len; i++) {
+		printk("%s\"%s\"", i ? "," : "", phase_names[path[i]]);
+	}
+	printk("]}\n");
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+	int err;
+	struct telemetry telemetry;
+	size_t len = snprintk(telemetry.string, sizeof(telemetry.string), "boot");
+
+	/* Critical path only, in milliseconds, as much of it as fits */
+	for (size_t i = 0; i < path_len; i++) {
+		int ret = snprintk(&telemetry.string[len], sizeof(telemetry.string) - len,
+				   " %s:%u", phase_names[path[i]],
+				   (uint32_t)(phase_us[path[i]] / USEC_PER_MSEC));
+
+		if ((ret < 0) || (ret >= (sizeof(telemetry.string) - len))) {
+			telemetry.string[len] = '\0';
+			break;
+		}
+
+		len += ret;
+	}
+
+	err = telemetry_publish(&telemetry, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("telemetry_publish, error: %d", err);
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+}
+
+void boot_timeline_mark(enum boot_phase phase)
+{
+	uint64_t now_us = k_ticks_to_us_floor64(k_uptime_ticks());
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	bool first = (phase_us[phase] == 0);
+
+	if (first) {
+		/* 0 is kept to mean not reached */
+		phase_us[phase] = MAX(now_us, 1);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	if (first && (phase == BOOT_PHASE_FIRST_PUBACK)) {
+		k_work_submit(&publish_work);
+	}
+}
+
+uint64_t boot_timeline_get(enum boot_phase phase)
+{
+	return phase_us[phase];
+}
+
+const char *boot_timeline_phase_name(enum boot_phase phase)
+{
+	return phase_names[phase];
+}
+
+static int boot_timeline_init(void)
+{
+	boot_timeline_mark(BOOT_PHASE_APP_INIT);
+
+	return 0;
+}
+
+/* First of the application level initialization */
+SYS_INIT(boot_timeline_init, APPLICATION, 0);
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+		if (phase_us[i] == 0) {
+			shell_print(sh, "%-14s %12s", phase_names[i], "-");
+			continue;
+		}
+
+		shell_print(sh, "%-14s %9llu us", phase_names[i], phase_us[i]);
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_boot_timeline,
+	SHELL_CMD(show, NULL, "Show the time that each boot phase was reached at", cmd_show),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(boot_timeline, &sub_boot_timeline, "Boot timeline", NULL);
+#endif /* CONFIG_SHELL */
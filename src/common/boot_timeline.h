@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BOOT_TIMELINE_H_
+#define _BOOT_TIMELINE_H_
+
+/* Boot timeline, from reset to the first PUBACK.
+ *
+ * Each module timestamps the boot phases that it completes. Only the first time that a phase
+ * is reached is recorded, so that reconnections do not overwrite the boot. When the first
+ * PUBACK is received, the critical path is computed by walking back from it through the phases
+ * that each phase waits for, taking the one that completed last. The timeline is then logged,
+ * printed as a BOOT_TIMELINE line, and published once on the telemetry channel.
+ *
+ * When CONFIG_MQTT_SAMPLE_BOOT_TIMELINE is disabled, the functions are empty.
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Boot phases, in the order that they complete on a provisioned boot without fast rejoin. */
+enum boot_phase {
+	/* Application level initialization started */
+	BOOT_PHASE_APP_INIT,
+	/* Client ID and topics computed */
+	BOOT_PHASE_CLIENT_ID,
+	/* Stored credentials checked, and the provisioning library initialized if needed */
+	BOOT_PHASE_PROVISIONING_INIT,
+	/* Network interface up */
+	BOOT_PHASE_IF_UP,
+	/* Credentials available, from storage or from provisioning */
+	BOOT_PHASE_PROVISIONED,
+	/* DHCPv4 lease bound */
+	BOOT_PHASE_DHCP_BOUND,
+	/* L4 connectivity, reported by the connection manager */
+	BOOT_PHASE_L4_CONNECTED,
+	/* Broker hostname resolved */
+	BOOT_PHASE_BROKER_RESOLVED,
+	/* MQTT connection attempt started, including the TCP and TLS handshakes */
+	BOOT_PHASE_MQTT_CONNECT,
+	/* CONNACK received */
+	BOOT_PHASE_CONNACK,
+	/* First message published */
+	BOOT_PHASE_FIRST_PUBLISH,
+	/* First PUBACK received, which completes the timeline */
+	BOOT_PHASE_FIRST_PUBACK,
+
+	BOOT_PHASE_COUNT,
+};
+
+#if defined(CONFIG_MQTT_SAMPLE_BOOT_TIMELINE)
+
+/** @brief Timestamp a boot phase, if it has not been reached before. May be called from any
+ *	   context. Marking BOOT_PHASE_FIRST_PUBACK completes the timeline and publishes it.
+ *
+ *  @param phase Phase that was completed.
+ */
+void boot_timeline_mark(enum boot_phase phase);
+
+/** @brief Get the time that a phase was reached at.
+ *
+ *  @param phase Phase.
+ *
+ *  @return Microseconds of uptime, 0 if the phase was not reached.
+ */
+uint64_t boot_timeline_get(enum boot_phase phase);
+
+/** @brief Get the name of a phase. */
+const char *boot_timeline_phase_name(enum boot_phase phase);
+
+#else
+
+static inline void boot_timeline_mark(enum boot_phase phase)
+{
+	ARG_UNUSED(phase);
+}
+
+#endif /* CONFIG_MQTT_SAMPLE_BOOT_TIMELINE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BOOT_TIMELINE_H_ */
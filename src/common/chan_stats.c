@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "bench_clock.h"
+#include "chan_stats.h"
+
+/* Recent publishes kept per channel, for observers that do not queue the publish time with
+ * the message.
+ */
+#define PUB_HISTORY 16
+
+/* Channels per observer that the position in the publish history is kept for */
+#define OBS_CHANNELS 8
+
+struct chan_entry {
+	const struct zbus_channel *chan;
+
+	/* Times of the recent publishes, indexed by publish sequence number */
+	uint64_t pub_ns[PUB_HISTORY];
+	uint32_t pub_seq;
+
+	uint32_t pub_count;
+	uint32_t pub_timeouts;
+	uint32_t pub_errors;
+	uint32_t latency_max_us;
+	uint32_t histogram[CHAN_STATS_BUCKETS];
+};
+
+struct obs_entry {
+	const struct zbus_observer *obs;
+	const char *name;
+
+	/* Start of the message being handled */
+	uint64_t begin_ns;
+
+	/* Sequence number of the next publish to be handled, per channel */
+	struct {
+		const struct chan_entry *chan;
+		uint32_t seq;
+	} cursors[OBS_CHANNELS];
+
+	uint32_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t queue_hwm;
+};
+
+static struct chan_entry chans[CONFIG_MQTT_SAMPLE_CHAN_STATS_MAX_CHANNELS];
+static struct obs_entry observers[CONFIG_MQTT_SAMPLE_CHAN_STATS_MAX_OBSERVERS];
+
+/* Protects the tables. Publishes may happen from any context. */
+static struct k_spinlock lock;
+
+/* Must be called with lock held. Returns NULL if the table is full. */
+static struct chan_entry *chan_entry_get(const struct zbus_channel *chan)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(chans); i++) {
+		if (chans[i].chan == chan) {
+			return &chans[i];
+		}
+
+		if (chans[i].chan == NULL) {
+			chans[i].chan = chan;
+			return &chans[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with lock held. Returns NULL if the table is full. */
+static struct obs_entry *obs_entry_get(const struct zbus_observer *obs, const char *name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(observers); i++) {
+		if (observers[i].obs == obs) {
+			return &observers[i];
+		}
+
+		if ((observers[i].obs == NULL) && name) {
+			observers[i].obs = obs;
+			observers[i].name = name;
+			return &observers[i];
+		}
+	}
+
+	return NULL;
+}
+
+static size_t bucket_get(uint32_t latency_us)
+{
+	size_t bucket = (latency_us == 0) ? 0 : (32 - __builtin_clz(latency_us));
+
+	return MIN(bucket, CHAN_STATS_BUCKETS - 1);
+}
+
+/* Replaces zbus_chan_pub() through the linker's --wrap option. */
+int __real_zbus_chan_pub(const struct zbus_channel *chan, const void *msg, k_timeout_t timeout);
+
+int __wrap_zbus_chan_pub(const struct zbus_channel *chan, const void *msg, k_timeout_t timeout)
+{
+	struct chan_entry *entry;
+	k_spinlock_key_t key;
+	int err;
+
+	/* The publish time is recorded first, as observers may run before the publish returns. */
+	key = k_spin_lock(&lock);
+	entry = chan_entry_get(chan);
+	if (entry) {
+		entry->pub_ns[entry->pub_seq % PUB_HISTORY] = bench_clock_ns();
+		entry->pub_seq++;
+	}
+	k_spin_unlock(&lock, key);
+
+	err = __real_zbus_chan_pub(chan, msg, timeout);
+
+	if (entry) {
+		key = k_spin_lock(&lock);
+		entry->pub_count++;
+		if (err == -EAGAIN) {
+			entry->pub_timeouts++;
+		} else if (err) {
+			entry->pub_errors++;
+		}
+		k_spin_unlock(&lock, key);
+	}
+
+	return err;
+}
+
+uint64_t chan_stats_pub_ns(const struct zbus_channel *chan)
+{
+	uint64_t pub_ns = 0;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct chan_entry *entry = chan_entry_get(chan);
+
+	if (entry && entry->pub_seq) {
+		pub_ns = entry->pub_ns[(entry->pub_seq - 1) % PUB_HISTORY];
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return pub_ns;
+}
+
+/* Time of the publish that an observer handles next on a channel. Observers handle the
+ * publishes of a channel in order, so each keeps its position in the channel's history. A
+ * position that is further behind than the observer's queue is deep, because a message was
+ * dropped, or that is ahead of the publishes, is moved back into range. Must be called with
+ * lock held.
+ */
+static uint64_t history_pub_ns(struct obs_entry *obs_entry, const struct chan_entry *chan_entry,
+			       uint32_t depth)
+{
+	uint32_t oldest = chan_entry->pub_seq - MIN(MIN(depth, PUB_HISTORY), chan_entry->pub_seq);
+	uint32_t newest = chan_entry->pub_seq - 1;
+	uint32_t seq;
+
+	for (size_t i = 0; i < ARRAY_SIZE(obs_entry->cursors); i++) {
+		if ((obs_entry->cursors[i].chan != chan_entry) &&
+		    (obs_entry->cursors[i].chan != NULL)) {
+			continue;
+		}
+
+		/* Unknown on the first message, taken as the oldest that can be queued */
+		if (obs_entry->cursors[i].chan == NULL) {
+			obs_entry->cursors[i].chan = chan_entry;
+			obs_entry->cursors[i].seq = oldest;
+		}
+
+		seq = CLAMP(obs_entry->cursors[i].seq, oldest, newest);
+		obs_entry->cursors[i].seq = seq + 1;
+
+		return chan_entry->pub_ns[seq % PUB_HISTORY];
+	}
+
+	/* Observer on more channels than positions are kept for, the latest publish is used */
+	return chan_entry->pub_ns[newest % PUB_HISTORY];
+}
+
+void chan_stats_dispatch_begin(const struct zbus_observer *obs, const char *name,
+			       const struct zbus_channel *chan, uint32_t depth, uint64_t pub_ns)
+{
+	uint64_t now = bench_clock_ns();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct chan_entry *chan_entry = chan_entry_get(chan);
+	struct obs_entry *obs_entry = obs_entry_get(obs, name);
+
+	if ((pub_ns == 0) && chan_entry && chan_entry->pub_seq) {
+		if (obs_entry) {
+			pub_ns = history_pub_ns(obs_entry, chan_entry, depth);
+		} else {
+			pub_ns = chan_entry->pub_ns[(chan_entry->pub_seq - 1) % PUB_HISTORY];
+		}
+	}
+
+	if (chan_entry && pub_ns) {
+		uint32_t latency_us = (now - pub_ns) / NSEC_PER_USEC;
+
+		chan_entry->histogram[bucket_get(latency_us)]++;
+		chan_entry->latency_max_us = MAX(chan_entry->latency_max_us, latency_us);
+	}
+
+	if (obs_entry) {
+		obs_entry->begin_ns = now;
+		obs_entry->queue_hwm = MAX(obs_entry->queue_hwm, depth);
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+void chan_stats_dispatch_end(const struct zbus_observer *obs)
+{
+	uint64_t now = bench_clock_ns();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct obs_entry *entry = obs_entry_get(obs, NULL);
+
+	if (entry && entry->begin_ns) {
+		uint64_t elapsed = now - entry->begin_ns;
+
+		entry->count++;
+		entry->total_ns += elapsed;
+		entry->max_ns = MAX(entry->max_ns, elapsed);
+		entry->begin_ns = 0;
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+void chan_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	/* Keep the table slots, so that the tables keep their order. */
+	for (size_t i = 0; i < ARRAY_SIZE(chans); i++) {
+		chans[i].pub_count = 0;
+		chans[i].pub_timeouts = 0;
+		chans[i].pub_errors = 0;
+		chans[i].latency_max_us = 0;
+		memset(chans[i].histogram, 0, sizeof(chans[i].histogram));
+	}
+
+	/* Positions in the publish histories are kept, as the histories are */
+	for (size_t i = 0; i < ARRAY_SIZE(observers); i++) {
+		struct obs_entry entry = {
+			.obs = observers[i].obs,
+			.name = observers[i].name,
+		};
+
+		memcpy(entry.cursors, observers[i].cursors, sizeof(entry.cursors));
+		observers[i] = entry;
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(sh, "%-20s %8s %8s %8s %12s", "Channel", "Pubs", "Timeouts", "Errors",
+		    "Max lat (us)");
+
+	for (size_t i = 0; i < ARRAY_SIZE(chans); i++) {
+		struct chan_entry entry;
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		entry = chans[i];
+		k_spin_unlock(&lock, key);
+
+		if (entry.chan == NULL) {
+			break;
+		}
+
+		shell_print(sh, "%-20s %8u %8u %8u %12u", zbus_chan_name(entry.chan),
+			    entry.pub_count, entry.pub_timeouts, entry.pub_errors,
+			    entry.latency_max_us);
+
+		/* Latency histogram, only buckets that have counts */
+		for (size_t b = 0; b < CHAN_STATS_BUCKETS; b++) {
+			if (entry.histogram[b] == 0) {
+				continue;
+			}
+
+			if (b == (CHAN_STATS_BUCKETS - 1)) {
+				shell_print(sh, "  >= %u us: %u", (uint32_t)BIT(b - 1),
+					    entry.histogram[b]);
+			} else {
+				shell_print(sh, "  <  %u us: %u", (uint32_t)BIT(b),
+					    entry.histogram[b]);
+			}
+		}
+	}
+
+	shell_print(sh, "");
+	shell_print(sh, "%-20s %8s %12s %12s %10s", "Observer", "Handled", "Avg (us)", "Max (us)",
+		    "Queue HWM");
+
+	for (size_t i = 0; i < ARRAY_SIZE(observers); i++) {
+		struct obs_entry entry;
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		entry = observers[i];
+		k_spin_unlock(&lock, key);
+
+		if (entry.obs == NULL) {
+			break;
+		}
+
+		shell_print(sh, "%-20s %8u %12u %12u %10u", entry.name, entry.count,
+			    entry.count ? (uint32_t)(entry.total_ns / entry.count / NSEC_PER_USEC) : 0,
+			    (uint32_t)(entry.max_ns / NSEC_PER_USEC), entry.queue_hwm);
+	}
+
+	return 0;
+}
+
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	chan_stats_reset();
+	shell_print(sh, "Channel statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_chan_stats,
+	SHELL_CMD(show, NULL, "Show channel and observer statistics", cmd_show),
+	SHELL_CMD(reset, NULL, "Reset channel and observer statistics", cmd_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(chan_stats, &sub_chan_stats, "zbus channel statistics", NULL);
+#endif /* CONFIG_SHELL */
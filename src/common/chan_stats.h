@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _CHAN_STATS_H_
+#define _CHAN_STATS_H_
+
+/* Per-channel zbus instrumentation.
+ *
+ * Publishes are counted and timed by wrapping zbus_chan_pub() at link time, so publishers are
+ * not changed. Observers defined with EXECUTOR_MODULE_DEFINE() report when they start and
+ * finish handling a message. For each channel this gives the publish count, publish failures
+ * and timeouts, and a histogram of the latency from the publish until an observer starts
+ * handling it. For each observer it gives the time spent in the handler and the high-water
+ * mark of its message queue. The statistics are dumped with the "chan_stats" shell command.
+ *
+ * The hooks are wrapped in IF_ENABLED(CONFIG_MQTT_SAMPLE_CHAN_STATS, ...) by their callers, so
+ * nothing is compiled in when the instrumentation is disabled.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of latency histogram buckets. Bucket 0 counts latencies below 1 us, bucket n latencies
+ * from 2^(n-1) up to 2^n us, and the last bucket everything above.
+ */
+#define CHAN_STATS_BUCKETS 16
+
+/** @brief Get the time of the publish in progress on a channel. Called by a listener, which
+ *	   runs within the publish, to record the time with the message that it queues.
+ *
+ *  @param chan Channel.
+ *
+ *  @return Publish time in nanoseconds, 0 if the channel is not recorded.
+ */
+uint64_t chan_stats_pub_ns(const struct zbus_channel *chan);
+
+/** @brief Called by an observer when it starts handling a message.
+ *
+ *  @param obs Observer.
+ *  @param name Name of the observer.
+ *  @param chan Channel that the message was published on.
+ *  @param depth Number of messages in the observer's queue, including this one.
+ *  @param pub_ns Time that the message was published at, from chan_stats_pub_ns(). 0 if
+ *		  the observer does not know it, in which case it is looked up in the channel's
+ *		  recent publishes, in the order that the observer handles them.
+ */
+void chan_stats_dispatch_begin(const struct zbus_observer *obs, const char *name,
+			       const struct zbus_channel *chan, uint32_t depth, uint64_t pub_ns);
+
+/** @brief Called by an observer when it has finished handling a message. */
+void chan_stats_dispatch_end(const struct zbus_observer *obs);
+
+/** @brief Reset all statistics. */
+void chan_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHAN_STATS_H_ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "executor.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(executor, CONFIG_MQTT_SAMPLE_EXECUTOR_LOG_LEVEL);
+
+#if defined(CONFIG_MQTT_SAMPLE_EXECUTOR)
+
+K_THREAD_STACK_ARRAY_DEFINE(executor_stacks, CONFIG_MQTT_SAMPLE_EXECUTOR_QUEUE_COUNT,
+			    CONFIG_MQTT_SAMPLE_EXECUTOR_STACK_SIZE);
+
+static struct k_work_q executor_queues[CONFIG_MQTT_SAMPLE_EXECUTOR_QUEUE_COUNT];
+
+struct k_work_q *executor_queue_get(uint8_t queue)
+{
+	__ASSERT_NO_MSG(queue < ARRAY_SIZE(executor_queues));
+
+	return &executor_queues[queue];
+}
+
+static void module_init_work_fn(struct k_work *work)
+{
+	struct executor_module *module = CONTAINER_OF(work, struct executor_module, init_work);
+	int err;
+
+	err = module->init();
+	if (err) {
+		LOG_ERR("%s init, error: %d", module->name, err);
+		return;
+	}
+
+	module->ready = true;
+}
+
+static void module_work_fn(struct k_work *work)
+{
+	struct executor_module *module = CONTAINER_OF(work, struct executor_module, work);
+	struct executor_msg msg;
+
+	/* Handle one message per run, so that modules sharing a queue take turns. */
+	if (k_msgq_get(module->msgq, &msg, K_NO_WAIT)) {
+		return;
+	}
+
+	/* Messages for a module that failed to initialize are dropped, as they were when the
+	 * module's thread exited.
+	 */
+	if (module->ready) {
+		IF_ENABLED(CONFIG_MQTT_SAMPLE_CHAN_STATS,
+			   (chan_stats_dispatch_begin(module->obs, module->name, msg.chan,
+						      k_msgq_num_used_get(module->msgq) + 1,
+						      msg.pub_ns);))
+		module->handler(msg.chan);
+		IF_ENABLED(CONFIG_MQTT_SAMPLE_CHAN_STATS, (chan_stats_dispatch_end(module->obs);))
+	}
+
+	if (k_msgq_num_used_get(module->msgq)) {
+		(void)k_work_submit_to_queue(&executor_queues[module->queue], work);
+	}
+}
+
+void executor_module_post(struct executor_module *module, const struct zbus_channel *chan)
+{
+	int err;
+	struct executor_msg msg = {
+		.chan = chan,
+	};
+
+	/* Listeners run within the publish, so this is the time of this message's publish */
+	IF_ENABLED(CONFIG_MQTT_SAMPLE_CHAN_STATS, (msg.pub_ns = chan_stats_pub_ns(chan);))
+
+	/* Called from the publisher's context, so the message is dropped rather than waiting
+	 * for room in the queue.
+	 */
+	err = k_msgq_put(module->msgq, &msg, K_NO_WAIT);
+	if (err) {
+		atomic_val_t dropped = atomic_inc(&module->dropped) + 1;
+
+		LOG_WRN("%s message queue full, dropping message on %s, %ld dropped in total",
+			module->name, zbus_chan_name(chan), (long)dropped);
+		return;
+	}
+
+	(void)k_work_submit_to_queue(&executor_queues[module->queue], &module->work);
+}
+
+void executor_module_start(struct executor_module *module)
+{
+	k_work_init(&module->init_work, module_init_work_fn);
+	k_work_init(&module->work, module_work_fn);
+
+	(void)k_work_submit_to_queue(&executor_queues[module->queue], &module->init_work);
+}
+
+static int executor_init(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(executor_queues); i++) {
+		char name[sizeof("executor") + 2];
+		struct k_work_queue_config cfg = {
+			.name = name,
+		};
+
+		snprintk(name, sizeof(name), "executor%zu", i);
+
+		k_work_queue_init(&executor_queues[i]);
+		k_work_queue_start(&executor_queues[i], executor_stacks[i],
+				   K_THREAD_STACK_SIZEOF(executor_stacks[i]),
+				   CONFIG_MQTT_SAMPLE_EXECUTOR_THREAD_PRIORITY, &cfg);
+	}
+
+	LOG_DBG("%d executor queues started, %d B stack each",
+		CONFIG_MQTT_SAMPLE_EXECUTOR_QUEUE_COUNT, CONFIG_MQTT_SAMPLE_EXECUTOR_STACK_SIZE);
+
+	return 0;
+}
+
+/* Started before the modules, which are initialized at EXECUTOR_MODULE_INIT_PRIORITY. */
+SYS_INIT(executor_init, APPLICATION, 0);
+
+#endif /* CONFIG_MQTT_SAMPLE_EXECUTOR */
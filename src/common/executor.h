@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _EXECUTOR_H_
+#define _EXECUTOR_H_
+
+/* Module event loops.
+ *
+ * A module defines its event loop with EXECUTOR_MODULE_DEFINE(), giving an init function and a
+ * handler that is called for each message on the channels that the module observes. By default
+ * this expands to a zbus subscriber and a dedicated thread, as modules have always been defined.
+ * With CONFIG_MQTT_SAMPLE_EXECUTOR, it expands to a zbus listener that queues the channel and
+ * runs the handler on one of the shared executor work queues instead, so that idle modules do
+ * not each reserve a thread stack. Handlers run to completion and must not wait for messages.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "chan_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Module initialization function. If it fails, the module handles no messages.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ */
+typedef int (*executor_init_t)(void);
+
+/** @brief Module handler, called for each message on the channels that the module observes.
+ *
+ *  @param chan Channel that the message was published on.
+ */
+typedef void (*executor_handler_t)(const struct zbus_channel *chan);
+
+#if defined(CONFIG_MQTT_SAMPLE_EXECUTOR)
+
+/* Initialization priority of modules run by the executor. The executor queues are started at
+ * priority 0 of the same level.
+ */
+#define EXECUTOR_MODULE_INIT_PRIORITY CONFIG_APPLICATION_INIT_PRIORITY
+
+/** @brief Message queued for a module run by the executor. */
+struct executor_msg {
+	const struct zbus_channel *chan;
+
+#if defined(CONFIG_MQTT_SAMPLE_CHAN_STATS)
+	/* Publish time, so that the latency is measured from the publish of this message */
+	uint64_t pub_ns;
+#endif /* CONFIG_MQTT_SAMPLE_CHAN_STATS */
+};
+
+/** @brief State of a module run by the executor. Defined by EXECUTOR_MODULE_DEFINE(). */
+struct executor_module {
+	const char *name;
+	const struct zbus_observer *obs;
+	uint8_t queue;
+	struct k_msgq *msgq;
+	executor_init_t init;
+	executor_handler_t handler;
+	struct k_work init_work;
+	struct k_work work;
+	/* Messages dropped as the message queue was full */
+	atomic_t dropped;
+	bool ready;
+};
+
+/** @brief Get an executor work queue. Modules use it in place of a private work queue.
+ *
+ *  @param queue Index of the queue, less than CONFIG_MQTT_SAMPLE_EXECUTOR_QUEUE_COUNT.
+ */
+struct k_work_q *executor_queue_get(uint8_t queue);
+
+/** @brief Queue a message for a module. Called from the module's zbus listener. */
+void executor_module_post(struct executor_module *module, const struct zbus_channel *chan);
+
+/** @brief Schedule initialization of a module on its executor queue. */
+void executor_module_start(struct executor_module *module);
+
+#define EXECUTOR_MODULE_DEFINE(_name, _msgq_size, _init, _handler, _stack_size, _prio, _queue)	\
+	BUILD_ASSERT((_queue) < CONFIG_MQTT_SAMPLE_EXECUTOR_QUEUE_COUNT);			\
+	K_MSGQ_DEFINE(_name##_msgq, sizeof(struct executor_msg), _msgq_size,			\
+		      __alignof__(struct executor_msg));					\
+	ZBUS_OBS_DECLARE(_name);								\
+	static struct executor_module _name##_module = {					\
+		.name = STRINGIFY(_name),							\
+		.obs = &_name,									\
+		.queue = (_queue),								\
+		.msgq = &_name##_msgq,								\
+		.init = _init,									\
+		.handler = _handler,								\
+	};											\
+	static void _name##_listener_cb(const struct zbus_channel *chan)			\
+	{											\
+		executor_module_post(&_name##_module, chan);					\
+	}											\
+	ZBUS_LISTENER_DEFINE(_name, _name##_listener_cb);					\
+	static int _name##_module_start(void)							\
+	{											\
+		executor_module_start(&_name##_module);						\
+		return 0;									\
+	}											\
+	SYS_INIT(_name##_module_start, APPLICATION, EXECUTOR_MODULE_INIT_PRIORITY)
+
+#else
+
+#define EXECUTOR_MODULE_DEFINE(_name, _msgq_size, _init, _handler, _stack_size, _prio, _queue)	\
+	ZBUS_SUBSCRIBER_DEFINE(_name, _msgq_size);						\
+	static void _name##_task(void)								\
+	{											\
+		const struct zbus_channel *chan;						\
+												\
+		if (_init()) {									\
+			return;									\
+		}										\
+												\
+		while (!zbus_sub_wait(&_name, &chan, K_FOREVER)) {				\
+			IF_ENABLED(CONFIG_MQTT_SAMPLE_CHAN_STATS,				\
+				   (chan_stats_dispatch_begin(&_name, STRINGIFY(_name), chan,	\
+					k_msgq_num_used_get(_name.queue) + 1, 0);))		\
+			_handler(chan);								\
+			IF_ENABLED(CONFIG_MQTT_SAMPLE_CHAN_STATS,				\
+				   (chan_stats_dispatch_end(&_name);))				\
+		}										\
+	}											\
+	K_THREAD_DEFINE(_name##_task_id, _stack_size, _name##_task, NULL, NULL, NULL,		\
+			_prio, 0, 0)
+
+#endif /* CONFIG_MQTT_SAMPLE_EXECUTOR */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EXECUTOR_H_ */
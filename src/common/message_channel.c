@@ -26,6 +26,29 @@ ZBUS_CHAN_DEFINE(PAYLOAD_CHAN,
 		 ZBUS_MSG_INIT(0)
 );
 
+/* Available while the last payload published with payload_publish() has been read */
+static K_SEM_DEFINE(payload_read_sem, 1, 1);
+
+int payload_publish(const struct payload *payload, k_timeout_t timeout)
+{
+	int err;
+
+	/* As for telemetry, a payload that is not read in time is published anyway */
+	(void)k_sem_take(&payload_read_sem, timeout);
+
+	err = zbus_chan_pub(&PAYLOAD_CHAN, payload, timeout);
+	if (err) {
+		k_sem_give(&payload_read_sem);
+	}
+
+	return err;
+}
+
+void payload_consumed(void)
+{
+	k_sem_give(&payload_read_sem);
+}
+
 ZBUS_CHAN_DEFINE(NETWORK_CHAN,
 		 enum network_status,
 		 NULL,
@@ -35,7 +58,7 @@ ZBUS_CHAN_DEFINE(NETWORK_CHAN,
 );
 
 ZBUS_CHAN_DEFINE(FATAL_ERROR_CHAN,
-		 int,
+		 struct fatal_error,
 		 NULL,
 		 NULL,
 		 ZBUS_OBSERVERS(error),
@@ -50,6 +73,16 @@ ZBUS_CHAN_DEFINE(PROVISIONING_CHAN,
 		 ZBUS_MSG_INIT(0)
 );
 
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+ZBUS_CHAN_DEFINE(STREAM_CHAN,
+		 int,
+		 NULL,
+		 NULL,
+		 ZBUS_OBSERVERS(transport),
+		 ZBUS_MSG_INIT(0)
+);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
 ZBUS_CHAN_DEFINE(TRANSPORT_CHAN,
 		 enum transport_status,
 		 NULL,
@@ -57,3 +90,58 @@ ZBUS_CHAN_DEFINE(TRANSPORT_CHAN,
 		 ZBUS_OBSERVERS(IF_ENABLED(CONFIG_MQTT_SAMPLE_LED, (ui))),
 		 ZBUS_MSG_INIT(0)
 );
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+ZBUS_CHAN_DEFINE(TELEMETRY_CHAN,
+		 struct telemetry,
+		 NULL,
+		 NULL,
+		 ZBUS_OBSERVERS(transport),
+		 ZBUS_MSG_INIT(0)
+);
+
+/* Available while the last line published on the telemetry channel has been read */
+static K_SEM_DEFINE(telemetry_read_sem, 1, 1);
+
+int telemetry_publish(const struct telemetry *telemetry, k_timeout_t timeout)
+{
+	int err;
+
+	/* On a timeout the line is published anyway. The transport module then reads the
+	 * channel again, so a lost notification does not hold telemetry back for good.
+	 */
+	(void)k_sem_take(&telemetry_read_sem, timeout);
+
+	err = zbus_chan_pub(&TELEMETRY_CHAN, telemetry, timeout);
+	if (err) {
+		k_sem_give(&telemetry_read_sem);
+	}
+
+	return err;
+}
+
+void telemetry_consumed(void)
+{
+	k_sem_give(&telemetry_read_sem);
+}
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+
+#if defined(CONFIG_MQTT_SAMPLE_POWER_SAVE)
+ZBUS_CHAN_DEFINE(POWER_SAVE_CHAN,
+		 enum power_save_mode,
+		 NULL,
+		 NULL,
+		 ZBUS_OBSERVERS_EMPTY,
+		 ZBUS_MSG_INIT(0)
+);
+#endif /* CONFIG_MQTT_SAMPLE_POWER_SAVE */
+
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY)
+ZBUS_CHAN_DEFINE(LINK_QUALITY_CHAN,
+		 struct link_quality,
+		 NULL,
+		 NULL,
+		 ZBUS_OBSERVERS(IF_ENABLED(CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING, (transport))),
+		 ZBUS_MSG_INIT(0)
+);
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY */
@@ -18,17 +18,68 @@ extern "C" {
 /** @brief Macro used to send a message on the FATAL_ERROR_CHANNEL.
  *	   The message will be handled in the error module.
  */
-#define SEND_FATAL_ERROR()									\
-	int not_used = -1;									\
-	if (zbus_chan_pub(&FATAL_ERROR_CHAN, &not_used, K_SECONDS(10))) {			\
+#define SEND_FATAL_ERROR() SEND_FATAL_ERROR_CODE(-1)
+
+/** @brief Macro used to send a message on the FATAL_ERROR_CHANNEL, with the error code that
+ *	   caused it. The message will be handled in the error module.
+ */
+#define SEND_FATAL_ERROR_CODE(_err)								\
+	struct fatal_error fatal_error_msg = {							\
+		.file = __FILE__,								\
+		.line = __LINE__,								\
+		.err = (_err),									\
+	};											\
+	if (zbus_chan_pub(&FATAL_ERROR_CHAN, &fatal_error_msg, K_SECONDS(10))) {		\
 		LOG_ERR("Sending a message on the fatal error channel failed, rebooting");	\
 		LOG_PANIC();									\
 		IF_ENABLED(CONFIG_REBOOT, (sys_reboot(0)));					\
 	}
 
+struct fatal_error {
+	/* Source file and line that the error was reported from */
+	const char *file;
+	int line;
+
+	/* Error code, -1 if not given */
+	int err;
+};
+
+#if defined(CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE)
+/* Time series that a sampled value belongs to */
+enum payload_series {
+	/* Not part of a time series, such as button presses */
+	PAYLOAD_SERIES_NONE,
+
+	/* Uptime sampled by the sampler module, or replayed in its place */
+	PAYLOAD_SERIES_UPTIME,
+};
+#endif /* CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE */
+
 struct payload {
 	char string[CONFIG_MQTT_SAMPLE_PAYLOAD_CHANNEL_STRING_MAX_SIZE];
+
+#if defined(CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE)
+	/* Time series of the sample, PAYLOAD_SERIES_NONE if the payload is not a sample */
+	uint8_t series;
+
+	/* Sample timestamp in milliseconds of uptime */
+	int64_t timestamp;
+
+	/* Sampled value that the string was built from */
+	double value;
+#endif /* CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE */
+
+#if defined(CONFIG_MQTT_SAMPLE_MSG_TRACE)
+	/* ID of the message's latency trace, see msg_trace.h */
+	uint16_t trace_id;
+#endif /* CONFIG_MQTT_SAMPLE_MSG_TRACE */
+};
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+struct telemetry {
+	char string[CONFIG_MQTT_SAMPLE_TELEMETRY_CHANNEL_STRING_MAX_SIZE];
 };
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
 
 enum network_status {
 	NETWORK_DISCONNECTED,
@@ -46,7 +97,84 @@ enum transport_status {
 	TRANSPORT_CONNECTED,
 };
 
-ZBUS_CHAN_DECLARE(TRIGGER_CHAN, PAYLOAD_CHAN, NETWORK_CHAN, FATAL_ERROR_CHAN, PROVISIONING_CHAN, TRANSPORT_CHAN);
+#if defined(CONFIG_MQTT_SAMPLE_POWER_SAVE)
+enum power_save_mode {
+	/* Power save disabled, lowest latency */
+	POWER_SAVE_ACTIVE,
+	/* Power save, waking up at every DTIM beacon */
+	POWER_SAVE_DTIM,
+	/* Power save, waking up at the listen interval */
+	POWER_SAVE_LISTEN_INTERVAL,
+	POWER_SAVE_MODE_COUNT,
+};
+#endif /* CONFIG_MQTT_SAMPLE_POWER_SAVE */
+
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY)
+enum link_quality_level {
+	/* Not connected, or not sampled yet */
+	LINK_QUALITY_UNKNOWN,
+	/* Below the poor threshold, sending is slow and costly */
+	LINK_QUALITY_POOR,
+	LINK_QUALITY_FAIR,
+	/* Above the good threshold */
+	LINK_QUALITY_GOOD,
+};
+
+struct link_quality {
+	/* Wi-Fi RSSI, or LTE RSRP, in dBm. Valid unless the level is unknown. */
+	int16_t dbm;
+	enum link_quality_level level;
+};
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY */
+
+ZBUS_CHAN_DECLARE(TRIGGER_CHAN, PAYLOAD_CHAN, NETWORK_CHAN, FATAL_ERROR_CHAN, PROVISIONING_CHAN,
+		  TRANSPORT_CHAN);
+
+/** @brief Publish a payload on the payload channel, once the transport module has read the
+ *	   previous payload. Used by producers that publish back to back, as the channel holds
+ *	   a single message. If the previous payload is not read within the timeout, the
+ *	   payload is published anyway.
+ *
+ *  @param payload Payload.
+ *  @param timeout Time to wait for the previous payload to be read, and for the publish.
+ *
+ *  @return 0 If successful. Otherwise, the error returned by zbus_chan_pub().
+ */
+int payload_publish(const struct payload *payload, k_timeout_t timeout);
+
+/** @brief Called by the transport module once it has read a payload from the payload channel. */
+void payload_consumed(void);
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+ZBUS_CHAN_DECLARE(TELEMETRY_CHAN);
+
+/** @brief Publish a line on the telemetry channel, once the transport module has read the
+ *	   previous line. The channel holds a single message, so lines published back to back
+ *	   would otherwise overwrite each other before they are read. If the previous line is
+ *	   not read within the timeout, the line is published anyway.
+ *
+ *  @param telemetry Telemetry line.
+ *  @param timeout Time to wait for the previous line to be read, and for the publish.
+ *
+ *  @return 0 If successful. Otherwise, the error returned by zbus_chan_pub().
+ */
+int telemetry_publish(const struct telemetry *telemetry, k_timeout_t timeout);
+
+/** @brief Called by the transport module once it has read a line from the telemetry channel. */
+void telemetry_consumed(void);
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+ZBUS_CHAN_DECLARE(STREAM_CHAN);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+#if defined(CONFIG_MQTT_SAMPLE_POWER_SAVE)
+ZBUS_CHAN_DECLARE(POWER_SAVE_CHAN);
+#endif /* CONFIG_MQTT_SAMPLE_POWER_SAVE */
+
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY)
+ZBUS_CHAN_DECLARE(LINK_QUALITY_CHAN);
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY */
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#if defined(CONFIG_TRACING_CTF)
+#include <zephyr/tracing/tracing.h>
+#endif /* CONFIG_TRACING_CTF */
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "bench_clock.h"
+#include "msg_trace.h"
+
+struct trace {
+	/* Trace ID, 0 if the slot is unused */
+	uint16_t id;
+
+	/* MQTT message ID, valid once the message is sent */
+	uint16_t message_id;
+
+	/* Timestamp of each stage, 0 if the stage was not reached */
+	uint64_t ts_ns[MSG_TRACE_STAGE_COUNT];
+};
+
+struct stage_stats {
+	uint32_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t histogram[MSG_TRACE_BUCKETS];
+};
+
+static const char *const stage_names[MSG_TRACE_STAGE_COUNT] = {
+	[MSG_TRACE_TRIGGER] = "trigger",
+	[MSG_TRACE_SAMPLED] = "sampled",
+	[MSG_TRACE_PUBLISHED] = "published",
+	[MSG_TRACE_DEQUEUED] = "dequeued",
+	[MSG_TRACE_SENT] = "sent",
+	[MSG_TRACE_ACKED] = "acked",
+};
+
+/* Traces are placed in the ring by their ID, so a trace is overwritten by the trace started
+ * CONFIG_MQTT_SAMPLE_MSG_TRACE_RING_SIZE traces later.
+ */
+static struct trace ring[CONFIG_MQTT_SAMPLE_MSG_TRACE_RING_SIZE];
+
+/* Time spent in each stage, measured from the previous stage that was reached. The entry for
+ * MSG_TRACE_TRIGGER holds the end-to-end latency instead.
+ */
+static struct stage_stats stats[MSG_TRACE_STAGE_COUNT];
+
+/* Number of traces that reached each stage */
+static uint32_t reached[MSG_TRACE_STAGE_COUNT];
+
+static uint16_t next_id = 1;
+
+static msg_trace_done_cb_t done_cb;
+
+/* Protects the ring and the statistics. Stages may be marked from any context. */
+static struct k_spinlock lock;
+
+static size_t bucket_get(uint64_t latency_ns)
+{
+	uint32_t latency_us = MIN(latency_ns / NSEC_PER_USEC, UINT32_MAX);
+	size_t bucket = (latency_us == 0) ? 0 : (32 - __builtin_clz(latency_us));
+
+	return MIN(bucket, MSG_TRACE_BUCKETS - 1);
+}
+
+static void stats_add(struct stage_stats *entry, uint64_t elapsed_ns)
+{
+	entry->count++;
+	entry->total_ns += elapsed_ns;
+	entry->max_ns = MAX(entry->max_ns, elapsed_ns);
+	entry->histogram[bucket_get(elapsed_ns)]++;
+}
+
+/* Must be called with lock held. Returns NULL if the trace has been overwritten. */
+static struct trace *trace_get(uint16_t id)
+{
+	struct trace *trace = &ring[id % ARRAY_SIZE(ring)];
+
+	return ((id != 0) && (trace->id == id)) ? trace : NULL;
+}
+
+static void event_emit(uint16_t id, enum msg_trace_stage stage, uint64_t ts_ns)
+{
+#if defined(CONFIG_TRACING_CTF)
+	sys_trace_named_event(stage_names[stage], id, (uint32_t)(ts_ns / NSEC_PER_USEC));
+#else
+	ARG_UNUSED(id);
+	ARG_UNUSED(stage);
+	ARG_UNUSED(ts_ns);
+#endif /* CONFIG_TRACING_CTF */
+}
+
+uint16_t msg_trace_start(void)
+{
+	uint64_t now = bench_clock_ns();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint16_t id = next_id;
+	struct trace *trace = &ring[id % ARRAY_SIZE(ring)];
+
+	next_id = (next_id == UINT16_MAX) ? 1 : (next_id + 1);
+
+	*trace = (struct trace){ .id = id };
+	trace->ts_ns[MSG_TRACE_TRIGGER] = now;
+	reached[MSG_TRACE_TRIGGER]++;
+
+	k_spin_unlock(&lock, key);
+
+	event_emit(id, MSG_TRACE_TRIGGER, now);
+
+	return id;
+}
+
+void msg_trace_mark(uint16_t id, enum msg_trace_stage stage)
+{
+	uint64_t now = bench_clock_ns();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct trace *trace = trace_get(id);
+
+	if (trace) {
+		trace->ts_ns[stage] = now;
+		reached[stage]++;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	if (trace) {
+		event_emit(id, stage, now);
+	}
+}
+
+void msg_trace_sent(uint16_t id, uint16_t message_id)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct trace *trace = trace_get(id);
+
+	if (trace) {
+		trace->message_id = message_id;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	msg_trace_mark(id, MSG_TRACE_SENT);
+}
+
+void msg_trace_acked(uint16_t message_id)
+{
+	uint64_t now = bench_clock_ns();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct trace *trace = NULL;
+	uint64_t latency_ns;
+	uint64_t prev_ns;
+	uint16_t id;
+
+	for (size_t i = 0; i < ARRAY_SIZE(ring); i++) {
+		if ((ring[i].id != 0) && ring[i].ts_ns[MSG_TRACE_SENT] &&
+		    (ring[i].message_id == message_id) && !ring[i].ts_ns[MSG_TRACE_ACKED]) {
+			trace = &ring[i];
+			break;
+		}
+	}
+
+	if (trace == NULL) {
+		/* Not a traced message, or its trace was overwritten */
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	id = trace->id;
+	trace->ts_ns[MSG_TRACE_ACKED] = now;
+	reached[MSG_TRACE_ACKED]++;
+
+	/* Stages that were not reached, for example the sampler for button presses, are
+	 * attributed to the next stage that was. A stage that was reached before the previous
+	 * one, as when the transport module preempts the publisher, counts as taking no time.
+	 */
+	prev_ns = trace->ts_ns[MSG_TRACE_TRIGGER];
+
+	for (size_t stage = MSG_TRACE_TRIGGER + 1; stage < MSG_TRACE_STAGE_COUNT; stage++) {
+		uint64_t ts_ns = trace->ts_ns[stage];
+
+		if (ts_ns == 0) {
+			continue;
+		}
+
+		stats_add(&stats[stage], (ts_ns > prev_ns) ? (ts_ns - prev_ns) : 0);
+		prev_ns = MAX(prev_ns, ts_ns);
+	}
+
+	latency_ns = now - trace->ts_ns[MSG_TRACE_TRIGGER];
+	stats_add(&stats[MSG_TRACE_TRIGGER], latency_ns);
+
+	k_spin_unlock(&lock, key);
+
+	event_emit(id, MSG_TRACE_ACKED, now);
+
+	if (done_cb) {
+		done_cb(id, latency_ns);
+	}
+}
+
+void msg_trace_done_cb_set(msg_trace_done_cb_t cb)
+{
+	done_cb = cb;
+}
+
+uint32_t msg_trace_reached_get(enum msg_trace_stage stage)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint32_t count = reached[stage];
+
+	k_spin_unlock(&lock, key);
+
+	return count;
+}
+
+const char *msg_trace_stage_name(enum msg_trace_stage stage)
+{
+	return stage_names[stage];
+}
+
+void msg_trace_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memset(ring, 0, sizeof(ring));
+	memset(stats, 0, sizeof(stats));
+	memset(reached, 0, sizeof(reached));
+
+	k_spin_unlock(&lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(sh, "%-12s %8s %8s %12s %12s", "Stage", "Reached", "Count", "Avg (us)",
+		    "Max (us)");
+
+	for (size_t stage = 0; stage < MSG_TRACE_STAGE_COUNT; stage++) {
+		struct stage_stats entry;
+		uint32_t entry_reached;
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		entry = stats[stage];
+		entry_reached = reached[stage];
+		k_spin_unlock(&lock, key);
+
+		shell_print(sh, "%-12s %8u %8u %12u %12u",
+			    (stage == MSG_TRACE_TRIGGER) ? "end-to-end" : stage_names[stage],
+			    entry_reached, entry.count,
+			    entry.count ? (uint32_t)(entry.total_ns / entry.count / NSEC_PER_USEC) : 0,
+			    (uint32_t)(entry.max_ns / NSEC_PER_USEC));
+
+		/* Latency histogram, only buckets that have counts */
+		for (size_t b = 0; b < MSG_TRACE_BUCKETS; b++) {
+			if (entry.histogram[b] == 0) {
+				continue;
+			}
+
+			if (b == (MSG_TRACE_BUCKETS - 1)) {
+				shell_print(sh, "  >= %u us: %u", (uint32_t)BIT(b - 1),
+					    entry.histogram[b]);
+			} else {
+				shell_print(sh, "  <  %u us: %u", (uint32_t)BIT(b),
+					    entry.histogram[b]);
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_recent(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(sh, "Stage times in us from the trigger, - if not reached");
+
+	for (size_t i = 0; i < ARRAY_SIZE(ring); i++) {
+		struct trace trace;
+		char line[MSG_TRACE_STAGE_COUNT * 12];
+		size_t len = 0;
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		trace = ring[i];
+		k_spin_unlock(&lock, key);
+
+		if (trace.id == 0) {
+			continue;
+		}
+
+		for (size_t stage = MSG_TRACE_TRIGGER + 1; stage < MSG_TRACE_STAGE_COUNT; stage++) {
+			if (trace.ts_ns[stage] == 0) {
+				len += snprintk(&line[len], sizeof(line) - len, " %10s", "-");
+			} else {
+				len += snprintk(&line[len], sizeof(line) - len, " %10u",
+						(uint32_t)((trace.ts_ns[stage] -
+							    trace.ts_ns[MSG_TRACE_TRIGGER]) /
+							   NSEC_PER_USEC));
+			}
+		}
+
+		shell_print(sh, "#%-5u%s", trace.id, line);
+	}
+
+	return 0;
+}
+
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	msg_trace_reset();
+	shell_print(sh, "Message traces reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_msg_trace,
+	SHELL_CMD(show, NULL, "Show per-stage latency statistics", cmd_show),
+	SHELL_CMD(recent, NULL, "Show the traces in the ring", cmd_recent),
+	SHELL_CMD(reset, NULL, "Clear traces and statistics", cmd_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(msg_trace, &sub_msg_trace, "Per-message latency tracing", NULL);
+#endif /* CONFIG_SHELL */
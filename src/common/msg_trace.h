@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _MSG_TRACE_H_
+#define _MSG_TRACE_H_
+
+/* Per-message latency tracing.
+ *
+ * A trace is started when a message is triggered, by the trigger module or a button press, and
+ * its ID travels with the message on the trigger and payload channels. Each module that handles
+ * the message timestamps its stage. When the broker acknowledges the publish, the time spent in
+ * each stage is added to a per-stage latency histogram, which is dumped with the "msg_trace"
+ * shell command. The last traces are kept in a fixed ring. With CONFIG_TRACING_CTF, each stage
+ * is also emitted as a named trace event, so that traces can be viewed with the CTF tools.
+ *
+ * When CONFIG_MQTT_SAMPLE_MSG_TRACE is disabled, the functions are empty and trace IDs are 0.
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Stages of a message, in the order that they are passed. */
+enum msg_trace_stage {
+	/* Trigger fired or button pressed */
+	MSG_TRACE_TRIGGER,
+	/* Payload built by the sampler */
+	MSG_TRACE_SAMPLED,
+	/* zbus_chan_pub() on the payload channel returned. The transport module may already
+	 * have received the payload, if it runs at a higher priority than the publisher.
+	 */
+	MSG_TRACE_PUBLISHED,
+	/* Payload received by the transport module */
+	MSG_TRACE_DEQUEUED,
+	/* mqtt_helper_publish() returned */
+	MSG_TRACE_SENT,
+	/* PUBACK received */
+	MSG_TRACE_ACKED,
+
+	MSG_TRACE_STAGE_COUNT,
+};
+
+/* Number of latency histogram buckets. Bucket 0 counts latencies below 1 us, bucket n latencies
+ * from 2^(n-1) up to 2^n us, and the last bucket everything above.
+ */
+#define MSG_TRACE_BUCKETS 24
+
+#if defined(CONFIG_MQTT_SAMPLE_MSG_TRACE)
+
+/** @brief Called when a trace completes, that is when the PUBACK for its message is received.
+ *
+ *  @param id Trace ID.
+ *  @param latency_ns Time from the MSG_TRACE_TRIGGER stage to the PUBACK.
+ */
+typedef void (*msg_trace_done_cb_t)(uint16_t id, uint64_t latency_ns);
+
+/** @brief Set the function called when a trace completes. Called from the context that
+ *	   receives PUBACKs, so it must not block.
+ *
+ *  @param cb Callback, or NULL to remove it.
+ */
+void msg_trace_done_cb_set(msg_trace_done_cb_t cb);
+
+/** @brief Start a trace and timestamp its MSG_TRACE_TRIGGER stage.
+ *
+ *  @return ID of the trace. Never 0.
+ */
+uint16_t msg_trace_start(void);
+
+/** @brief Timestamp a stage of a trace. Traces that have been overwritten in the ring, and
+ *	   trace ID 0, are ignored.
+ *
+ *  @param id Trace ID.
+ *  @param stage Stage that the message has reached.
+ */
+void msg_trace_mark(uint16_t id, enum msg_trace_stage stage);
+
+/** @brief Timestamp the MSG_TRACE_SENT stage of a trace, and bind it to the MQTT message ID
+ *	   that its PUBACK will carry.
+ *
+ *  @param id Trace ID.
+ *  @param message_id MQTT message ID of the publish.
+ */
+void msg_trace_sent(uint16_t id, uint16_t message_id);
+
+/** @brief Timestamp the MSG_TRACE_ACKED stage of the trace bound to an MQTT message ID, and
+ *	   add the trace to the statistics.
+ *
+ *  @param message_id MQTT message ID of the PUBACK.
+ */
+void msg_trace_acked(uint16_t message_id);
+
+/** @brief Get the number of traces that reached a stage, including traces that were not
+ *	   acknowledged. Used to compute the throughput of each stage.
+ *
+ *  @param stage Stage.
+ *
+ *  @return Number of traces that reached the stage since the last reset.
+ */
+uint32_t msg_trace_reached_get(enum msg_trace_stage stage);
+
+/** @brief Get the name of a stage. */
+const char *msg_trace_stage_name(enum msg_trace_stage stage);
+
+/** @brief Clear the ring and the statistics. */
+void msg_trace_reset(void);
+
+#else
+
+static inline uint16_t msg_trace_start(void)
+{
+	return 0;
+}
+
+static inline void msg_trace_mark(uint16_t id, enum msg_trace_stage stage)
+{
+	ARG_UNUSED(id);
+	ARG_UNUSED(stage);
+}
+
+static inline void msg_trace_sent(uint16_t id, uint16_t message_id)
+{
+	ARG_UNUSED(id);
+	ARG_UNUSED(message_id);
+}
+
+static inline void msg_trace_acked(uint16_t message_id)
+{
+	ARG_UNUSED(message_id);
+}
+
+static inline void msg_trace_reset(void)
+{
+}
+
+#endif /* CONFIG_MQTT_SAMPLE_MSG_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MSG_TRACE_H_ */
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/sys_heap.h>
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#include <posix_native_task.h>
+#include <posix_board_if.h>
+#include <cmdline.h>
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+#include "message_channel.h"
+#include "msg_trace.h"
+#include "bench_clock.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(bench, CONFIG_MQTT_SAMPLE_BENCH_LOG_LEVEL);
+
+/* Parameters of the run. Set from Kconfig, and on Native Sim from the command line. */
+static struct {
+	uint32_t rate;
+	uint32_t size;
+	uint32_t count;
+} params = {
+	.rate = CONFIG_MQTT_SAMPLE_BENCH_RATE,
+	.size = CONFIG_MQTT_SAMPLE_BENCH_PAYLOAD_SIZE,
+	.count = CONFIG_MQTT_SAMPLE_BENCH_COUNT,
+};
+
+enum bench_state {
+	BENCH_IDLE,
+	BENCH_RUNNING,
+	BENCH_DONE,
+};
+
+static enum bench_state state;
+
+/* Publish to PUBACK latency of each acknowledged message, in order of arrival */
+static uint32_t latency_us[CONFIG_MQTT_SAMPLE_BENCH_MAX_COUNT];
+static uint32_t acked;
+static uint32_t sent;
+static uint32_t disconnects;
+static uint16_t first_id;
+static uint64_t start_ns;
+static uint64_t last_ack_ns;
+static uint64_t start_cpu_ns;
+static int64_t start_ms;
+
+/* Protects the latency table, PUBACKs are received in the MQTT helper's thread. */
+static struct k_spinlock lock;
+
+/* Payloads are large, so the message is not kept on the workqueue's stack. */
+static struct payload payload;
+
+static void send_work_fn(struct k_work *work);
+static void finish_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, publishing messages and reporting the result */
+static K_WORK_DELAYABLE_DEFINE(send_work, send_work_fn);
+static K_WORK_DELAYABLE_DEFINE(finish_work, finish_work_fn);
+
+static void trace_done(uint16_t id, uint64_t latency_ns)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	bool complete;
+
+	/* Only messages published by this run. Trace IDs are allocated in order. */
+	if ((state != BENCH_RUNNING) || ((uint16_t)(id - first_id) >= sent) ||
+	    (acked >= ARRAY_SIZE(latency_us))) {
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	latency_us[acked++] = latency_ns / NSEC_PER_USEC;
+	last_ack_ns = bench_clock_ns();
+	complete = (acked == params.count);
+
+	k_spin_unlock(&lock, key);
+
+	if (complete) {
+		k_work_reschedule(&finish_work, K_NO_WAIT);
+	}
+}
+
+static void send_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	uint16_t id;
+	uint32_t seq;
+	int len;
+	k_spinlock_key_t key;
+
+	if (state != BENCH_RUNNING) {
+		return;
+	}
+
+	id = msg_trace_start();
+
+	/* Counted as sent before publishing, in case the PUBACK arrives first */
+	key = k_spin_lock(&lock);
+	if (sent == 0) {
+		first_id = id;
+	}
+	seq = sent++;
+	k_spin_unlock(&lock, key);
+
+	/* Sequence number, padded to the payload size */
+	len = snprintk(payload.string, sizeof(payload.string), "%u:", seq);
+	if (len < params.size) {
+		memset(&payload.string[len], 'x', params.size - len);
+	}
+	payload.string[params.size] = '\0';
+	payload.trace_id = id;
+
+	/* Waits for the transport module to read the previous message, which would otherwise
+	 * be overwritten on the single message channel when publishing back to back.
+	 */
+	err = payload_publish(&payload, K_SECONDS(1));
+	if (err) {
+		LOG_WRN("payload_publish, error: %d", err);
+	}
+
+	if (sent == params.count) {
+		k_work_reschedule(&finish_work,
+				  K_SECONDS(CONFIG_MQTT_SAMPLE_BENCH_TIMEOUT_SECONDS));
+		return;
+	}
+
+	if (params.rate == 0) {
+		k_work_reschedule(&send_work, K_NO_WAIT);
+	} else {
+		/* Scheduled from the start of the run, so that the rate does not drift */
+		int64_t next_ms = start_ms + ((int64_t)sent * MSEC_PER_SEC) / params.rate;
+
+		k_work_reschedule(&send_work, K_MSEC(MAX(next_ms - k_uptime_get(), 0)));
+	}
+}
+
+static int latency_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of the sorted latency table */
+static uint32_t percentile(uint32_t p)
+{
+	uint32_t rank;
+
+	if (acked == 0) {
+		return 0;
+	}
+
+	rank = DIV_ROUND_UP(p * acked, 100);
+
+	return latency_us[MAX(rank, 1) - 1];
+}
+
+static size_t peak_heap_get(void)
+{
+	size_t peak = 0;
+
+#if defined(CONFIG_SYS_HEAP_ARRAY_SIZE) && (CONFIG_SYS_HEAP_ARRAY_SIZE > 0)
+	struct sys_heap **heaps;
+	int count = sys_heap_array_get(&heaps);
+
+	for (int i = 0; i < count; i++) {
+		struct sys_memory_stats stats;
+
+		if (sys_heap_runtime_stats_get(heaps[i], &stats) == 0) {
+			peak += stats.max_allocated_bytes;
+		}
+	}
+#endif /* CONFIG_SYS_HEAP_ARRAY_SIZE > 0 */
+
+	return peak;
+}
+
+static void finish_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint64_t duration_ns = last_ack_ns - start_ns;
+	uint64_t cpu_ns = bench_clock_cpu_ns() - start_cpu_ns;
+	uint32_t msgs_per_sec_x100 = 0;
+
+	state = BENCH_DONE;
+	k_spin_unlock(&lock, key);
+
+	k_work_cancel_delayable(&send_work);
+
+	qsort(latency_us, acked, sizeof(latency_us[0]), latency_cmp);
+
+	if ((acked > 0) && (duration_ns > 0)) {
+		msgs_per_sec_x100 = ((uint64_t)acked * 100 * NSEC_PER_SEC) / duration_ns;
+	}
+
+	/* printk(), so that the result is available with logging disabled */
+	printk("BENCH_RESULT {\"rate\":%u,\"size\":%u,\"count\":%u,\"sent\":%u,\"acked\":%u,"
+	       "\"duration_ms\":%u,\"msgs_per_sec\":%u.%02u,\"p50_us\":%u,\"p99_us\":%u,"
+	       "\"max_us\":%u,\"cpu_us_per_msg\":%u,\"peak_heap_bytes\":%u,\"max_rss_kb\":%u,"
+	       "\"disconnects\":%u}\n",
+	       params.rate, params.size, params.count, sent, acked,
+	       (uint32_t)(duration_ns / NSEC_PER_MSEC),
+	       msgs_per_sec_x100 / 100, msgs_per_sec_x100 % 100,
+	       percentile(50), percentile(99), acked ? latency_us[acked - 1] : 0,
+	       sent ? (uint32_t)(cpu_ns / sent / NSEC_PER_USEC) : 0,
+	       (uint32_t)peak_heap_get(),
+	       COND_CODE_1(CONFIG_BOARD_NATIVE_SIM, (bench_host_max_rss_kb()), (0)),
+	       disconnects);
+
+#if defined(CONFIG_MQTT_SAMPLE_BENCH_EXIT)
+	posix_exit((acked == params.count) ? 0 : 1);
+#endif /* CONFIG_MQTT_SAMPLE_BENCH_EXIT */
+}
+
+static void start(void)
+{
+	/* Clamp the parameters, they may come from the command line */
+	params.size = CLAMP(params.size, 1, sizeof(payload.string) - 1);
+	params.count = CLAMP(params.count, 1, ARRAY_SIZE(latency_us));
+
+	LOG_INF("Starting benchmark: %u messages of %u bytes at %u/s", params.count, params.size,
+		params.rate);
+
+	msg_trace_done_cb_set(trace_done);
+
+	start_ms = k_uptime_get();
+	start_ns = bench_clock_ns();
+	last_ack_ns = start_ns;
+	start_cpu_ns = bench_clock_cpu_ns();
+	state = BENCH_RUNNING;
+
+	k_work_reschedule(&send_work, K_NO_WAIT);
+}
+
+static void start_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	start();
+}
+
+static K_WORK_DELAYABLE_DEFINE(start_work, start_work_fn);
+
+static void bench_listener_cb(const struct zbus_channel *chan)
+{
+	const enum transport_status *status = zbus_chan_const_msg(chan);
+
+	/* The run starts once, on the first connection to the broker */
+	if ((state == BENCH_IDLE) && (*status == TRANSPORT_CONNECTED)) {
+		k_work_reschedule(&start_work,
+				  K_SECONDS(CONFIG_MQTT_SAMPLE_BENCH_WARMUP_SECONDS));
+	}
+
+	/* Connections lost during the run, for example to scheduled link outages */
+	if ((state == BENCH_RUNNING) && (*status == TRANSPORT_DISCONNECTED)) {
+		disconnects++;
+	}
+}
+
+ZBUS_LISTENER_DEFINE(bench, bench_listener_cb);
+
+static int bench_init(void)
+{
+	int err;
+
+	/* Added at runtime, as the module is optional */
+	err = zbus_chan_add_obs(&TRANSPORT_CHAN, &bench, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_add_obs, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+SYS_INIT(bench_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+static void bench_args_add(void)
+{
+	static struct args_struct_t args[] = {
+		{
+			.option = "bench-rate",
+			.name = "msg/s",
+			.type = 'u',
+			.dest = (void *)&params.rate,
+			.descript = "Benchmark publish rate, 0 for back to back",
+		},
+		{
+			.option = "bench-size",
+			.name = "bytes",
+			.type = 'u',
+			.dest = (void *)&params.size,
+			.descript = "Benchmark payload size",
+		},
+		{
+			.option = "bench-count",
+			.name = "count",
+			.type = 'u',
+			.dest = (void *)&params.count,
+			.descript = "Benchmark message count",
+		},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(args);
+}
+
+NATIVE_TASK(bench_args_add, PRE_BOOT_1, 10);
+#endif /* CONFIG_BOARD_NATIVE_SIM */
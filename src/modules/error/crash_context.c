@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/linker/section_tags.h>
+#if defined(CONFIG_HWINFO)
+#include <zephyr/drivers/hwinfo.h>
+#endif /* CONFIG_HWINFO */
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "message_channel.h"
+#include "crash_context.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(crash_context, CONFIG_MQTT_SAMPLE_ERROR_LOG_LEVEL);
+
+#define CRASH_CONTEXT_MAGIC 0x43525348
+#define MODULE_NAME_LEN 20
+#define FAST_REBOOT_MS (CONFIG_MQTT_SAMPLE_ERROR_FAST_REBOOT_SECONDS * MSEC_PER_SEC)
+#define SAFE_MODE_REBOOTS CONFIG_MQTT_SAMPLE_ERROR_SAFE_MODE_REBOOTS
+
+#if defined(CONFIG_HWINFO)
+/* Reset causes that count as a crash: watchdog, CPU lockup and fault resets */
+#define CRASH_RESET_CAUSES (RESET_WATCHDOG | RESET_CPU_LOCKUP | RESET_SECURITY | RESET_PARITY)
+#endif /* CONFIG_HWINFO */
+
+/* Kept in RAM that is not initialized at boot, so that it survives a reboot. It is lost on
+ * power loss, which also ends a reboot storm.
+ */
+struct crash_context {
+	uint32_t magic;
+
+	/* Crashes in a row that each ended a boot within the fast reboot time. Counted at boot,
+	 * and cleared once the device has stayed up for that time.
+	 */
+	uint16_t fast_reboots;
+
+	/* Set from boot until the device has stayed up for the fast reboot time */
+	uint8_t unstable;
+
+	/* Set when a fatal error is recorded, and cleared once counted at the next boot */
+	uint8_t crashed;
+
+	/* Fatal errors since the context was created */
+	uint16_t crashes;
+
+	/* Set once the last fatal error has been reported */
+	uint8_t reported;
+
+	/* Last fatal error */
+	char module[MODULE_NAME_LEN];
+	int32_t line;
+	int32_t err;
+	uint32_t uptime_ms;
+
+	/* Over all of the above */
+	uint32_t crc;
+};
+
+static __noinit struct crash_context context;
+
+/* Taken for each change of the context, which is changed from the workqueue, the shell and
+ * the context of the module that reports a fatal error.
+ */
+static struct k_spinlock lock;
+
+static bool safe_mode;
+
+/* Fast reboots in a row that led to this boot */
+static uint16_t boot_fast_reboots;
+
+/* Whether the transport module is connected to the broker */
+static bool connected;
+
+static uint32_t context_crc(void)
+{
+	return crc32_ieee((const uint8_t *)&context, offsetof(struct crash_context, crc));
+}
+
+static void context_save(void)
+{
+	context.crc = context_crc();
+}
+
+static void stable_work_fn(struct k_work *work);
+static void report_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, ends the reboot storm once the device stays up */
+static K_WORK_DELAYABLE_DEFINE(stable_work, stable_work_fn);
+
+/* Work - Runs on the system workqueue, reports the last fatal error once connected */
+static K_WORK_DEFINE(report_work, report_work_fn);
+
+static void stable_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	context.fast_reboots = 0;
+	context.unstable = 0;
+	context_save();
+
+	k_spin_unlock(&lock, key);
+}
+
+static void report_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	struct telemetry telemetry;
+
+	if ((context.crashes == 0) || context.reported) {
+		return;
+	}
+
+	snprintk(telemetry.string, sizeof(telemetry.string),
+		 "crash %s:%d err:%d uptime:%u fast:%u total:%u", context.module, context.line,
+		 context.err, context.uptime_ms, boot_fast_reboots, context.crashes);
+
+	err = telemetry_publish(&telemetry, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("telemetry_publish, error: %d", err);
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	context.reported = 1;
+	context_save();
+
+	k_spin_unlock(&lock, key);
+}
+
+void crash_context_record(const struct fatal_error *error)
+{
+	const char *module = strrchr(error->file, '/');
+	uint32_t uptime_ms = k_uptime_get_32();
+
+	module = module ? (module + 1) : error->file;
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	context.crashes = MIN(context.crashes + 1, UINT16_MAX);
+	context.crashed = 1;
+	context.reported = 0;
+	strncpy(context.module, module, sizeof(context.module) - 1);
+	context.module[sizeof(context.module) - 1] = '\0';
+	context.line = error->line;
+	context.err = error->err;
+	context.uptime_ms = uptime_ms;
+
+	context_save();
+
+	k_spin_unlock(&lock, key);
+
+	/* In safe mode the device stays up, so the error is reported right away if possible */
+	if (safe_mode && connected) {
+		k_work_submit(&report_work);
+	}
+}
+
+bool crash_context_safe_mode(void)
+{
+	return safe_mode;
+}
+
+static void crash_context_listener_cb(const struct zbus_channel *chan)
+{
+	const enum transport_status *status = zbus_chan_const_msg(chan);
+
+	connected = (*status == TRANSPORT_CONNECTED);
+
+	if (connected) {
+		k_work_submit(&report_work);
+	}
+}
+
+ZBUS_LISTENER_DEFINE(crash_context_listener, crash_context_listener_cb);
+
+/* Delay after the given number of fast reboots in a row, doubled with each one */
+static uint32_t backoff_seconds(uint16_t fast_reboots)
+{
+	uint32_t shift = MIN(fast_reboots - 1, 16);
+
+	return MIN((uint32_t)CONFIG_MQTT_SAMPLE_ERROR_BACKOFF_BASE_SECONDS << shift,
+		   CONFIG_MQTT_SAMPLE_ERROR_BACKOFF_MAX_SECONDS);
+}
+
+/* Whether the hardware reports that the last reset was caused by a crash. Software resets are
+ * not, as every sys_reboot() is one, also the intentional ones.
+ */
+static bool reset_cause_crash(void)
+{
+#if defined(CONFIG_HWINFO)
+	int err;
+	uint32_t cause;
+
+	err = hwinfo_get_reset_cause(&cause);
+	if (err) {
+		/* -ENOSYS on SoCs that do not report the reset cause */
+		LOG_DBG("hwinfo_get_reset_cause, error: %d", err);
+		return false;
+	}
+
+	/* The cause accumulates over resets on some SoCs */
+	(void)hwinfo_clear_reset_cause();
+
+	return (cause & CRASH_RESET_CAUSES) != 0;
+#else
+	return false;
+#endif /* CONFIG_HWINFO */
+}
+
+/* Runs before the modules start, so that a boot delay holds them back */
+static int crash_context_init(void)
+{
+	int err;
+	uint32_t delay;
+	bool crashed;
+
+	if ((context.magic != CRASH_CONTEXT_MAGIC) || (context.crc != context_crc())) {
+		memset(&context, 0, sizeof(context));
+		context.magic = CRASH_CONTEXT_MAGIC;
+		context_save();
+	}
+
+	if (context.crashes && !context.reported) {
+		LOG_WRN("Rebooted after a fatal error in %s:%d, error: %d, %u ms after boot",
+			context.module, context.line, context.err, context.uptime_ms);
+	}
+
+	err = zbus_chan_add_obs(&TRANSPORT_CHAN, &crash_context_listener, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_add_obs, error: %d", err);
+		return err;
+	}
+
+	/* Only crashes count, so that intentional reboots, such as to provision, a reset by the
+	 * user or a firmware update, are not held back. Counted now rather than when a fatal
+	 * error is recorded, so that watchdog and lockup resets count as well.
+	 */
+	crashed = context.crashed || reset_cause_crash();
+
+	if (crashed && context.unstable) {
+		context.fast_reboots = MIN(context.fast_reboots + 1, UINT16_MAX);
+		boot_fast_reboots = context.fast_reboots;
+	}
+
+	context.crashed = 0;
+	context.unstable = 1;
+	context_save();
+
+	if ((SAFE_MODE_REBOOTS > 0) && (boot_fast_reboots >= SAFE_MODE_REBOOTS)) {
+		LOG_ERR("%u fast reboots in a row, starting in safe mode", boot_fast_reboots);
+		safe_mode = true;
+	} else if (boot_fast_reboots > 0) {
+		delay = backoff_seconds(boot_fast_reboots);
+
+		LOG_WRN("%u fast reboots in a row, delaying the boot by %u s", boot_fast_reboots,
+			delay);
+
+		k_sleep(K_SECONDS(delay));
+	}
+
+	k_work_schedule(&stable_work, K_MSEC(FAST_REBOOT_MS));
+
+	return 0;
+}
+
+/* After the boot timeline and the executor queues, and before the supervisor and the modules */
+SYS_INIT(crash_context_init, APPLICATION, 1);
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(sh, "Fatal errors: %u, fast reboots in a row: %u%s", context.crashes,
+		    context.fast_reboots, safe_mode ? ", safe mode" : "");
+
+	if (context.crashes) {
+		shell_print(sh, "Last: %s:%d, error: %d, %u ms after boot, %s", context.module,
+			    context.line, context.err, context.uptime_ms,
+			    context.reported ? "reported" : "not reported");
+	}
+
+	return 0;
+}
+
+static int cmd_clear(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memset(&context, 0, sizeof(context));
+	context.magic = CRASH_CONTEXT_MAGIC;
+	context_save();
+
+	k_spin_unlock(&lock, key);
+
+	shell_print(sh, "Crash context cleared");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_crash_context,
+	SHELL_CMD(show, NULL, "Show the last fatal error and the reboot count", cmd_show),
+	SHELL_CMD(clear, NULL, "Clear the crash context", cmd_clear),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(crash_context, &sub_crash_context, "Crash context", NULL);
+#endif /* CONFIG_SHELL */
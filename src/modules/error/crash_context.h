@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _CRASH_CONTEXT_H_
+#define _CRASH_CONTEXT_H_
+
+#include <stdbool.h>
+
+#include "message_channel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Record a fatal error in retained RAM, before rebooting.
+ *
+ * The next boot counts it as a fast reboot if it happened within
+ * CONFIG_MQTT_SAMPLE_ERROR_FAST_REBOOT_SECONDS of boot, as it does for watchdog, CPU lockup
+ * and fault resets that the hardware reports. Other reboots are not counted.
+ *
+ * @param error Fatal error.
+ */
+void crash_context_record(const struct fatal_error *error);
+
+/**
+ * @brief Check whether the device booted in safe mode, after too many fast reboots in a row.
+ *	  In safe mode, fatal errors reboot after CONFIG_MQTT_SAMPLE_ERROR_SAFE_MODE_REBOOT_SECONDS
+ *	  instead of right away.
+ *
+ * @retval true if in safe mode.
+ */
+bool crash_context_safe_mode(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CRASH_CONTEXT_H_ */
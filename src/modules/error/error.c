@@ -10,16 +10,58 @@
 
 #include "message_channel.h"
 
+#if defined(CONFIG_MQTT_SAMPLE_ERROR_CRASH_CONTEXT)
+#include "crash_context.h"
+#endif /* CONFIG_MQTT_SAMPLE_ERROR_CRASH_CONTEXT */
+
 /* Register log module */
 LOG_MODULE_REGISTER(error, CONFIG_MQTT_SAMPLE_ERROR_LOG_LEVEL);
 
+static void reboot(void)
+{
+	LOG_PANIC();
+	sys_reboot(0);
+}
+
+#if defined(CONFIG_MQTT_SAMPLE_ERROR_CRASH_CONTEXT)
+#define SAFE_MODE_REBOOT_DELAY K_SECONDS(CONFIG_MQTT_SAMPLE_ERROR_SAFE_MODE_REBOOT_SECONDS)
+
+static void reboot_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	LOG_ERR("Safe mode reboot");
+	reboot();
+}
+
+/* Work - Runs on the system workqueue, reboots in safe mode after a fatal error */
+static K_WORK_DELAYABLE_DEFINE(reboot_work, reboot_work_fn);
+#endif /* CONFIG_MQTT_SAMPLE_ERROR_CRASH_CONTEXT */
+
 void error_callback(const struct zbus_channel *chan)
 {
 	if (&FATAL_ERROR_CHAN == chan) {
+		const struct fatal_error *error = zbus_chan_const_msg(chan);
+
+		LOG_ERR("FATAL error in %s:%d, error: %d", error->file, error->line, error->err);
+
+#if defined(CONFIG_MQTT_SAMPLE_ERROR_CRASH_CONTEXT)
+		crash_context_record(error);
+
+		/* In safe mode the device stays up, so that the error can be reported, and
+		 * the next attempt is left for later.
+		 */
+		if (crash_context_safe_mode()) {
+			LOG_ERR("Safe mode, rebooting in %d seconds",
+				CONFIG_MQTT_SAMPLE_ERROR_SAFE_MODE_REBOOT_SECONDS);
+			k_work_schedule(&reboot_work, SAFE_MODE_REBOOT_DELAY);
+			return;
+		}
+#endif /* CONFIG_MQTT_SAMPLE_ERROR_CRASH_CONTEXT */
+
 		if (IS_ENABLED(CONFIG_MQTT_SAMPLE_ERROR_REBOOT_ON_FATAL)) {
 			LOG_ERR("FATAL error, rebooting");
-			LOG_PANIC();
-			sys_reboot(0);
+			reboot();
 		}
 	}
 }
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/net_if.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#include <posix_native_task.h>
+#include <cmdline.h>
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+/* Register log module */
+LOG_MODULE_REGISTER(link_outage, CONFIG_MQTT_SAMPLE_LINK_OUTAGE_LOG_LEVEL);
+
+/* Outage schedule. Set from Kconfig, and on Native Sim from the command line. */
+static struct {
+	uint32_t start;
+	uint32_t period;
+	uint32_t duration;
+} schedule = {
+	.start = CONFIG_MQTT_SAMPLE_LINK_OUTAGE_START_SECONDS,
+	.period = CONFIG_MQTT_SAMPLE_LINK_OUTAGE_PERIOD_SECONDS,
+	.duration = CONFIG_MQTT_SAMPLE_LINK_OUTAGE_DURATION_SECONDS,
+};
+
+static uint32_t outages;
+static bool link_down;
+
+static void down_work_fn(struct k_work *work);
+static void up_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, taking the interface down and back up */
+static K_WORK_DELAYABLE_DEFINE(down_work, down_work_fn);
+static K_WORK_DELAYABLE_DEFINE(up_work, up_work_fn);
+
+static void outage_start(uint32_t duration)
+{
+	int err;
+	struct net_if *iface = net_if_get_default();
+
+	if ((iface == NULL) || link_down) {
+		return;
+	}
+
+	LOG_WRN("Link outage for %u seconds", duration);
+
+	err = net_if_down(iface);
+	if (err) {
+		LOG_ERR("net_if_down, error: %d", err);
+		return;
+	}
+
+	link_down = true;
+	outages++;
+
+	k_work_reschedule(&up_work, K_SECONDS(duration));
+}
+
+static void down_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	outage_start(schedule.duration);
+
+	if (schedule.period > 0) {
+		k_work_reschedule(&down_work, K_SECONDS(schedule.period));
+	}
+}
+
+static void up_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	struct net_if *iface = net_if_get_default();
+
+	err = net_if_up(iface);
+	if (err) {
+		LOG_ERR("net_if_up, error: %d", err);
+	}
+
+	link_down = false;
+
+	LOG_INF("Link outage ended");
+}
+
+static int link_outage_init(void)
+{
+	if (schedule.start == 0) {
+		return 0;
+	}
+
+	schedule.duration = MAX(schedule.duration, 1);
+
+	if ((schedule.period > 0) && (schedule.period <= schedule.duration)) {
+		LOG_WRN("Outage period not longer than the duration, single outage only");
+		schedule.period = 0;
+	}
+
+	LOG_INF("Link outages of %u seconds from %u seconds, every %u seconds", schedule.duration,
+		schedule.start, schedule.period);
+
+	k_work_reschedule(&down_work, K_SECONDS(schedule.start));
+
+	return 0;
+}
+
+SYS_INIT(link_outage_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+#if defined(CONFIG_SHELL)
+static int cmd_start(const struct shell *sh, size_t argc, char **argv)
+{
+	uint32_t duration = (argc > 1) ? strtoul(argv[1], NULL, 0) : schedule.duration;
+
+	if ((duration == 0) || link_down) {
+		shell_error(sh, "Invalid duration, or outage in progress");
+		return -EINVAL;
+	}
+
+	outage_start(duration);
+
+	return 0;
+}
+
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(sh, "Schedule: start %u s, period %u s, duration %u s", schedule.start,
+		    schedule.period, schedule.duration);
+	shell_print(sh, "Outages: %u, link %s", outages, link_down ? "down" : "up");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_link_outage,
+	SHELL_CMD_ARG(start, NULL, "Start an outage: start [seconds]", cmd_start, 1, 1),
+	SHELL_CMD(show, NULL, "Show the schedule and the outage count", cmd_show),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(link_outage, &sub_link_outage, "Scheduled link outages", NULL);
+#endif /* CONFIG_SHELL */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+static void link_outage_args_add(void)
+{
+	static struct args_struct_t args[] = {
+		{
+			.option = "outage-start",
+			.name = "seconds",
+			.type = 'u',
+			.dest = (void *)&schedule.start,
+			.descript = "Time from boot to the first link outage, 0 for none",
+		},
+		{
+			.option = "outage-period",
+			.name = "seconds",
+			.type = 'u',
+			.dest = (void *)&schedule.period,
+			.descript = "Time between the starts of link outages, 0 for one",
+		},
+		{
+			.option = "outage-duration",
+			.name = "seconds",
+			.type = 'u',
+			.dest = (void *)&schedule.duration,
+			.descript = "Link outage duration",
+		},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(args);
+}
+
+NATIVE_TASK(link_outage_args_add, PRE_BOOT_1, 10);
+#endif /* CONFIG_BOARD_NATIVE_SIM */
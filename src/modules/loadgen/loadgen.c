@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/mqtt.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/random/random.h>
+
+#include <posix_native_task.h>
+#include <posix_board_if.h>
+#include <cmdline.h>
+
+#include "message_channel.h"
+#include "bench_clock.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(loadgen, CONFIG_MQTT_SAMPLE_LOADGEN_LOG_LEVEL);
+
+#define CLIENT_ID_SIZE 32
+#define TOPIC_SIZE (CLIENT_ID_SIZE + sizeof(CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_TOPIC))
+
+/* Time before a failed connection attempt is retried, as in the transport module */
+#define RECONNECT_MS (CONFIG_MQTT_SAMPLE_TRANSPORT_RECONNECTION_TIMEOUT_SECONDS * MSEC_PER_SEC)
+
+/* Number of messages per client whose publish time is kept for latency measurement */
+#define IN_FLIGHT 8
+
+/* Latency histogram with four buckets per power of two, so that percentiles are within 25%.
+ * Bucket n < 4 counts latencies of n us. Above, bucket 4 * (m - 1) + s counts latencies whose
+ * most significant bit is m and whose next two bits are s.
+ */
+#define HIST_BUCKETS 124
+
+/* Worker that runs a subset of the clients */
+struct worker {
+	struct k_thread thread;
+
+	uint32_t connects;
+	uint32_t connect_failures;
+	uint32_t disconnects;
+	uint32_t publishes;
+	uint32_t pubacks;
+	uint32_t connect_hist[HIST_BUCKETS];
+	uint32_t publish_hist[HIST_BUCKETS];
+};
+
+enum client_state {
+	CLIENT_IDLE,
+	CLIENT_CONNECTING,
+	CLIENT_CONNECTED,
+};
+
+/* Context of one simulated device. Each client is run by one worker only, so it needs no
+ * locking.
+ */
+struct client {
+	struct mqtt_client mqtt;
+	struct worker *worker;
+	enum client_state state;
+
+	char client_id[CLIENT_ID_SIZE];
+	char pub_topic[TOPIC_SIZE];
+
+	uint8_t rx_buf[CONFIG_MQTT_SAMPLE_LOADGEN_BUFFER_SIZE];
+	uint8_t tx_buf[CONFIG_MQTT_SAMPLE_LOADGEN_BUFFER_SIZE];
+
+	uint64_t connect_ns;
+	int64_t next_connect_ms;
+	int64_t next_publish_ms;
+	uint16_t msg_id;
+
+	/* Publish time of the last messages, by message ID */
+	uint64_t sent_ns[IN_FLIGHT];
+};
+
+/* Parameters of the run. Set from Kconfig, and from the command line. */
+static struct {
+	uint32_t clients;
+	uint32_t interval_ms;
+	uint32_t size;
+	uint32_t duration;
+	uint32_t storm_period;
+	uint32_t storm_percent;
+} params = {
+	.clients = CONFIG_MQTT_SAMPLE_LOADGEN_CLIENTS,
+	.interval_ms = CONFIG_MQTT_SAMPLE_LOADGEN_INTERVAL_MS,
+	.size = CONFIG_MQTT_SAMPLE_LOADGEN_PAYLOAD_SIZE,
+	.duration = CONFIG_MQTT_SAMPLE_LOADGEN_DURATION_SECONDS,
+	.storm_period = CONFIG_MQTT_SAMPLE_LOADGEN_STORM_PERIOD_SECONDS,
+	.storm_percent = CONFIG_MQTT_SAMPLE_LOADGEN_STORM_PERCENT,
+};
+
+static struct client clients[CONFIG_MQTT_SAMPLE_LOADGEN_CLIENTS];
+static struct worker workers[CONFIG_MQTT_SAMPLE_LOADGEN_THREADS];
+
+K_THREAD_STACK_ARRAY_DEFINE(worker_stacks, CONFIG_MQTT_SAMPLE_LOADGEN_THREADS,
+			    CONFIG_MQTT_SAMPLE_LOADGEN_THREAD_STACK_SIZE);
+
+static struct sockaddr_storage broker;
+static uint8_t payload[CONFIG_MQTT_SAMPLE_LOADGEN_PAYLOAD_SIZE];
+static atomic_t running;
+static int64_t start_ms;
+static uint64_t start_ns;
+
+static size_t hist_bucket(uint64_t latency_ns)
+{
+	uint32_t us = MIN(latency_ns / NSEC_PER_USEC, UINT32_MAX);
+	uint32_t msb;
+
+	if (us < 4) {
+		return us;
+	}
+
+	msb = 31 - __builtin_clz(us);
+
+	return MIN((4 * (msb - 1)) + ((us >> (msb - 2)) & 0x3), HIST_BUCKETS - 1);
+}
+
+/* Upper bound of a bucket, in microseconds */
+static uint32_t hist_bound(size_t bucket)
+{
+	if (bucket < 4) {
+		return bucket;
+	}
+
+	return (uint32_t)MIN((uint64_t)(4 + (bucket % 4) + 1) << ((bucket / 4) - 1), UINT32_MAX);
+}
+
+static uint32_t hist_percentile(const uint32_t *hist, uint32_t p)
+{
+	uint64_t total = 0;
+	uint64_t rank;
+	uint64_t seen = 0;
+
+	for (size_t b = 0; b < HIST_BUCKETS; b++) {
+		total += hist[b];
+	}
+
+	if (total == 0) {
+		return 0;
+	}
+
+	rank = MAX(DIV_ROUND_UP(p * total, 100), 1);
+
+	for (size_t b = 0; b < HIST_BUCKETS; b++) {
+		seen += hist[b];
+		if (seen >= rank) {
+			return hist_bound(b);
+		}
+	}
+
+	return hist_bound(HIST_BUCKETS - 1);
+}
+
+static void mqtt_evt_handler(struct mqtt_client *const mqtt, const struct mqtt_evt *evt)
+{
+	struct client *client = CONTAINER_OF(mqtt, struct client, mqtt);
+	struct worker *worker = client->worker;
+	uint64_t now = bench_clock_ns();
+
+	switch (evt->type) {
+	case MQTT_EVT_CONNACK:
+		if ((evt->result != 0) ||
+		    (evt->param.connack.return_code != MQTT_CONNECTION_ACCEPTED)) {
+			worker->connect_failures++;
+			break;
+		}
+
+		client->state = CLIENT_CONNECTED;
+		client->next_publish_ms = k_uptime_get() + sys_rand32_get() % params.interval_ms;
+		worker->connects++;
+		worker->connect_hist[hist_bucket(now - client->connect_ns)]++;
+		break;
+	case MQTT_EVT_DISCONNECT:
+		/* Reconnect right away, as the transport module does when the connection is lost,
+		 * and after the reconnection timeout when the attempt was refused or timed out.
+		 */
+		client->next_connect_ms = k_uptime_get();
+
+		if (client->state == CLIENT_CONNECTED) {
+			worker->disconnects++;
+		} else {
+			client->next_connect_ms += RECONNECT_MS;
+		}
+
+		client->state = CLIENT_IDLE;
+		break;
+	case MQTT_EVT_PUBACK:
+		if (evt->result != 0) {
+			break;
+		}
+
+		worker->pubacks++;
+
+		if (client->sent_ns[evt->param.puback.message_id % IN_FLIGHT]) {
+			uint64_t sent = client->sent_ns[evt->param.puback.message_id % IN_FLIGHT];
+
+			worker->publish_hist[hist_bucket(now - sent)]++;
+			client->sent_ns[evt->param.puback.message_id % IN_FLIGHT] = 0;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void client_connect(struct client *client)
+{
+	int err;
+
+	mqtt_client_init(&client->mqtt);
+
+	client->mqtt.broker = &broker;
+	client->mqtt.evt_cb = mqtt_evt_handler;
+	client->mqtt.client_id.utf8 = client->client_id;
+	client->mqtt.client_id.size = strlen(client->client_id);
+	client->mqtt.protocol_version = MQTT_VERSION_3_1_1;
+	client->mqtt.rx_buf = client->rx_buf;
+	client->mqtt.rx_buf_size = sizeof(client->rx_buf);
+	client->mqtt.tx_buf = client->tx_buf;
+	client->mqtt.tx_buf_size = sizeof(client->tx_buf);
+	client->mqtt.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client->mqtt.clean_session = IS_ENABLED(CONFIG_MQTT_CLEAN_SESSION);
+
+	client->connect_ns = bench_clock_ns();
+	memset(client->sent_ns, 0, sizeof(client->sent_ns));
+
+	err = mqtt_connect(&client->mqtt);
+	if (err) {
+		/* Retried later, as the transport module does when a connection attempt fails */
+		client->worker->connect_failures++;
+		client->next_connect_ms = k_uptime_get() + RECONNECT_MS;
+		return;
+	}
+
+	client->state = CLIENT_CONNECTING;
+
+	/* Deadline for the CONNACK */
+	client->next_connect_ms = k_uptime_get() + RECONNECT_MS;
+}
+
+static void client_publish(struct client *client)
+{
+	int err;
+	struct mqtt_publish_param param = {
+		.message.payload.data = payload,
+		.message.payload.len = params.size,
+		.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE,
+		.message.topic.topic.utf8 = client->pub_topic,
+		.message.topic.topic.size = strlen(client->pub_topic),
+	};
+
+	/* Message ID 0 is not allowed */
+	client->msg_id = (client->msg_id == UINT16_MAX) ? 1 : (client->msg_id + 1);
+	param.message_id = client->msg_id;
+
+	client->sent_ns[client->msg_id % IN_FLIGHT] = bench_clock_ns();
+
+	err = mqtt_publish(&client->mqtt, &param);
+	if (err) {
+		LOG_DBG("mqtt_publish, error: %d", err);
+		client->sent_ns[client->msg_id % IN_FLIGHT] = 0;
+		return;
+	}
+
+	client->worker->publishes++;
+}
+
+/* Drop the connection of a share of the clients, which then all reconnect at once */
+static void storm(size_t index)
+{
+	size_t count = 0;
+
+	for (size_t i = index; i < params.clients; i += ARRAY_SIZE(workers)) {
+		if ((clients[i].state == CLIENT_CONNECTED) && ((i % 100) < params.storm_percent)) {
+			mqtt_abort(&clients[i].mqtt);
+			count++;
+		}
+	}
+
+	LOG_DBG("Worker %zu dropped %zu connections", index, count);
+}
+
+static void worker_fn(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	size_t index = POINTER_TO_UINT(p1);
+	static struct zsock_pollfd fds[CONFIG_MQTT_SAMPLE_LOADGEN_THREADS]
+				       [DIV_ROUND_UP(CONFIG_MQTT_SAMPLE_LOADGEN_CLIENTS,
+						     CONFIG_MQTT_SAMPLE_LOADGEN_THREADS)];
+	struct client *polled[ARRAY_SIZE(fds[0])];
+	int64_t next_storm_ms = start_ms + (params.storm_period * MSEC_PER_SEC);
+
+	while (atomic_get(&running)) {
+		int64_t now = k_uptime_get();
+		int64_t next = now + 100;
+		size_t count = 0;
+		int ret;
+
+		if ((params.storm_period > 0) && (now >= next_storm_ms)) {
+			storm(index);
+			next_storm_ms += params.storm_period * MSEC_PER_SEC;
+		}
+
+		/* Clients of this worker are every n-th client, for n workers */
+		for (size_t i = index; i < params.clients; i += ARRAY_SIZE(workers)) {
+			struct client *client = &clients[i];
+
+			if ((client->state == CLIENT_IDLE) && (now >= client->next_connect_ms)) {
+				client_connect(client);
+			}
+
+			if ((client->state == CLIENT_CONNECTING) &&
+			    (now >= client->next_connect_ms)) {
+				client->worker->connect_failures++;
+				mqtt_abort(&client->mqtt);
+			}
+
+			if (client->state == CLIENT_IDLE) {
+				next = MIN(next, client->next_connect_ms);
+				continue;
+			}
+
+			if (client->state == CLIENT_CONNECTED) {
+				if (now >= client->next_publish_ms) {
+					client_publish(client);
+					client->next_publish_ms += params.interval_ms;
+				}
+
+				if (mqtt_keepalive_time_left(&client->mqtt) == 0) {
+					(void)mqtt_live(&client->mqtt);
+				}
+
+				next = MIN(next, client->next_publish_ms);
+			}
+
+			fds[index][count].fd = client->mqtt.transport.tcp.sock;
+			fds[index][count].events = ZSOCK_POLLIN;
+			polled[count++] = client;
+		}
+
+		if (count == 0) {
+			k_sleep(K_TIMEOUT_ABS_MS(next));
+			continue;
+		}
+
+		ret = zsock_poll(fds[index], count, MAX(next - k_uptime_get(), 0));
+		if (ret < 0) {
+			LOG_ERR("zsock_poll, error: %d", errno);
+			k_sleep(K_MSEC(100));
+			continue;
+		}
+
+		for (size_t i = 0; (ret > 0) && (i < count); i++) {
+			if (fds[index][i].revents & ZSOCK_POLLIN) {
+				(void)mqtt_input(&polled[i]->mqtt);
+			} else if (fds[index][i].revents & (ZSOCK_POLLERR | ZSOCK_POLLHUP |
+							     ZSOCK_POLLNVAL)) {
+				mqtt_abort(&polled[i]->mqtt);
+			}
+		}
+	}
+
+	for (size_t i = index; i < params.clients; i += ARRAY_SIZE(workers)) {
+		if (clients[i].state != CLIENT_IDLE) {
+			mqtt_abort(&clients[i].mqtt);
+		}
+	}
+}
+
+static int broker_resolve(void)
+{
+	int err;
+	char port[6];
+	struct zsock_addrinfo *result;
+	struct zsock_addrinfo hints = {
+		.ai_family = AF_INET,
+		.ai_socktype = SOCK_STREAM,
+	};
+
+	snprintk(port, sizeof(port), "%d", CONFIG_MQTT_HELPER_PORT);
+
+	err = zsock_getaddrinfo(CONFIG_MQTT_SAMPLE_TRANSPORT_BROKER_HOSTNAME, port, &hints,
+				&result);
+	if (err) {
+		LOG_ERR("zsock_getaddrinfo, error: %d", err);
+		return -EHOSTUNREACH;
+	}
+
+	memcpy(&broker, result->ai_addr, result->ai_addrlen);
+	zsock_freeaddrinfo(result);
+
+	return 0;
+}
+
+static void report(void)
+{
+	struct worker total = { 0 };
+	uint64_t duration_ns = bench_clock_ns() - start_ns;
+	uint32_t msgs_per_sec_x100 = 0;
+
+	for (size_t w = 0; w < ARRAY_SIZE(workers); w++) {
+		total.connects += workers[w].connects;
+		total.connect_failures += workers[w].connect_failures;
+		total.disconnects += workers[w].disconnects;
+		total.publishes += workers[w].publishes;
+		total.pubacks += workers[w].pubacks;
+
+		for (size_t b = 0; b < HIST_BUCKETS; b++) {
+			total.connect_hist[b] += workers[w].connect_hist[b];
+			total.publish_hist[b] += workers[w].publish_hist[b];
+		}
+	}
+
+	if (duration_ns > 0) {
+		msgs_per_sec_x100 = ((uint64_t)total.pubacks * 100 * NSEC_PER_SEC) / duration_ns;
+	}
+
+	/* printk(), so that the result is available with logging disabled */
+	printk("LOADGEN_RESULT {\"clients\":%u,\"threads\":%u,\"interval_ms\":%u,\"size\":%u,"
+	       "\"duration_ms\":%u,\"connects\":%u,\"connect_failures\":%u,\"disconnects\":%u,"
+	       "\"publishes\":%u,\"pubacks\":%u,\"msgs_per_sec\":%u.%02u,"
+	       "\"connect_p50_us\":%u,\"connect_p99_us\":%u,\"connect_max_us\":%u,"
+	       "\"publish_p50_us\":%u,\"publish_p99_us\":%u,\"publish_max_us\":%u}\n",
+	       params.clients, (uint32_t)ARRAY_SIZE(workers), params.interval_ms, params.size,
+	       (uint32_t)(duration_ns / NSEC_PER_MSEC), total.connects, total.connect_failures,
+	       total.disconnects, total.publishes, total.pubacks,
+	       msgs_per_sec_x100 / 100, msgs_per_sec_x100 % 100,
+	       hist_percentile(total.connect_hist, 50), hist_percentile(total.connect_hist, 99),
+	       hist_percentile(total.connect_hist, 100),
+	       hist_percentile(total.publish_hist, 50), hist_percentile(total.publish_hist, 99),
+	       hist_percentile(total.publish_hist, 100));
+}
+
+static void finish_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	atomic_set(&running, 0);
+
+	for (size_t w = 0; w < ARRAY_SIZE(workers); w++) {
+		(void)k_thread_join(&workers[w].thread, K_SECONDS(5));
+	}
+
+	report();
+
+#if defined(CONFIG_MQTT_SAMPLE_LOADGEN_EXIT)
+	posix_exit(0);
+#endif /* CONFIG_MQTT_SAMPLE_LOADGEN_EXIT */
+}
+
+static K_WORK_DELAYABLE_DEFINE(finish_work, finish_work_fn);
+
+static void start_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+
+	/* Clamp the parameters, they may come from the command line */
+	params.clients = CLAMP(params.clients, 1, ARRAY_SIZE(clients));
+	params.interval_ms = MAX(params.interval_ms, 1);
+	params.size = CLAMP(params.size, 1, sizeof(payload));
+	params.storm_percent = MIN(params.storm_percent, 100);
+
+	err = broker_resolve();
+	if (err) {
+		return;
+	}
+
+	memset(payload, 'x', sizeof(payload));
+
+	for (size_t i = 0; i < params.clients; i++) {
+		struct client *client = &clients[i];
+
+		client->worker = &workers[i % ARRAY_SIZE(workers)];
+		client->state = CLIENT_IDLE;
+
+		/* Clients connect spread over the ramp time, not all at once */
+		client->next_connect_ms = k_uptime_get() +
+			((uint64_t)i * CONFIG_MQTT_SAMPLE_LOADGEN_RAMP_MS) / params.clients;
+
+		snprintk(client->client_id, sizeof(client->client_id), "%s-%zu",
+			 CONFIG_MQTT_SAMPLE_LOADGEN_CLIENT_ID_PREFIX, i);
+		snprintk(client->pub_topic, sizeof(client->pub_topic), "%s/%s", client->client_id,
+			 CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_TOPIC);
+	}
+
+	LOG_INF("Starting load generator: %u clients on %u threads, publishing every %u ms",
+		params.clients, (uint32_t)ARRAY_SIZE(workers), params.interval_ms);
+
+	start_ms = k_uptime_get();
+	start_ns = bench_clock_ns();
+	atomic_set(&running, 1);
+
+	for (size_t w = 0; w < ARRAY_SIZE(workers); w++) {
+		k_thread_create(&workers[w].thread, worker_stacks[w],
+				K_THREAD_STACK_SIZEOF(worker_stacks[w]), worker_fn,
+				UINT_TO_POINTER(w), NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0,
+				K_NO_WAIT);
+	}
+
+	k_work_reschedule(&finish_work, K_SECONDS(params.duration));
+}
+
+static K_WORK_DELAYABLE_DEFINE(start_work, start_work_fn);
+
+static void loadgen_listener_cb(const struct zbus_channel *chan)
+{
+	const enum transport_status *status = zbus_chan_const_msg(chan);
+	static bool started;
+
+	/* The run starts once, when the network is known to reach the broker */
+	if (!started && (*status == TRANSPORT_CONNECTED)) {
+		started = true;
+		k_work_reschedule(&start_work, K_NO_WAIT);
+	}
+}
+
+ZBUS_LISTENER_DEFINE(loadgen, loadgen_listener_cb);
+
+static int loadgen_init(void)
+{
+	int err;
+
+	/* Added at runtime, as the module is optional */
+	err = zbus_chan_add_obs(&TRANSPORT_CHAN, &loadgen, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_add_obs, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+SYS_INIT(loadgen_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+static void loadgen_args_add(void)
+{
+	static struct args_struct_t args[] = {
+		{
+			.option = "loadgen-clients",
+			.name = "count",
+			.type = 'u',
+			.dest = (void *)&params.clients,
+			.descript = "Number of simulated clients",
+		},
+		{
+			.option = "loadgen-interval",
+			.name = "ms",
+			.type = 'u',
+			.dest = (void *)&params.interval_ms,
+			.descript = "Publish interval of each client",
+		},
+		{
+			.option = "loadgen-size",
+			.name = "bytes",
+			.type = 'u',
+			.dest = (void *)&params.size,
+			.descript = "Payload size",
+		},
+		{
+			.option = "loadgen-duration",
+			.name = "seconds",
+			.type = 'u',
+			.dest = (void *)&params.duration,
+			.descript = "Duration of the run",
+		},
+		{
+			.option = "loadgen-storm-period",
+			.name = "seconds",
+			.type = 'u',
+			.dest = (void *)&params.storm_period,
+			.descript = "Time between reconnect storms, 0 for none",
+		},
+		{
+			.option = "loadgen-storm-percent",
+			.name = "percent",
+			.type = 'u',
+			.dest = (void *)&params.storm_percent,
+			.descript = "Share of the clients that reconnect in a storm",
+		},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(args);
+}
+
+NATIVE_TASK(loadgen_args_add, PRE_BOOT_1, 10);
@@ -0,0 +1,545 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/net_event.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/net/wifi_credentials.h>
+#include <zephyr/net/dhcpv4.h>
+#include <zephyr/net/conn_mgr_connectivity.h>
+#if defined(CONFIG_DNS_RESOLVER)
+#include <zephyr/net/dns_resolve.h>
+#endif /* CONFIG_DNS_RESOLVER */
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "fast_rejoin.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(fast_rejoin, CONFIG_MQTT_SAMPLE_NETWORK_LOG_LEVEL);
+
+#define SETTINGS_SUBTREE "fast_rejoin"
+
+#define WIFI_EVENT_MASK (NET_EVENT_WIFI_CONNECT_RESULT | NET_EVENT_WIFI_DISCONNECT_RESULT)
+#define L4_EVENT_MASK (NET_EVENT_L4_CONNECTED)
+#define IPV4_EVENT_MASK (NET_EVENT_IPV4_DHCP_BOUND)
+
+/* Access point that the device was last connected to. Kept in settings. */
+struct ap_cache {
+	uint8_t ssid[WIFI_SSID_MAX_LEN];
+	uint8_t ssid_len;
+	uint8_t bssid[WIFI_MAC_ADDR_LEN];
+	uint8_t channel;
+	uint8_t band;
+	uint8_t security;
+	uint8_t mfp;
+};
+
+/* DHCP lease that the device last had from the access point. Kept in settings. */
+struct lease_cache {
+	struct in_addr addr;
+	struct in_addr netmask;
+	struct in_addr gateway;
+	struct in_addr dns;
+	uint32_t lease_time;
+};
+
+static struct ap_cache ap;
+static struct lease_cache lease;
+static bool ap_valid;
+static bool lease_valid;
+
+static struct net_if *wifi_iface;
+static struct fast_rejoin_stats stats;
+static struct net_mgmt_event_callback wifi_cb;
+static struct net_mgmt_event_callback l4_cb;
+static struct net_mgmt_event_callback ipv4_cb;
+
+/* Set while the connection manager is connecting, or a directed association is pending */
+static bool connecting;
+static bool directed;
+static bool lease_applied;
+
+/* Start of the current connection, boot for the first one */
+static int64_t connect_start_ms;
+
+static void full_connect(void);
+static void timeout_work_fn(struct k_work *work);
+static void fallback_work_fn(struct k_work *work);
+static void rejoin_work_fn(struct k_work *work);
+static void ap_save_work_fn(struct k_work *work);
+static void lease_save_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, as net_mgmt requests cannot be made from the
+ * event callbacks.
+ */
+static K_WORK_DELAYABLE_DEFINE(timeout_work, timeout_work_fn);
+static K_WORK_DEFINE(fallback_work, fallback_work_fn);
+static K_WORK_DEFINE(rejoin_work, rejoin_work_fn);
+static K_WORK_DEFINE(ap_save_work, ap_save_work_fn);
+static K_WORK_DEFINE(lease_save_work, lease_save_work_fn);
+
+static int settings_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+	if ((strcmp(key, "ap") == 0) && (len == sizeof(ap))) {
+		ap_valid = (read_cb(cb_arg, &ap, sizeof(ap)) == sizeof(ap));
+		return 0;
+	}
+
+	if ((strcmp(key, "lease") == 0) && (len == sizeof(lease))) {
+		lease_valid = (read_cb(cb_arg, &lease, sizeof(lease)) == sizeof(lease));
+		return 0;
+	}
+
+	/* Entries of an older layout are ignored, and replaced on the next connection */
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(fast_rejoin, SETTINGS_SUBTREE, NULL, settings_set, NULL, NULL);
+
+static const char *path_name(enum fast_rejoin_path path)
+{
+	switch (path) {
+	case FAST_REJOIN_PATH_FAST:
+		return "fast";
+	case FAST_REJOIN_PATH_FULL:
+		return "full";
+	default:
+		return "none";
+	}
+}
+
+static void lease_apply(void)
+{
+	struct net_if_addr *ifaddr;
+
+	if (!lease_valid) {
+		return;
+	}
+
+	/* The address is confirmed, or replaced, by the DHCP client in the background. A device
+	 * has no wall clock at boot, so the lease cannot be checked for expiry here.
+	 */
+	ifaddr = net_if_ipv4_addr_add(wifi_iface, &lease.addr, NET_ADDR_DHCP, lease.lease_time);
+	if (ifaddr == NULL) {
+		LOG_WRN("Cached lease could not be applied");
+		return;
+	}
+
+	(void)net_if_ipv4_set_netmask_by_addr(wifi_iface, &lease.addr, &lease.netmask);
+	net_if_ipv4_set_gw(wifi_iface, &lease.gateway);
+
+#if defined(CONFIG_DNS_RESOLVER)
+	struct sockaddr_in dns = {
+		.sin_family = AF_INET,
+		.sin_port = htons(53),
+		.sin_addr = lease.dns,
+	};
+	const struct sockaddr *servers[] = { (struct sockaddr *)&dns, NULL };
+
+	if (lease.dns.s_addr != 0) {
+		(void)dns_resolve_reconfigure(dns_resolve_get_default(), NULL, servers);
+	}
+#endif /* CONFIG_DNS_RESOLVER */
+
+	lease_applied = true;
+
+	LOG_DBG("Cached lease applied");
+}
+
+static void directed_connect(void)
+{
+	int err;
+	struct wifi_credentials_personal creds = { 0 };
+	struct wifi_connect_req_params params = {
+		.ssid = ap.ssid,
+		.ssid_length = ap.ssid_len,
+		.channel = ap.channel,
+		.band = ap.band,
+		.security = ap.security,
+		.mfp = ap.mfp,
+		.timeout = SYS_FOREVER_MS,
+	};
+
+	/* The passphrase is not cached, it is taken from the stored credentials of the
+	 * network, so that a network removed from the credentials is not joined.
+	 */
+	err = wifi_credentials_get_by_ssid_personal_struct((const char *)ap.ssid, ap.ssid_len,
+							   &creds);
+	if (err) {
+		LOG_DBG("No credentials for the cached access point, error: %d", err);
+		full_connect();
+		return;
+	}
+
+	if (creds.password_len > 0) {
+		params.psk = (const uint8_t *)creds.password;
+		params.psk_length = creds.password_len;
+	}
+
+	memcpy(params.bssid, ap.bssid, sizeof(params.bssid));
+
+	LOG_INF("Joining the cached access point on channel %u", ap.channel);
+
+	connecting = true;
+	directed = true;
+
+	err = net_mgmt(NET_REQUEST_WIFI_CONNECT, wifi_iface, &params, sizeof(params));
+	if (err) {
+		LOG_WRN("Directed association failed, error: %d", err);
+		stats.fallbacks++;
+		full_connect();
+		return;
+	}
+
+	k_work_reschedule(&timeout_work, K_MSEC(CONFIG_MQTT_SAMPLE_NETWORK_FAST_REJOIN_TIMEOUT_MS));
+}
+
+static void full_connect(void)
+{
+	int err;
+
+	directed = false;
+	connecting = true;
+
+	err = conn_mgr_all_if_connect(true);
+	if (err) {
+		LOG_ERR("conn_mgr_all_if_connect, error: %d", err);
+		connecting = false;
+	}
+}
+
+static void fallback(void)
+{
+	if (!directed) {
+		return;
+	}
+
+	LOG_WRN("Directed association did not complete, scanning");
+
+	stats.fallbacks++;
+
+	if (lease_applied) {
+		(void)net_if_ipv4_addr_rm(wifi_iface, &lease.addr);
+		lease_applied = false;
+	}
+
+	(void)net_mgmt(NET_REQUEST_WIFI_DISCONNECT, wifi_iface, NULL, 0);
+
+	full_connect();
+}
+
+static void timeout_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	fallback();
+}
+
+static void fallback_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_work_cancel_delayable(&timeout_work);
+	fallback();
+}
+
+static void rejoin_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	if (connecting) {
+		return;
+	}
+
+	if (ap_valid) {
+		directed_connect();
+	} else {
+		full_connect();
+	}
+}
+
+static void ap_save_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	struct wifi_iface_status status = { 0 };
+	struct ap_cache current = { 0 };
+
+	err = net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, wifi_iface, &status, sizeof(status));
+	if (err) {
+		LOG_ERR("NET_REQUEST_WIFI_IFACE_STATUS, error: %d", err);
+		return;
+	}
+
+	current.ssid_len = MIN(status.ssid_len, sizeof(current.ssid));
+	memcpy(current.ssid, status.ssid, current.ssid_len);
+	memcpy(current.bssid, status.bssid, sizeof(current.bssid));
+	current.channel = status.channel;
+	current.band = status.band;
+	current.security = status.security;
+	current.mfp = status.mfp;
+
+	/* Written only when changed, to spare the flash */
+	if (ap_valid && (memcmp(&current, &ap, sizeof(ap)) == 0)) {
+		return;
+	}
+
+	err = settings_save_one(SETTINGS_SUBTREE "/ap", &current, sizeof(current));
+	if (err) {
+		LOG_ERR("settings_save_one, error: %d", err);
+		return;
+	}
+
+	ap = current;
+	ap_valid = true;
+
+	LOG_DBG("Access point cached, channel %u", ap.channel);
+}
+
+static void lease_save_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	struct lease_cache current = {
+		.addr = wifi_iface->config.dhcpv4.requested_ip,
+		.netmask = wifi_iface->config.dhcpv4.netmask,
+		.gateway = wifi_iface->config.ip.ipv4->gw,
+		.lease_time = wifi_iface->config.dhcpv4.lease_time,
+	};
+
+#if defined(CONFIG_DNS_RESOLVER)
+	struct dns_resolve_context *ctx = dns_resolve_get_default();
+
+	if (ctx->servers[0].dns_server.sa_family == AF_INET) {
+		current.dns = net_sin(&ctx->servers[0].dns_server)->sin_addr;
+	}
+#endif /* CONFIG_DNS_RESOLVER */
+
+	/* The cached address was not handed out again, the server has moved on */
+	if (lease_applied && !net_ipv4_addr_cmp(&current.addr, &lease.addr)) {
+		LOG_WRN("Cached lease rejected, using the new lease");
+		(void)net_if_ipv4_addr_rm(wifi_iface, &lease.addr);
+		stats.lease_rejected++;
+	}
+
+	lease_applied = false;
+
+	if (lease_valid && (memcmp(&current, &lease, sizeof(lease)) == 0)) {
+		return;
+	}
+
+	err = settings_save_one(SETTINGS_SUBTREE "/lease", &current, sizeof(current));
+	if (err) {
+		LOG_ERR("settings_save_one, error: %d", err);
+		return;
+	}
+
+	lease = current;
+	lease_valid = true;
+
+	LOG_DBG("DHCP lease cached");
+}
+
+static void wifi_event_handler(struct net_mgmt_event_callback *cb, uint32_t event,
+			       struct net_if *iface)
+{
+	const struct wifi_status *status = (const struct wifi_status *)cb->info;
+
+	switch (event) {
+	case NET_EVENT_WIFI_CONNECT_RESULT:
+		if (!directed) {
+			break;
+		}
+
+		if (status->status) {
+			k_work_submit(&fallback_work);
+			break;
+		}
+
+		/* Associated, the cached lease makes the interface usable right away */
+		k_work_cancel_delayable(&timeout_work);
+		lease_apply();
+		(void)net_dhcpv4_start(iface);
+		break;
+	case NET_EVENT_WIFI_DISCONNECT_RESULT:
+		if (connecting || (wifi_iface == NULL)) {
+			break;
+		}
+
+		/* The link was lost. Measured from here to the next L4 connection. */
+		connect_start_ms = k_uptime_get();
+		k_work_submit(&rejoin_work);
+		break;
+	default:
+		break;
+	}
+}
+
+static void l4_event_handler(struct net_mgmt_event_callback *cb, uint32_t event,
+			     struct net_if *iface)
+{
+	ARG_UNUSED(cb);
+	ARG_UNUSED(iface);
+
+	if ((event != NET_EVENT_L4_CONNECTED) || !connecting) {
+		return;
+	}
+
+	stats.path = directed ? FAST_REJOIN_PATH_FAST : FAST_REJOIN_PATH_FULL;
+	stats.connect_ms = k_uptime_get() - connect_start_ms;
+
+	if (directed) {
+		stats.fast_connects++;
+	} else {
+		stats.full_connects++;
+	}
+
+	LOG_INF("L4 connected %u ms after %s, %s path", stats.connect_ms,
+		(connect_start_ms == 0) ? "boot" : "link loss", path_name(stats.path));
+
+	connecting = false;
+	directed = false;
+
+	k_work_submit(&ap_save_work);
+}
+
+static void ipv4_event_handler(struct net_mgmt_event_callback *cb, uint32_t event,
+			       struct net_if *iface)
+{
+	ARG_UNUSED(cb);
+
+	if ((event != NET_EVENT_IPV4_DHCP_BOUND) || (iface != wifi_iface)) {
+		return;
+	}
+
+	k_work_submit(&lease_save_work);
+}
+
+int fast_rejoin_connect(struct net_if *iface)
+{
+	int err;
+
+	if (wifi_iface == NULL) {
+		wifi_iface = iface;
+
+		net_mgmt_init_event_callback(&wifi_cb, wifi_event_handler, WIFI_EVENT_MASK);
+		net_mgmt_add_event_callback(&wifi_cb);
+		net_mgmt_init_event_callback(&l4_cb, l4_event_handler, L4_EVENT_MASK);
+		net_mgmt_add_event_callback(&l4_cb);
+		net_mgmt_init_event_callback(&ipv4_cb, ipv4_event_handler, IPV4_EVENT_MASK);
+		net_mgmt_add_event_callback(&ipv4_cb);
+
+		err = settings_subsys_init();
+		if (err) {
+			LOG_ERR("settings_subsys_init, error: %d", err);
+			return err;
+		}
+
+		err = settings_load_subtree(SETTINGS_SUBTREE);
+		if (err) {
+			LOG_ERR("settings_load_subtree, error: %d", err);
+			return err;
+		}
+	}
+
+	if (ap_valid) {
+		directed_connect();
+	} else {
+		full_connect();
+	}
+
+	return connecting ? 0 : -EIO;
+}
+
+void fast_rejoin_stats_get(struct fast_rejoin_stats *out)
+{
+	*out = stats;
+}
+
+int fast_rejoin_clear(void)
+{
+	int err;
+
+	err = settings_delete(SETTINGS_SUBTREE "/ap");
+	if (err) {
+		return err;
+	}
+
+	err = settings_delete(SETTINGS_SUBTREE "/lease");
+	if (err) {
+		return err;
+	}
+
+	ap_valid = false;
+	lease_valid = false;
+
+	return 0;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (ap_valid) {
+		shell_print(sh, "Cached access point: %.*s, channel %u", ap.ssid_len, ap.ssid,
+			    ap.channel);
+	} else {
+		shell_print(sh, "No cached access point");
+	}
+
+	if (lease_valid) {
+		char addr[NET_IPV4_ADDR_LEN];
+
+		shell_print(sh, "Cached lease: %s, %u s",
+			    net_addr_ntop(AF_INET, &lease.addr, addr, sizeof(addr)),
+			    lease.lease_time);
+	} else {
+		shell_print(sh, "No cached lease");
+	}
+
+	shell_print(sh, "Last connection: %s path, %u ms", path_name(stats.path),
+		    stats.connect_ms);
+	shell_print(sh, "Connections: %u fast, %u full, %u fallbacks, %u leases rejected",
+		    stats.fast_connects, stats.full_connects, stats.fallbacks,
+		    stats.lease_rejected);
+
+	return 0;
+}
+
+static int cmd_clear(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int err = fast_rejoin_clear();
+
+	if (err) {
+		shell_error(sh, "fast_rejoin_clear, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_fast_rejoin,
+	SHELL_CMD(show, NULL, "Show the cached access point, lease and timing", cmd_show),
+	SHELL_CMD(clear, NULL, "Clear the cached access point and lease", cmd_clear),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(fast_rejoin, &sub_fast_rejoin, "Fast Wi-Fi rejoin", NULL);
+#endif /* CONFIG_SHELL */
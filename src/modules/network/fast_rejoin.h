@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _FAST_REJOIN_H_
+#define _FAST_REJOIN_H_
+
+#include <stdint.h>
+#include <zephyr/net/net_if.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Path that the last connection was made on */
+enum fast_rejoin_path {
+	FAST_REJOIN_PATH_NONE,
+	/* Directed association to the cached access point, with the cached DHCP lease */
+	FAST_REJOIN_PATH_FAST,
+	/* Scan and association by the connection manager, with a new DHCP lease */
+	FAST_REJOIN_PATH_FULL,
+};
+
+struct fast_rejoin_stats {
+	enum fast_rejoin_path path;
+	/* Time from boot, or from the loss of the link, to L4 connectivity */
+	uint32_t connect_ms;
+	uint32_t fast_connects;
+	uint32_t full_connects;
+	uint32_t fallbacks;
+	uint32_t lease_rejected;
+};
+
+/**
+ * @brief Connect to the network.
+ *
+ * Associates with the access point that the device was last connected to, on its cached
+ * BSSID and channel, and applies the cached DHCP lease, so that L4 connectivity does not wait
+ * for a scan and a DHCP exchange. Falls back to connecting with conn_mgr_all_if_connect(),
+ * which scans for all stored networks, when there is no cached access point, when the
+ * directed association fails, or when it does not complete in time.
+ *
+ * The access point and the lease are cached in settings each time the device connects.
+ *
+ * @param iface Wi-Fi interface, brought up.
+ *
+ * @retval 0 if the connection was started.
+ * @return Negative error code otherwise.
+ */
+int fast_rejoin_connect(struct net_if *iface);
+
+/**
+ * @brief Get the connection statistics.
+ *
+ * @param stats Statistics.
+ */
+void fast_rejoin_stats_get(struct fast_rejoin_stats *stats);
+
+/**
+ * @brief Clear the cached access point and DHCP lease.
+ *
+ * @retval 0 on success.
+ * @return Negative error code otherwise.
+ */
+int fast_rejoin_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FAST_REJOIN_H_ */
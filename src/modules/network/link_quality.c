@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#if defined(CONFIG_WIFI)
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/wifi_mgmt.h>
+#endif /* CONFIG_WIFI */
+#if defined(CONFIG_MODEM_INFO)
+#include <modem/modem_info.h>
+#endif /* CONFIG_MODEM_INFO */
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "message_channel.h"
+#include "link_quality.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(link_quality, CONFIG_MQTT_SAMPLE_NETWORK_LOG_LEVEL);
+
+#define GOOD_DBM CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_GOOD_DBM
+#define POOR_DBM CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_POOR_DBM
+#define HYSTERESIS_DB CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_HYSTERESIS_DB
+
+static const char *const level_names[] = {
+	[LINK_QUALITY_UNKNOWN] = "unknown",
+	[LINK_QUALITY_POOR] = "poor",
+	[LINK_QUALITY_FAIR] = "fair",
+	[LINK_QUALITY_GOOD] = "good",
+};
+
+/* Last sample, only written from the sample work */
+static struct link_quality current;
+static bool sampling;
+
+static void sample_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, samples the link periodically while connected */
+static K_WORK_DELAYABLE_DEFINE(sample_work, sample_work_fn);
+
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM)
+/* Signal level forced from the shell, 0 to follow the simulated profile */
+static int16_t sim_forced_dbm;
+static uint32_t sim_seed = CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM_SEED;
+
+static uint32_t sim_rand(void)
+{
+	sim_seed ^= sim_seed << 13;
+	sim_seed ^= sim_seed >> 17;
+	sim_seed ^= sim_seed << 5;
+
+	return sim_seed;
+}
+
+/* Alternates between a good and a poor link every half period, with jitter, so that deferral
+ * and the deferral deadline can be exercised without a radio.
+ */
+static int dbm_sample(int16_t *dbm)
+{
+	int64_t period_ms = CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM_PERIOD_SECONDS *
+			    MSEC_PER_SEC;
+	bool poor = (k_uptime_get() % period_ms) >= (period_ms / 2);
+	int16_t base = poor ? (POOR_DBM - 10) : (GOOD_DBM + 10);
+
+	if (sim_forced_dbm) {
+		*dbm = sim_forced_dbm;
+		return 0;
+	}
+
+	*dbm = base + (int16_t)(sim_rand() % 7) - 3;
+
+	return 0;
+}
+#elif defined(CONFIG_WIFI)
+/* RSSI of the beacons from the access point */
+static int dbm_sample(int16_t *dbm)
+{
+	int err;
+	struct wifi_iface_status status = { 0 };
+	struct net_if *iface = net_if_get_first_wifi();
+
+	if (iface == NULL) {
+		return -ENODEV;
+	}
+
+	err = net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status, sizeof(status));
+	if (err) {
+		LOG_DBG("NET_REQUEST_WIFI_IFACE_STATUS, error: %d", err);
+		return err;
+	}
+
+	if (status.state < WIFI_STATE_ASSOCIATED) {
+		return -ENOTCONN;
+	}
+
+	*dbm = status.rssi;
+
+	return 0;
+}
+#elif defined(CONFIG_MODEM_INFO)
+/* RSRP of the serving cell */
+static int dbm_sample(int16_t *dbm)
+{
+	int err;
+	int rsrp;
+	static bool initialized;
+
+	if (!initialized) {
+		err = modem_info_init();
+		if (err) {
+			LOG_ERR("modem_info_init, error: %d", err);
+			return err;
+		}
+
+		initialized = true;
+	}
+
+	err = modem_info_get_rsrp(&rsrp);
+	if (err) {
+		LOG_DBG("modem_info_get_rsrp, error: %d", err);
+		return err;
+	}
+
+	*dbm = rsrp;
+
+	return 0;
+}
+#else
+static int dbm_sample(int16_t *dbm)
+{
+	ARG_UNUSED(dbm);
+
+	return -ENOTSUP;
+}
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM */
+
+/* Level of a sample. A level is only left once the signal is past its threshold by the
+ * hysteresis, so that a signal close to a threshold does not flap.
+ */
+static enum link_quality_level level_get(int16_t dbm, enum link_quality_level previous)
+{
+	int good = GOOD_DBM;
+	int poor = POOR_DBM;
+
+	if (previous == LINK_QUALITY_GOOD) {
+		good -= HYSTERESIS_DB;
+	} else if (previous == LINK_QUALITY_POOR) {
+		poor += HYSTERESIS_DB;
+	}
+
+	if (dbm >= good) {
+		return LINK_QUALITY_GOOD;
+	} else if (dbm < poor) {
+		return LINK_QUALITY_POOR;
+	}
+
+	return LINK_QUALITY_FAIR;
+}
+
+static void publish(void)
+{
+	int err;
+
+	err = zbus_chan_pub(&LINK_QUALITY_CHAN, &current, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_pub, error: %d", err);
+	}
+}
+
+static void sample_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	int16_t dbm;
+	enum link_quality_level level;
+
+	if (!sampling) {
+		return;
+	}
+
+	err = dbm_sample(&dbm);
+	if (err) {
+		/* Not available yet, or not anymore, reported as unknown */
+		current.level = LINK_QUALITY_UNKNOWN;
+	} else {
+		level = level_get(dbm, current.level);
+		if (level != current.level) {
+			LOG_INF("Link quality %s, %d dBm", level_names[level], dbm);
+		}
+
+		current.dbm = dbm;
+		current.level = level;
+	}
+
+	/* Published on every sample, so that observers can act on deadlines at this pace */
+	publish();
+
+	k_work_reschedule(&sample_work,
+			  K_SECONDS(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_INTERVAL_SECONDS));
+}
+
+void link_quality_start(void)
+{
+	sampling = true;
+	k_work_reschedule(&sample_work, K_NO_WAIT);
+}
+
+void link_quality_stop(void)
+{
+	sampling = false;
+	k_work_cancel_delayable(&sample_work);
+
+	current.level = LINK_QUALITY_UNKNOWN;
+	publish();
+}
+
+void link_quality_get(struct link_quality *quality)
+{
+	*quality = current;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct link_quality quality;
+
+	link_quality_get(&quality);
+
+	shell_print(sh, "Link quality: %s, %d dBm, thresholds: good %d dBm, poor %d dBm",
+		    level_names[quality.level], quality.dbm, GOOD_DBM, POOR_DBM);
+
+	return 0;
+}
+
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM)
+static int cmd_sim(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+
+	if (strcmp(argv[1], "auto") == 0) {
+		sim_forced_dbm = 0;
+	} else {
+		sim_forced_dbm = (int16_t)strtol(argv[1], NULL, 10);
+		if (sim_forced_dbm >= 0) {
+			shell_error(sh, "Signal level must be negative, in dBm");
+			sim_forced_dbm = 0;
+			return -EINVAL;
+		}
+	}
+
+	k_work_reschedule(&sample_work, K_NO_WAIT);
+
+	return 0;
+}
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM */
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_link_quality,
+	SHELL_CMD(show, NULL, "Show the last link quality sample", cmd_show),
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM)
+	SHELL_CMD_ARG(sim, NULL, "Force the simulated signal level: <dBm>|auto", cmd_sim, 2, 0),
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY_SIM */
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(link_quality, &sub_link_quality, "Link quality", NULL);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _LINK_QUALITY_H_
+#define _LINK_QUALITY_H_
+
+#include "message_channel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start sampling the link quality. The first sample is taken right away, and each
+ *	  sample is published on the link quality channel.
+ */
+void link_quality_start(void);
+
+/**
+ * @brief Stop sampling the link quality, and publish LINK_QUALITY_UNKNOWN.
+ */
+void link_quality_stop(void);
+
+/**
+ * @brief Get the last sample.
+ *
+ * @param quality Last sample, LINK_QUALITY_UNKNOWN if not sampling.
+ */
+void link_quality_get(struct link_quality *quality);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LINK_QUALITY_H_ */
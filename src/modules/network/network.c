@@ -7,47 +7,82 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/zbus/zbus.h>
+#include <zephyr/smf.h>
 #include <zephyr/net/conn_mgr_connectivity.h>
 #include <zephyr/net/conn_mgr_monitor.h>
 #include <zephyr/net/dhcpv4.h>
+#include <zephyr/net/net_event.h>
 
 #include "message_channel.h"
+#include "executor.h"
+#include "boot_timeline.h"
+
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_FAST_REJOIN)
+#include "fast_rejoin.h"
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_FAST_REJOIN */
+
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY)
+#include "link_quality.h"
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY */
 
 /* Register log module */
 LOG_MODULE_REGISTER(network, CONFIG_MQTT_SAMPLE_NETWORK_LOG_LEVEL);
 
-/* Subscribe to provisioning channel if wifi provisioning is enabled */
-#if IS_ENABLED(CONFIG_SOFTAP_WIFI_PROVISION_MODULE)
-static bool provisioning_completed = false;
-static bool provisioning_in_progress = false;
-ZBUS_SUBSCRIBER_DEFINE(network, 4);
+/* Events from the connection manager, handled by the module's state machine so that they are
+ * serialized with the provisioning status. net_mgmt callbacks only forward them.
+ */
+enum network_event {
+	NETWORK_EVENT_L4_CONNECTED,
+	NETWORK_EVENT_L4_DISCONNECTED,
+};
 
-static void provisioning_status_handler(const struct zbus_channel *chan)
-{
-	int err;
-	enum provisioning_status status;
+/* Connectivity event, and the interface that it is for */
+struct network_event_msg {
+	enum network_event type;
+	struct net_if *iface;
+};
 
-	err = zbus_chan_read(chan, &status, K_MSEC(500));
-	if (err) {
-		LOG_ERR("Failed to read provisioning status: %d", err);
-		return;
-	}
+ZBUS_CHAN_DEFINE(NETWORK_EVENT_CHAN,
+		 struct network_event_msg,
+		 NULL,
+		 NULL,
+		 ZBUS_OBSERVERS(network),
+		 ZBUS_MSG_INIT(0)
+);
 
-	switch (status) {
-	case PROVISIONING_IN_PROGRESS:
-		LOG_INF("Provisioning in progress, blocking network events");
-		provisioning_in_progress = true;
-		break;
-	case PROVISIONING_COMPLETED:
-		LOG_INF("Provisioning completed, starting network connection");
-		provisioning_completed = true;
-		provisioning_in_progress = false;
-		break;
-	default:
-		break;
-	}
-}
-#endif
+/* Forward declarations */
+static const struct smf_state state[];
+
+/* Internal states */
+enum module_state {
+	/* Waiting for stored credentials, or for provisioning to start */
+	NETWORK_IDLE,
+	/* Provisioning in SoftAP mode, connectivity events are those of the SoftAP */
+	NETWORK_PROVISIONING,
+	NETWORK_CONNECTING,
+	NETWORK_L4_CONNECTED,
+	NETWORK_L4_DISCONNECTED,
+};
+
+/* User defined state object.
+ * Used to transfer data between state changes.
+ */
+static struct s_object {
+	/* This must be first */
+	struct smf_ctx ctx;
+
+	/* Last channel type that a message was received on */
+	const struct zbus_channel *chan;
+
+	/* Last connectivity event */
+	struct network_event_msg event;
+
+	/* Last provisioning status */
+	enum provisioning_status provisioning;
+
+	/* Time that provisioning completed, in ticks of uptime, 0 if not measured */
+	int64_t provisioned_ticks;
+} s_obj;
 
 /* Macros used to subscribe to specific Zephyr NET management events. */
 #define L4_EVENT_MASK (NET_EVENT_L4_CONNECTED | NET_EVENT_L4_DISCONNECTED)
@@ -57,48 +92,44 @@ static void provisioning_status_handler(const struct zbus_channel *chan)
 static struct net_mgmt_event_callback l4_cb;
 static struct net_mgmt_event_callback conn_cb;
 
+#if defined(CONFIG_MQTT_SAMPLE_BOOT_TIMELINE)
+static struct net_mgmt_event_callback ipv4_cb;
+
+static void ipv4_event_handler(struct net_mgmt_event_callback *cb,
+			       uint32_t event,
+			       struct net_if *iface)
+{
+	if (event == NET_EVENT_IPV4_DHCP_BOUND) {
+		boot_timeline_mark(BOOT_PHASE_DHCP_BOUND);
+	}
+}
+#endif /* CONFIG_MQTT_SAMPLE_BOOT_TIMELINE */
+
 static void l4_event_handler(struct net_mgmt_event_callback *cb,
 			     uint32_t event,
 			     struct net_if *iface)
 {
 	int err;
-	enum network_status status;
+	struct network_event_msg network_event = {
+		.iface = iface,
+	};
 
 	switch (event) {
 	case NET_EVENT_L4_CONNECTED:
-#if IS_ENABLED(CONFIG_SOFTAP_WIFI_PROVISION_MODULE)
-		if (provisioning_in_progress) {
-			LOG_INF("L4 connected during provisioning (SoftAP mode) - not publishing network event");
-			return;
-		}
-#endif
-		LOG_INF("Network connectivity established");
-		status = NETWORK_CONNECTED;
-		
-		/* Start the DHCPv4 client after connecting to the network.
-		 * This is needed to get a dynamic IPv4 address from the AP's DHCPv4 server.
-		 */
-		net_dhcpv4_start(iface);
+		network_event.type = NETWORK_EVENT_L4_CONNECTED;
 		break;
 	case NET_EVENT_L4_DISCONNECTED:
-#if IS_ENABLED(CONFIG_SOFTAP_WIFI_PROVISION_MODULE)
-		if (provisioning_in_progress) {
-			LOG_INF("L4 disconnected during provisioning - not publishing network event");
-			return;
-		}
-#endif
-		LOG_INF("Network connectivity lost");
-		status = NETWORK_DISCONNECTED;
+		network_event.type = NETWORK_EVENT_L4_DISCONNECTED;
 		break;
 	default:
 		/* Don't care */
 		return;
 	}
 
-	err = zbus_chan_pub(&NETWORK_CHAN, &status, K_SECONDS(1));
+	err = zbus_chan_pub(&NETWORK_EVENT_CHAN, &network_event, K_SECONDS(1));
 	if (err) {
 		LOG_ERR("zbus_chan_pub, error: %d", err);
-		SEND_FATAL_ERROR();
+		SEND_FATAL_ERROR_CODE(err);
 	}
 }
 
@@ -113,60 +144,97 @@ static void connectivity_event_handler(struct net_mgmt_event_callback *cb,
 	}
 }
 
-static void network_task(void)
+static void network_status_publish(enum network_status status)
 {
 	int err;
 
-	/* Setup handler for Zephyr NET Connection Manager events. */
-	net_mgmt_init_event_callback(&l4_cb, l4_event_handler, L4_EVENT_MASK);
-	net_mgmt_add_event_callback(&l4_cb);
+	err = zbus_chan_pub(&NETWORK_CHAN, &status, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_pub, error: %d", err);
+		SEND_FATAL_ERROR_CODE(err);
+	}
+}
 
-	/* Setup handler for Zephyr NET Connection Manager Connectivity layer. */
-	net_mgmt_init_event_callback(&conn_cb, connectivity_event_handler, CONN_LAYER_EVENT_MASK);
-	net_mgmt_add_event_callback(&conn_cb);
+/* Connect all interfaces, or rejoin the cached access point if fast rejoin is enabled */
+static int network_if_connect(void)
+{
+#if defined(CONFIG_MQTT_SAMPLE_NETWORK_FAST_REJOIN)
+	return fast_rejoin_connect(net_if_get_first_wifi());
+#else
+	return conn_mgr_all_if_connect(true);
+#endif /* CONFIG_MQTT_SAMPLE_NETWORK_FAST_REJOIN */
+}
 
-#if IS_ENABLED(CONFIG_SOFTAP_WIFI_PROVISION_MODULE)
-	/* If wifi provisioning is enabled, wait for it to complete before connecting */
-	LOG_INF("Waiting for WiFi provisioning to complete");
-	
-	while (!provisioning_completed) {
-		/* Check for provisioning channel messages */
-		const struct zbus_channel *chan;
-		if (zbus_sub_wait(&network, &chan, K_MSEC(1000)) == 0) {
-			provisioning_status_handler(chan);
-		}
+/* Transitions shared by the states in which the device is a station */
+static void station_run(struct s_object *user_object)
+{
+	if ((user_object->chan == &PROVISIONING_CHAN) &&
+	    (user_object->provisioning == PROVISIONING_IN_PROGRESS)) {
+		/* Provisioning restarted, the connection is replaced by the SoftAP */
+		smf_set_state(SMF_CTX(user_object), &state[NETWORK_PROVISIONING]);
+		return;
 	}
-	
-	/* After provisioning is complete, connect to the network */
-	err = conn_mgr_all_if_connect(true);
-	if (err) {
-		LOG_ERR("conn_mgr_all_if_connect, error: %d", err);
-		SEND_FATAL_ERROR();
+
+	if (user_object->chan != &NETWORK_EVENT_CHAN) {
 		return;
 	}
-#endif
 
-	/* Connecting to the configured connectivity layer.
-	 * Wi-Fi or LTE depending on the board that the sample was built for.
-	 */
-	LOG_INF("Bringing network interface up and connecting to the network");
+	if (user_object->event.type == NETWORK_EVENT_L4_CONNECTED) {
+		smf_set_state(SMF_CTX(user_object), &state[NETWORK_L4_CONNECTED]);
+	} else {
+		smf_set_state(SMF_CTX(user_object), &state[NETWORK_L4_DISCONNECTED]);
+	}
+}
 
-	err = conn_mgr_all_if_up(true);
-	if (err) {
-		LOG_ERR("conn_mgr_all_if_up, error: %d", err);
-		SEND_FATAL_ERROR();
+/* Zephyr State Machine framework handlers */
+
+/* Function executed when the module is in the idle or provisioning state. */
+static void provisioning_run(void *o)
+{
+	struct s_object *user_object = o;
+
+	if (user_object->chan != &PROVISIONING_CHAN) {
 		return;
 	}
 
-#if !IS_ENABLED(CONFIG_SOFTAP_WIFI_PROVISION_MODULE)
-	/* Only connect immediately if wifi provisioning is not enabled */
-	err = conn_mgr_all_if_connect(true);
+	switch (user_object->provisioning) {
+	case PROVISIONING_IN_PROGRESS:
+		LOG_INF("Provisioning in progress, connectivity events are not published");
+		smf_set_state(SMF_CTX(user_object), &state[NETWORK_PROVISIONING]);
+		break;
+	case PROVISIONING_COMPLETED:
+		LOG_INF("Provisioning completed, starting network connection");
+		smf_set_state(SMF_CTX(user_object), &state[NETWORK_CONNECTING]);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Function executed when the module enters the connecting state. */
+static void connecting_entry(void *o)
+{
+	struct s_object *user_object = o;
+	int err;
+
+	if (user_object->provisioned_ticks) {
+		LOG_INF("Connecting %u us after provisioning completed",
+			(uint32_t)k_ticks_to_us_floor64(k_uptime_ticks() -
+							user_object->provisioned_ticks));
+		user_object->provisioned_ticks = 0;
+	}
+
+	/* Connecting to the configured connectivity layer.
+	 * Wi-Fi or LTE depending on the board that the sample was built for.
+	 */
+	LOG_INF("Connecting to the network");
+
+	err = network_if_connect();
 	if (err) {
-		LOG_ERR("conn_mgr_all_if_connect, error: %d", err);
-		SEND_FATAL_ERROR();
+		LOG_ERR("network_if_connect, error: %d", err);
+		SEND_FATAL_ERROR_CODE(err);
 		return;
 	}
-#endif
 
 	/* Resend connection status if the sample is built for Native Sim.
 	 * This is necessary because the network interface is automatically brought up
@@ -179,6 +247,158 @@ static void network_task(void)
 	}
 }
 
-K_THREAD_DEFINE(network_task_id,
-		CONFIG_MQTT_SAMPLE_NETWORK_THREAD_STACK_SIZE,
-		network_task, NULL, NULL, NULL, 3, 0, 0);
+/* Function executed when the module is in the connecting or disconnected state. */
+static void station_disconnected_run(void *o)
+{
+	station_run(o);
+}
+
+/* Function executed when the module enters the connected state. */
+static void connected_entry(void *o)
+{
+	struct s_object *user_object = o;
+
+	LOG_INF("Network connectivity established");
+
+	boot_timeline_mark(BOOT_PHASE_L4_CONNECTED);
+
+	/* Start the DHCPv4 client after connecting to the network.
+	 * This is needed to get a dynamic IPv4 address from the AP's DHCPv4 server.
+	 */
+	net_dhcpv4_start(user_object->event.iface);
+
+	network_status_publish(NETWORK_CONNECTED);
+
+	IF_ENABLED(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY, (link_quality_start()));
+}
+
+/* Function executed when the module is in the connected state. */
+static void connected_run(void *o)
+{
+	struct s_object *user_object = o;
+
+	/* Already connected. Leaving and re-entering the state would report a spurious
+	 * disconnection and restart DHCP.
+	 */
+	if ((user_object->chan == &NETWORK_EVENT_CHAN) &&
+	    (user_object->event.type == NETWORK_EVENT_L4_CONNECTED)) {
+		return;
+	}
+
+	station_run(o);
+}
+
+/* Function executed when the module exits the connected state. */
+static void connected_exit(void *o)
+{
+	ARG_UNUSED(o);
+
+	LOG_INF("Network connectivity lost");
+
+	IF_ENABLED(CONFIG_MQTT_SAMPLE_NETWORK_LINK_QUALITY, (link_quality_stop()));
+
+	network_status_publish(NETWORK_DISCONNECTED);
+}
+
+/* Construct state table */
+static const struct smf_state state[] = {
+	[NETWORK_IDLE] = SMF_CREATE_STATE(NULL, provisioning_run, NULL, NULL, NULL),
+	[NETWORK_PROVISIONING] = SMF_CREATE_STATE(NULL, provisioning_run, NULL, NULL, NULL),
+	[NETWORK_CONNECTING] = SMF_CREATE_STATE(connecting_entry, station_disconnected_run, NULL,
+						NULL, NULL),
+	[NETWORK_L4_CONNECTED] = SMF_CREATE_STATE(connected_entry, connected_run, connected_exit,
+						  NULL, NULL),
+	[NETWORK_L4_DISCONNECTED] = SMF_CREATE_STATE(NULL, station_disconnected_run, NULL, NULL,
+						     NULL),
+};
+
+static int network_init(void)
+{
+	/* Setup handler for Zephyr NET Connection Manager events. */
+	net_mgmt_init_event_callback(&l4_cb, l4_event_handler, L4_EVENT_MASK);
+	net_mgmt_add_event_callback(&l4_cb);
+
+	/* Setup handler for Zephyr NET Connection Manager Connectivity layer. */
+	net_mgmt_init_event_callback(&conn_cb, connectivity_event_handler, CONN_LAYER_EVENT_MASK);
+	net_mgmt_add_event_callback(&conn_cb);
+
+#if defined(CONFIG_MQTT_SAMPLE_BOOT_TIMELINE)
+	net_mgmt_init_event_callback(&ipv4_cb, ipv4_event_handler, NET_EVENT_IPV4_DHCP_BOUND);
+	net_mgmt_add_event_callback(&ipv4_cb);
+#endif /* CONFIG_MQTT_SAMPLE_BOOT_TIMELINE */
+
+#if IS_ENABLED(CONFIG_SOFTAP_WIFI_PROVISION_MODULE)
+	/* The interface is brought up by the wifi provisioning module. Connect once it reports
+	 * that credentials are available.
+	 */
+	LOG_INF("Waiting for WiFi provisioning to complete");
+
+	smf_set_initial(SMF_CTX(&s_obj), &state[NETWORK_IDLE]);
+#else
+	int err;
+
+	LOG_INF("Bringing network interface up");
+
+	err = conn_mgr_all_if_up(true);
+	if (err) {
+		LOG_ERR("conn_mgr_all_if_up, error: %d", err);
+		SEND_FATAL_ERROR_CODE(err);
+		return err;
+	}
+
+	boot_timeline_mark(BOOT_PHASE_IF_UP);
+
+	smf_set_initial(SMF_CTX(&s_obj), &state[NETWORK_CONNECTING]);
+#endif
+
+	return 0;
+}
+
+static void network_handler(const struct zbus_channel *chan)
+{
+	int err;
+
+	s_obj.chan = chan;
+
+	if (&NETWORK_EVENT_CHAN == chan) {
+		err = zbus_chan_read(chan, &s_obj.event, K_SECONDS(1));
+		if (err) {
+			LOG_ERR("zbus_chan_read, error: %d", err);
+			SEND_FATAL_ERROR_CODE(err);
+			return;
+		}
+	}
+
+	if (&PROVISIONING_CHAN == chan) {
+		err = zbus_chan_read(chan, &s_obj.provisioning, K_SECONDS(1));
+		if (err) {
+			LOG_ERR("zbus_chan_read, error: %d", err);
+			SEND_FATAL_ERROR_CODE(err);
+			return;
+		}
+
+		if (s_obj.provisioning == PROVISIONING_COMPLETED) {
+#if defined(CONFIG_ZBUS_CHANNEL_PUBLISH_STATS)
+			/* Measured from the publication, including the time that it was queued */
+			s_obj.provisioned_ticks = zbus_chan_pub_stats_last_time(chan);
+#else
+			s_obj.provisioned_ticks = k_uptime_ticks();
+#endif /* CONFIG_ZBUS_CHANNEL_PUBLISH_STATS */
+		}
+	}
+
+	err = smf_run_state(SMF_CTX(&s_obj));
+	if (err) {
+		LOG_ERR("smf_run_state, error: %d", err);
+		SEND_FATAL_ERROR_CODE(err);
+		return;
+	}
+}
+
+/* Register subscriber, or listener if the module runs on the executor. The module observes
+ * its connectivity event channel, and the provisioning channel.
+ */
+EXECUTOR_MODULE_DEFINE(network, 4,
+		       network_init, network_handler,
+		       CONFIG_MQTT_SAMPLE_NETWORK_THREAD_STACK_SIZE, 3,
+		       CONFIG_MQTT_SAMPLE_NETWORK_EXECUTOR_QUEUE);
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/wifi_mgmt.h>
+#if defined(CONFIG_NET_STATISTICS_USER_API)
+#include <zephyr/net/net_stats.h>
+#endif /* CONFIG_NET_STATISTICS_USER_API */
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "message_channel.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(power_save, CONFIG_MQTT_SAMPLE_POWER_SAVE_LOG_LEVEL);
+
+/* Events recorded by the zbus listener, and handled by the policy work */
+enum power_save_event {
+	EVENT_ACTIVITY,
+	EVENT_NETWORK,
+	EVENT_PROVISIONING_STARTED,
+	EVENT_PROVISIONING_COMPLETED,
+};
+
+static const char *const mode_names[POWER_SAVE_MODE_COUNT] = {
+	[POWER_SAVE_ACTIVE] = "active",
+	[POWER_SAVE_DTIM] = "dtim",
+	[POWER_SAVE_LISTEN_INTERVAL] = "listen_interval",
+};
+
+static atomic_t events;
+
+/* Policy state, only accessed from the policy work */
+static struct {
+	enum power_save_mode mode;
+	bool applied;
+	bool connected;
+	bool provisioning;
+	int64_t last_activity_ms;
+	int64_t hold_until_ms;
+	uint32_t packets;
+
+	/* Time spent in each mode, up to the last change */
+	int64_t mode_since_ms;
+	uint64_t mode_ms[POWER_SAVE_MODE_COUNT];
+	uint32_t changes;
+} policy;
+
+static void policy_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, so that no thread sleeps through the hold time */
+static K_WORK_DELAYABLE_DEFINE(policy_work, policy_work_fn);
+
+/* Packets sent and received on the interface, 0 if packet statistics are not available */
+static uint32_t packets_get(struct net_if *iface)
+{
+#if defined(CONFIG_NET_STATISTICS_USER_API) && defined(CONFIG_NET_STATISTICS_IPV4)
+	struct net_stats_ip ip;
+
+	if (net_mgmt(NET_REQUEST_STATS_GET_IPV4, iface, &ip, sizeof(ip)) == 0) {
+		return ip.recv + ip.sent;
+	}
+#else
+	ARG_UNUSED(iface);
+#endif /* CONFIG_NET_STATISTICS_USER_API && CONFIG_NET_STATISTICS_IPV4 */
+
+	return 0;
+}
+
+static int mode_apply(struct net_if *iface, enum power_save_mode mode)
+{
+	int err;
+	struct wifi_ps_params params = {
+		.type = WIFI_PS_PARAM_STATE,
+		.enabled = (mode == POWER_SAVE_ACTIVE) ? WIFI_PS_DISABLED : WIFI_PS_ENABLED,
+	};
+
+	err = net_mgmt(NET_REQUEST_WIFI_PS, iface, &params, sizeof(params));
+	if (err) {
+		LOG_ERR("NET_REQUEST_WIFI_PS, error: %d", err);
+		return err;
+	}
+
+	if (mode == POWER_SAVE_ACTIVE) {
+		return 0;
+	}
+
+	params.type = WIFI_PS_PARAM_WAKEUP_MODE;
+	params.wakeup_mode = (mode == POWER_SAVE_DTIM) ? WIFI_PS_WAKEUP_MODE_DTIM :
+							 WIFI_PS_WAKEUP_MODE_LISTEN_INTERVAL;
+
+	err = net_mgmt(NET_REQUEST_WIFI_PS, iface, &params, sizeof(params));
+	if (err) {
+		LOG_ERR("NET_REQUEST_WIFI_PS, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+static void mode_set(struct net_if *iface, enum power_save_mode mode, int64_t now)
+{
+	int err;
+
+	err = mode_apply(iface, mode);
+	if (err) {
+		/* Retried at the next evaluation */
+		policy.applied = false;
+		return;
+	}
+
+	policy.applied = true;
+
+	if (mode == policy.mode) {
+		return;
+	}
+
+	policy.mode_ms[policy.mode] += now - policy.mode_since_ms;
+	policy.mode_since_ms = now;
+	policy.mode = mode;
+	policy.changes++;
+
+	LOG_INF("Power save mode: %s", mode_names[mode]);
+
+	err = zbus_chan_pub(&POWER_SAVE_CHAN, &mode, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_pub, error: %d", err);
+	}
+}
+
+static enum power_save_mode mode_select(int64_t now)
+{
+	int64_t idle_ms = now - policy.last_activity_ms;
+
+	if ((now < policy.hold_until_ms) ||
+	    (idle_ms < CONFIG_MQTT_SAMPLE_POWER_SAVE_DTIM_IDLE_MS)) {
+		return POWER_SAVE_ACTIVE;
+	}
+
+	if ((CONFIG_MQTT_SAMPLE_POWER_SAVE_LISTEN_IDLE_SECONDS > 0) &&
+	    (idle_ms >= (CONFIG_MQTT_SAMPLE_POWER_SAVE_LISTEN_IDLE_SECONDS * MSEC_PER_SEC))) {
+		return POWER_SAVE_LISTEN_INTERVAL;
+	}
+
+	return POWER_SAVE_DTIM;
+}
+
+static void policy_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	int64_t now = k_uptime_get();
+	struct net_if *iface = net_if_get_first_wifi();
+	uint32_t packets;
+
+	if (atomic_test_and_clear_bit(&events, EVENT_ACTIVITY)) {
+		policy.last_activity_ms = now;
+	}
+
+	if (atomic_test_and_clear_bit(&events, EVENT_PROVISIONING_STARTED)) {
+		policy.provisioning = true;
+	}
+
+	/* Clients confirm provisioning by discovering the device with mDNS, which is
+	 * unreliable in power save. Not needed on boots that found stored credentials.
+	 */
+	if (atomic_test_and_clear_bit(&events, EVENT_PROVISIONING_COMPLETED) &&
+	    policy.provisioning) {
+		policy.provisioning = false;
+		policy.hold_until_ms = now +
+			(CONFIG_MQTT_SAMPLE_POWER_SAVE_PROVISIONED_HOLD_SECONDS * MSEC_PER_SEC);
+	}
+
+	if (atomic_test_and_clear_bit(&events, EVENT_NETWORK)) {
+		enum network_status status;
+
+		err = zbus_chan_read(&NETWORK_CHAN, &status, K_MSEC(100));
+		if (err) {
+			LOG_ERR("zbus_chan_read, error: %d", err);
+		} else {
+			policy.connected = (status == NETWORK_CONNECTED);
+
+			/* The driver's power save state is set again on each connection */
+			policy.applied = false;
+			policy.last_activity_ms = now;
+		}
+	}
+
+	/* Power save only applies to a station connected to an access point */
+	if (!policy.connected || (iface == NULL)) {
+		return;
+	}
+
+	packets = packets_get(iface);
+	if ((packets - policy.packets) > CONFIG_MQTT_SAMPLE_POWER_SAVE_ACTIVITY_PACKETS) {
+		policy.last_activity_ms = now;
+	}
+	policy.packets = packets;
+
+	if (!policy.applied || (mode_select(now) != policy.mode)) {
+		mode_set(iface, mode_select(now), now);
+	}
+
+	k_work_reschedule(&policy_work, K_MSEC(CONFIG_MQTT_SAMPLE_POWER_SAVE_EVAL_INTERVAL_MS));
+}
+
+static void power_save_listener_cb(const struct zbus_channel *chan)
+{
+	if (chan == &PAYLOAD_CHAN) {
+		/* A publish is pending, the radio is needed now */
+		atomic_set_bit(&events, EVENT_ACTIVITY);
+	} else if (chan == &NETWORK_CHAN) {
+		atomic_set_bit(&events, EVENT_NETWORK);
+	} else if (chan == &PROVISIONING_CHAN) {
+		const enum provisioning_status *status = zbus_chan_const_msg(chan);
+
+		if (*status == PROVISIONING_IN_PROGRESS) {
+			atomic_set_bit(&events, EVENT_PROVISIONING_STARTED);
+		} else if (*status == PROVISIONING_COMPLETED) {
+			atomic_set_bit(&events, EVENT_PROVISIONING_COMPLETED);
+		}
+	}
+
+	k_work_reschedule(&policy_work, K_NO_WAIT);
+}
+
+ZBUS_LISTENER_DEFINE(power_save, power_save_listener_cb);
+
+static int power_save_init(void)
+{
+	int err;
+	const struct zbus_channel *chans[] = { &PAYLOAD_CHAN, &NETWORK_CHAN, &PROVISIONING_CHAN };
+
+	policy.mode = POWER_SAVE_ACTIVE;
+
+	/* Added at runtime, as the module is optional */
+	for (size_t i = 0; i < ARRAY_SIZE(chans); i++) {
+		err = zbus_chan_add_obs(chans[i], &power_save, K_SECONDS(1));
+		if (err) {
+			LOG_ERR("zbus_chan_add_obs, error: %d", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+SYS_INIT(power_save_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int64_t now = k_uptime_get();
+	uint64_t total_ms = 0;
+	uint64_t mode_ms[POWER_SAVE_MODE_COUNT];
+
+	/* Read without locking, a change in between only skews the current mode's time */
+	for (size_t i = 0; i < POWER_SAVE_MODE_COUNT; i++) {
+		mode_ms[i] = policy.mode_ms[i];
+	}
+
+	mode_ms[policy.mode] += now - policy.mode_since_ms;
+
+	for (size_t i = 0; i < POWER_SAVE_MODE_COUNT; i++) {
+		total_ms += mode_ms[i];
+	}
+
+	shell_print(sh, "Mode: %s, %u changes, %s", mode_names[policy.mode], policy.changes,
+		    policy.connected ? "connected" : "not connected");
+
+	for (size_t i = 0; i < POWER_SAVE_MODE_COUNT; i++) {
+		shell_print(sh, "%-16s %10llu ms %3u %%", mode_names[i], mode_ms[i],
+			    total_ms ? (uint32_t)((mode_ms[i] * 100) / total_ms) : 0);
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_power_save,
+	SHELL_CMD(show, NULL, "Show the mode and the time spent in each mode", cmd_show),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(power_save, &sub_power_save, "Wi-Fi power save policy", NULL);
+#endif /* CONFIG_SHELL */
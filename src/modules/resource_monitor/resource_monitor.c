@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdarg.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/sys_heap.h>
+
+#if defined(CONFIG_NET_NATIVE)
+#include <zephyr/net/net_pkt.h>
+#endif /* CONFIG_NET_NATIVE */
+
+#if defined(CONFIG_MBEDTLS_MEMORY_DEBUG) && defined(CONFIG_MBEDTLS_ENABLE_HEAP)
+#include <mbedtls/memory_buffer_alloc.h>
+#endif /* CONFIG_MBEDTLS_MEMORY_DEBUG && CONFIG_MBEDTLS_ENABLE_HEAP */
+
+#include "message_channel.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(resource_monitor, CONFIG_MQTT_SAMPLE_RESOURCE_MONITOR_LOG_LEVEL);
+
+/* Telemetry is sent as one line of text per resource kind, for example:
+ *
+ *	stk sampler:412/1024 transport:1880/2048!
+ *	heap 0:1024/2048/8192
+ *	net rx:12/14 tx:14/14 rxd:30/36 txd:36/36
+ *	tls 12800/31000/65536
+ *
+ * Stacks are reported as used/size, heaps as used/peak/size and network pools as
+ * min-free/count. A '!' marks a resource used beyond the warning threshold. Lines that do not
+ * fit in one message are continued in the next message, which starts with the same kind.
+ */
+
+/* Maximum length of one item in a telemetry line */
+#define ITEM_MAX_SIZE 48
+
+static void sample_work_fn(struct k_work *work);
+
+/* Sample work - Runs on the system workqueue, as sampling is short and infrequent. */
+static K_WORK_DELAYABLE_DEFINE(sample_work, sample_work_fn);
+
+static struct telemetry telemetry;
+static size_t telemetry_len;
+static const char *telemetry_kind;
+
+static void telemetry_flush(void)
+{
+	int err;
+
+	/* Nothing but the kind */
+	if (telemetry_len <= strlen(telemetry_kind)) {
+		return;
+	}
+
+	err = telemetry_publish(&telemetry, K_SECONDS(1));
+	if (err) {
+		LOG_WRN("telemetry_publish, error: %d", err);
+	}
+
+	telemetry_len = 0;
+}
+
+static void telemetry_begin(const char *kind)
+{
+	telemetry_kind = kind;
+	telemetry_len = snprintk(telemetry.string, sizeof(telemetry.string), "%s", kind);
+}
+
+static void telemetry_add(const char *fmt, ...)
+{
+	char item[ITEM_MAX_SIZE];
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintk(item, sizeof(item), fmt, args);
+	va_end(args);
+
+	if ((len < 0) || (len >= sizeof(item))) {
+		return;
+	}
+
+	if ((telemetry_len + len) >= sizeof(telemetry.string)) {
+		telemetry_flush();
+		telemetry_begin(telemetry_kind);
+	}
+
+	memcpy(&telemetry.string[telemetry_len], item, len + 1);
+	telemetry_len += len;
+}
+
+/* Returns true, and logs a warning, if used is beyond the warning threshold of size. */
+static bool budget_check(const char *kind, const char *name, size_t used, size_t size)
+{
+	uint64_t limit = (uint64_t)size * CONFIG_MQTT_SAMPLE_RESOURCE_MONITOR_WARN_PERCENT;
+
+	if ((size == 0) || (((uint64_t)used * 100) < limit)) {
+		return false;
+	}
+
+	LOG_WRN("%s %s near exhaustion: %zu of %zu used", kind, name, used, size);
+
+	return true;
+}
+
+static void stack_sample(const struct k_thread *thread, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	struct k_thread *t = (struct k_thread *)thread;
+	const char *name = k_thread_name_get(t);
+	char id[sizeof("0x") + 2 * sizeof(uintptr_t)];
+	size_t size = t->stack_info.size;
+	size_t unused;
+	size_t used;
+
+	if (k_thread_stack_space_get(t, &unused)) {
+		return;
+	}
+
+	if ((name == NULL) || (name[0] == '\0')) {
+		snprintk(id, sizeof(id), "%p", (void *)t);
+		name = id;
+	}
+
+	used = size - unused;
+
+	telemetry_add(" %.24s:%zu/%zu%s", name, used, size,
+		      budget_check("Stack", name, used, size) ? "!" : "");
+}
+
+static void stacks_report(void)
+{
+	telemetry_begin("stk");
+
+	/* The unlocked variant is used as the callback publishes on the telemetry channel. */
+	k_thread_foreach_unlocked(stack_sample, NULL);
+
+	telemetry_flush();
+}
+
+static void heaps_report(void)
+{
+#if defined(CONFIG_SYS_HEAP_ARRAY_SIZE) && (CONFIG_SYS_HEAP_ARRAY_SIZE > 0)
+	struct sys_heap **heaps;
+	int count = sys_heap_array_get(&heaps);
+
+	telemetry_begin("heap");
+
+	/* Heaps have no names, they are told apart by their size. The Wi-Fi driver heaps are
+	 * included, as they are sys_heaps as well.
+	 */
+	for (int i = 0; i < count; i++) {
+		struct sys_memory_stats stats;
+		char name[sizeof("255")];
+		size_t size;
+
+		if (sys_heap_runtime_stats_get(heaps[i], &stats)) {
+			continue;
+		}
+
+		snprintk(name, sizeof(name), "%d", i);
+		size = stats.allocated_bytes + stats.free_bytes;
+
+		telemetry_add(" %s:%zu/%zu/%zu%s", name, stats.allocated_bytes,
+			      stats.max_allocated_bytes, size,
+			      budget_check("Heap", name, stats.max_allocated_bytes,
+					   size) ? "!" : "");
+	}
+
+	telemetry_flush();
+#endif /* CONFIG_SYS_HEAP_ARRAY_SIZE > 0 */
+}
+
+#if defined(CONFIG_NET_NATIVE)
+static void slab_add(const char *name, struct k_mem_slab *slab)
+{
+	uint32_t count = slab->info.num_blocks;
+	uint32_t max_used = k_mem_slab_max_used_get(slab);
+
+	telemetry_add(" %s:%u/%u%s", name, count - max_used, count,
+		      budget_check("Packet slab", name, max_used, count) ? "!" : "");
+}
+
+static void pool_add(const char *name, struct net_buf_pool *pool, uint16_t *min_free)
+{
+	uint16_t avail = atomic_get(&pool->avail_count);
+
+	/* Pools only track how many buffers are available now, so the minimum is the lowest
+	 * seen when sampling.
+	 */
+	*min_free = MIN(*min_free, avail);
+
+	telemetry_add(" %s:%u/%u%s", name, *min_free, pool->buf_count,
+		      budget_check("Buffer pool", name, pool->buf_count - *min_free,
+				   pool->buf_count) ? "!" : "");
+}
+#endif /* CONFIG_NET_NATIVE */
+
+static void net_report(void)
+{
+#if defined(CONFIG_NET_NATIVE)
+	static uint16_t rx_data_min_free = UINT16_MAX;
+	static uint16_t tx_data_min_free = UINT16_MAX;
+	struct k_mem_slab *rx;
+	struct k_mem_slab *tx;
+	struct net_buf_pool *rx_data;
+	struct net_buf_pool *tx_data;
+
+	net_pkt_get_info(&rx, &tx, &rx_data, &tx_data);
+
+	telemetry_begin("net");
+
+	slab_add("rx", rx);
+	slab_add("tx", tx);
+	pool_add("rxd", rx_data, &rx_data_min_free);
+	pool_add("txd", tx_data, &tx_data_min_free);
+
+	telemetry_flush();
+#endif /* CONFIG_NET_NATIVE */
+}
+
+static void tls_report(void)
+{
+#if defined(CONFIG_MBEDTLS_MEMORY_DEBUG) && defined(CONFIG_MBEDTLS_ENABLE_HEAP)
+	size_t cur_used;
+	size_t cur_blocks;
+	size_t max_used;
+	size_t max_blocks;
+
+	mbedtls_memory_buffer_alloc_cur_get(&cur_used, &cur_blocks);
+	mbedtls_memory_buffer_alloc_max_get(&max_used, &max_blocks);
+
+	telemetry_begin("tls");
+	telemetry_add(" %zu/%zu/%u%s", cur_used, max_used, CONFIG_MBEDTLS_HEAP_SIZE,
+		      budget_check("mbedTLS", "heap", max_used,
+				   CONFIG_MBEDTLS_HEAP_SIZE) ? "!" : "");
+	telemetry_flush();
+#endif /* CONFIG_MBEDTLS_MEMORY_DEBUG && CONFIG_MBEDTLS_ENABLE_HEAP */
+}
+
+static void sample_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	stacks_report();
+	heaps_report();
+	net_report();
+	tls_report();
+
+	k_work_reschedule(&sample_work,
+			  K_SECONDS(CONFIG_MQTT_SAMPLE_RESOURCE_MONITOR_INTERVAL_SECONDS));
+}
+
+static int resource_monitor_init(void)
+{
+	k_work_reschedule(&sample_work,
+			  K_SECONDS(CONFIG_MQTT_SAMPLE_RESOURCE_MONITOR_INTERVAL_SECONDS));
+
+	return 0;
+}
+
+SYS_INIT(resource_monitor_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/printk.h>
+
+#include <posix_native_task.h>
+#include <posix_board_if.h>
+#include <cmdline.h>
+
+#include "message_channel.h"
+#include "msg_trace.h"
+#include "bench_clock.h"
+#include "replay_native.h"
+
+#define REPLAY_FORMAT_STRING "{\"ts\":%lld,\"value\":%s}"
+
+/* Time to wait for the transport module to read the previous sample. If the transport module
+ * misses the notification, the sample is published anyway once this has passed.
+ */
+#define REPLAY_PUBLISH_TIMEOUT K_SECONDS(1)
+
+/* Register log module */
+LOG_MODULE_REGISTER(replay, CONFIG_MQTT_SAMPLE_SAMPLER_LOG_LEVEL);
+
+/* Parameters of the replay. Set from Kconfig, and from the command line. */
+static struct {
+	char *file;
+	uint32_t speed_percent;
+	bool free_run;
+} params = {
+	.file = CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY_FILE,
+	.speed_percent = CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY_SPEED_PERCENT,
+	.free_run = IS_ENABLED(CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY_FREE_RUN),
+};
+
+/* Given once the transport module has connected to the broker */
+static K_SEM_DEFINE(start_sem, 0, 1);
+
+/* Payloads are large, so the message is not kept on the thread's stack. */
+static struct payload payload;
+
+static void report(uint32_t records, int64_t span_ms, uint64_t wall_ns)
+{
+	uint32_t wall_ms = wall_ns / NSEC_PER_MSEC;
+	uint32_t speedup_x100 = wall_ms ? ((uint64_t)span_ms * 100) / wall_ms : 0;
+	char stages[MSG_TRACE_STAGE_COUNT * 48];
+	size_t len = 0;
+
+	/* Throughput of each stage, over the whole replay including the drain time */
+	for (size_t stage = 0; stage < MSG_TRACE_STAGE_COUNT; stage++) {
+		uint32_t count = msg_trace_reached_get(stage);
+		uint32_t per_sec_x100 = 0;
+
+		if (wall_ns > 0) {
+			per_sec_x100 = ((uint64_t)count * 100 * NSEC_PER_SEC) / wall_ns;
+		}
+
+		len += snprintk(&stages[len], sizeof(stages) - len,
+				"%s\"%s\":{\"count\":%u,\"per_sec\":%u.%02u}",
+				(stage == 0) ? "" : ",", msg_trace_stage_name(stage), count,
+				per_sec_x100 / 100, per_sec_x100 % 100);
+	}
+
+	/* printk(), so that the result is available with logging disabled */
+	printk("REPLAY_RESULT {\"file\":\"%s\",\"free_run\":%s,\"speed_percent\":%u,"
+	       "\"records\":%u,\"span_ms\":%lld,\"wall_ms\":%u,\"speedup\":%u.%02u,"
+	       "\"stages\":{%s}}\n",
+	       params.file, params.free_run ? "true" : "false", params.speed_percent, records,
+	       span_ms, wall_ms, speedup_x100 / 100, speedup_x100 % 100, stages);
+}
+
+static void replay(void)
+{
+	int err;
+	int64_t ts_ms;
+	int64_t first_ts_ms = 0;
+	int64_t last_ts_ms = 0;
+	int64_t start_ms = k_uptime_get();
+	uint64_t start_ns = bench_clock_ns();
+	uint32_t records = 0;
+	uint32_t skipped = 0;
+	double value;
+	char text[32];
+
+	err = replay_native_open(params.file);
+	if (err) {
+		LOG_ERR("Cannot open trace file %s", params.file);
+		return;
+	}
+
+	LOG_INF("Replaying %s, %s", params.file, params.free_run ? "free running" : "timed");
+
+	msg_trace_reset();
+
+	while (replay_native_next(&ts_ms, &value, text, sizeof(text)) == 0) {
+		uint16_t id;
+
+		if (records + skipped == 0) {
+			first_ts_ms = ts_ms;
+		}
+
+		if (!params.free_run) {
+			/* Scheduled from the start of the replay, so the timing does not drift */
+			int64_t due_ms = start_ms +
+					 ((ts_ms - first_ts_ms) * 100) / params.speed_percent;
+
+			k_sleep(K_TIMEOUT_ABS_MS(due_ms));
+		}
+
+		/* Started once the sample is due, so that latencies do not include the wait */
+		id = msg_trace_start();
+
+		snprintk(payload.string, sizeof(payload.string), REPLAY_FORMAT_STRING, ts_ms, text);
+		payload.series = PAYLOAD_SERIES_UPTIME;
+		payload.timestamp = ts_ms;
+		payload.value = value;
+		payload.trace_id = id;
+
+		msg_trace_mark(id, MSG_TRACE_SAMPLED);
+
+		/* Blocks until the transport module has read the previous sample, which throttles
+		 * the replay to the rate of the pipeline when free running.
+		 */
+		err = payload_publish(&payload, REPLAY_PUBLISH_TIMEOUT);
+		if (err == -EAGAIN) {
+			/* The channel stayed busy, skip the sample but not the rest of the trace */
+			LOG_WRN("Sample %u not published in time, skipped", records + skipped);
+			skipped++;
+			continue;
+		} else if (err) {
+			LOG_ERR("payload_publish, error: %d", err);
+			break;
+		}
+
+		msg_trace_mark(id, MSG_TRACE_PUBLISHED);
+
+		last_ts_ms = ts_ms;
+		records++;
+	}
+
+	replay_native_close();
+
+	LOG_INF("Replayed %u samples, %u skipped, waiting for the last acknowledgements", records,
+		skipped);
+
+	k_sleep(K_SECONDS(CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY_DRAIN_SECONDS));
+
+	report(records, last_ts_ms - first_ts_ms, bench_clock_ns() - start_ns);
+}
+
+static void replay_thread(void)
+{
+	k_sem_take(&start_sem, K_FOREVER);
+
+	replay();
+
+#if defined(CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY_EXIT)
+	posix_exit(0);
+#endif /* CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY_EXIT */
+}
+
+/* Lowest priority, so that the modules downstream run as soon as a sample is published */
+K_THREAD_DEFINE(replay_thread_id, CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY_STACK_SIZE,
+		replay_thread, NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+static void replay_listener_cb(const struct zbus_channel *chan)
+{
+	const enum transport_status *status = zbus_chan_const_msg(chan);
+
+	/* The replay starts once, on the first connection to the broker */
+	if (*status == TRANSPORT_CONNECTED) {
+		k_sem_give(&start_sem);
+	}
+}
+
+ZBUS_LISTENER_DEFINE(replay_listener, replay_listener_cb);
+
+static int replay_init(void)
+{
+	int err;
+
+	params.speed_percent = MAX(params.speed_percent, 1);
+
+	/* Added at runtime, as the replay is optional */
+	err = zbus_chan_add_obs(&TRANSPORT_CHAN, &replay_listener, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_add_obs, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+SYS_INIT(replay_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+static void replay_args_add(void)
+{
+	static struct args_struct_t args[] = {
+		{
+			.option = "replay-file",
+			.name = "path",
+			.type = 's',
+			.dest = (void *)&params.file,
+			.descript = "Recorded sample trace to replay",
+		},
+		{
+			.option = "replay-speed",
+			.name = "percent",
+			.type = 'u',
+			.dest = (void *)&params.speed_percent,
+			.descript = "Replay speed in percent of the recorded timing",
+		},
+		{
+			.is_switch = true,
+			.option = "replay-free-run",
+			.type = 'b',
+			.dest = (void *)&params.free_run,
+			.descript = "Replay as fast as the pipeline takes the samples",
+		},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(args);
+}
+
+NATIVE_TASK(replay_args_add, PRE_BOOT_1, 10);
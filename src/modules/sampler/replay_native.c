@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* This file is compiled as part of the native simulator runner and has access to the
+ * host's C library.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay_native.h"
+
+static FILE *file;
+
+int replay_native_open(const char *path)
+{
+	file = fopen(path, "r");
+
+	return file ? 0 : -1;
+}
+
+int replay_native_next(int64_t *ts_ms, double *value, char *text, int text_size)
+{
+	char line[256];
+
+	if (file == NULL) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		char *field;
+		char *end;
+		size_t len;
+
+		*ts_ms = strtoll(line, &field, 10);
+		if ((field == line) || (*field != ',')) {
+			/* Header, comment or blank line */
+			continue;
+		}
+
+		field++;
+		field += strspn(field, " \t");
+
+		len = strcspn(field, "\r\n");
+		while ((len > 0) && ((field[len - 1] == ' ') || (field[len - 1] == '\t'))) {
+			len--;
+		}
+		field[len] = '\0';
+
+		*value = strtod(field, &end);
+		if (end == field) {
+			continue;
+		}
+
+		snprintf(text, text_size, "%s", field);
+
+		return 0;
+	}
+
+	return 1;
+}
+
+void replay_native_close(void)
+{
+	if (file) {
+		fclose(file);
+		file = NULL;
+	}
+}
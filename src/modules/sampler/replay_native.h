@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _REPLAY_NATIVE_H_
+#define _REPLAY_NATIVE_H_
+
+/* Reader of recorded sample traces on the host file system.
+ *
+ * Implemented on the host side of the native simulator, see replay_native.c, so only types
+ * shared by the host and the embedded C library are used.
+ *
+ * A trace is a CSV file with one sample per line, as a timestamp in milliseconds followed by
+ * the sampled value: "<timestamp>,<value>". Lines that do not start with a timestamp, such as
+ * a header or comments, are skipped. Timestamps must not decrease.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Open a trace file.
+ *
+ *  @return 0 If successful, -1 if the file could not be opened.
+ */
+int replay_native_open(const char *path);
+
+/** @brief Read the next sample of the trace.
+ *
+ *  @param ts_ms Timestamp of the sample, in milliseconds.
+ *  @param value Sampled value.
+ *  @param text Buffer that the value is copied to as recorded, NUL terminated.
+ *  @param text_size Size of the text buffer.
+ *
+ *  @return 0 If a sample was read, 1 at the end of the trace, -1 if no trace is open.
+ */
+int replay_native_next(int64_t *ts_ms, double *value, char *text, int text_size);
+
+/** @brief Close the trace file. */
+void replay_native_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _REPLAY_NATIVE_H_ */
@@ -9,16 +9,15 @@
 #include <zephyr/zbus/zbus.h>
 
 #include "message_channel.h"
+#include "executor.h"
+#include "msg_trace.h"
 
 #define FORMAT_STRING "Hello MQTT! Current uptime is: %d"
 
 /* Register log module */
 LOG_MODULE_REGISTER(sampler, CONFIG_MQTT_SAMPLE_SAMPLER_LOG_LEVEL);
 
-/* Register subscriber */
-ZBUS_SUBSCRIBER_DEFINE(sampler, CONFIG_MQTT_SAMPLE_SAMPLER_MESSAGE_QUEUE_SIZE);
-
-static void sample(void)
+static void sample(uint16_t trace_id)
 {
 	struct payload payload = { 0 };
 	uint32_t uptime = k_uptime_get_32();
@@ -35,24 +34,55 @@ static void sample(void)
 		return;
 	}
 
+#if defined(CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE)
+	payload.series = PAYLOAD_SERIES_UPTIME;
+	payload.timestamp = uptime;
+	payload.value = uptime;
+#endif /* CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE */
+
+#if defined(CONFIG_MQTT_SAMPLE_MSG_TRACE)
+	payload.trace_id = trace_id;
+#endif /* CONFIG_MQTT_SAMPLE_MSG_TRACE */
+
+	msg_trace_mark(trace_id, MSG_TRACE_SAMPLED);
+
 	err = zbus_chan_pub(&PAYLOAD_CHAN, &payload, K_SECONDS(1));
 	if (err) {
 		LOG_ERR("zbus_chan_pub, error:%d", err);
-		SEND_FATAL_ERROR();
+		SEND_FATAL_ERROR_CODE(err);
+		return;
 	}
+
+	msg_trace_mark(trace_id, MSG_TRACE_PUBLISHED);
 }
 
-static void sampler_task(void)
+static int sampler_init(void)
 {
-	const struct zbus_channel *chan;
+	return 0;
+}
+
+static void sampler_handler(const struct zbus_channel *chan)
+{
+	if (&TRIGGER_CHAN == chan) {
+		int trace_id = 0;
 
-	while (!zbus_sub_wait(&sampler, &chan, K_FOREVER)) {
-		if (&TRIGGER_CHAN == chan) {
-			sample();
+		/* Samples come from the recorded trace instead, see replay.c */
+		if (IS_ENABLED(CONFIG_MQTT_SAMPLE_SAMPLER_REPLAY)) {
+			return;
 		}
+
+		if (IS_ENABLED(CONFIG_MQTT_SAMPLE_MSG_TRACE) &&
+		    zbus_chan_read(&TRIGGER_CHAN, &trace_id, K_SECONDS(1))) {
+			trace_id = 0;
+		}
+
+		sample(trace_id);
 	}
 }
 
-K_THREAD_DEFINE(sampler_task_id,
-		CONFIG_MQTT_SAMPLE_SAMPLER_THREAD_STACK_SIZE,
-		sampler_task, NULL, NULL, NULL, 3, 0, 0);
+/* Register subscriber, or listener if the module runs on the executor */
+EXECUTOR_MODULE_DEFINE(sampler,
+		       CONFIG_MQTT_SAMPLE_SAMPLER_MESSAGE_QUEUE_SIZE,
+		       sampler_init, sampler_handler,
+		       CONFIG_MQTT_SAMPLE_SAMPLER_THREAD_STACK_SIZE, 3,
+		       CONFIG_MQTT_SAMPLE_SAMPLER_EXECUTOR_QUEUE);
@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "scan_cache.h"
+#include "scan_source.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(scan_cache, CONFIG_MQTT_SAMPLE_SCAN_CACHE_LOG_LEVEL);
+
+#define MAX_AGE_MS (CONFIG_MQTT_SAMPLE_SCAN_CACHE_MAX_AGE_SECONDS * MSEC_PER_SEC)
+
+/* Access points, strongest first */
+static struct scan_cache_entry cache[CONFIG_MQTT_SAMPLE_SCAN_CACHE_SIZE];
+static size_t count;
+static struct scan_cache_stats stats;
+static K_MUTEX_DEFINE(lock);
+
+static bool running;
+static bool scanning;
+
+static int64_t scan_start_ms;
+static int64_t scan_done_ms;
+
+static void refresh_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, starting the background scans */
+static K_WORK_DELAYABLE_DEFINE(refresh_work, refresh_work_fn);
+
+/* Move an entry to its place in the RSSI order, after its RSSI changed or it was added */
+static void entry_sort(size_t index)
+{
+	struct scan_cache_entry entry = cache[index];
+
+	while ((index > 0) && (cache[index - 1].rssi < entry.rssi)) {
+		cache[index] = cache[index - 1];
+		index--;
+	}
+
+	while ((index + 1 < count) && (cache[index + 1].rssi > entry.rssi)) {
+		cache[index] = cache[index + 1];
+		index++;
+	}
+
+	cache[index] = entry;
+}
+
+/* Drop access points that have not been seen for the maximum age. Called with the lock held. */
+static void cache_age(int64_t now)
+{
+	size_t kept = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if ((now - cache[i].seen_ms) > MAX_AGE_MS) {
+			stats.expired++;
+			continue;
+		}
+
+		cache[kept++] = cache[i];
+	}
+
+	count = kept;
+}
+
+void scan_cache_result_add(const struct scan_cache_entry *entry)
+{
+	size_t i;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	stats.results++;
+
+	for (i = 0; i < count; i++) {
+		if (memcmp(cache[i].bssid, entry->bssid, sizeof(entry->bssid)) == 0) {
+			break;
+		}
+	}
+
+	if (i == count) {
+		if (count < ARRAY_SIZE(cache)) {
+			count++;
+		} else if (entry->rssi > cache[count - 1].rssi) {
+			/* Full, the weakest access point makes room */
+			i = count - 1;
+		} else {
+			k_mutex_unlock(&lock);
+			return;
+		}
+
+		stats.added++;
+	}
+
+	/* Seen again, the entry is refreshed in place */
+	cache[i] = *entry;
+	cache[i].seen_ms = k_uptime_get();
+
+	entry_sort(i);
+
+	k_mutex_unlock(&lock);
+}
+
+void scan_cache_scan_done(int status)
+{
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	scanning = false;
+
+	if (status) {
+		stats.scan_failures++;
+		LOG_WRN("Scan failed, status: %d", status);
+	} else {
+		stats.scans++;
+		stats.scan_last_ms = now - scan_start_ms;
+		stats.scan_total_ms += stats.scan_last_ms;
+		scan_done_ms = now;
+	}
+
+	cache_age(now);
+
+	LOG_DBG("Scan done in %u ms, %zu access points cached", stats.scan_last_ms, count);
+
+	k_mutex_unlock(&lock);
+
+	if (running) {
+		k_work_reschedule(&refresh_work,
+				  K_SECONDS(CONFIG_MQTT_SAMPLE_SCAN_CACHE_REFRESH_SECONDS));
+	}
+}
+
+int scan_cache_refresh(void)
+{
+	int err;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (scanning) {
+		k_mutex_unlock(&lock);
+		return -EBUSY;
+	}
+
+	scanning = true;
+	scan_start_ms = k_uptime_get();
+
+	k_mutex_unlock(&lock);
+
+	err = scan_source_start();
+	if (err) {
+		LOG_ERR("scan_source_start, error: %d", err);
+		scan_cache_scan_done(err);
+		return err;
+	}
+
+	return 0;
+}
+
+static void refresh_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	(void)scan_cache_refresh();
+}
+
+int scan_cache_start(void)
+{
+	static bool initialized;
+	int err;
+
+	if (!initialized) {
+		err = scan_source_init();
+		if (err) {
+			LOG_ERR("scan_source_init, error: %d", err);
+			return err;
+		}
+
+		initialized = true;
+	}
+
+	running = true;
+	k_work_reschedule(&refresh_work, K_NO_WAIT);
+
+	return 0;
+}
+
+void scan_cache_stop(void)
+{
+	running = false;
+	k_work_cancel_delayable(&refresh_work);
+}
+
+size_t scan_cache_get(struct scan_cache_entry *entries, size_t max)
+{
+	size_t n;
+	bool fresh;
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	cache_age(now);
+
+	n = MIN(count, max);
+	memcpy(entries, cache, n * sizeof(entries[0]));
+
+	fresh = (count > 0) && (scan_done_ms != 0) && ((now - scan_done_ms) <= MAX_AGE_MS);
+	if (fresh) {
+		stats.hits++;
+	} else {
+		stats.misses++;
+	}
+
+	k_mutex_unlock(&lock);
+
+	if (!fresh && running) {
+		(void)scan_cache_refresh();
+	}
+
+	return n;
+}
+
+void scan_cache_stats_get(struct scan_cache_stats *out)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+
+	*out = stats;
+	out->entries = count;
+
+	k_mutex_unlock(&lock);
+}
+
+#if defined(CONFIG_MQTT_SAMPLE_SCAN_CACHE_AUTOSTART)
+static int scan_cache_autostart(void)
+{
+	return scan_cache_start();
+}
+
+SYS_INIT(scan_cache_autostart, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif /* CONFIG_MQTT_SAMPLE_SCAN_CACHE_AUTOSTART */
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	static struct scan_cache_entry entries[CONFIG_MQTT_SAMPLE_SCAN_CACHE_SIZE];
+	int64_t now = k_uptime_get();
+	size_t n = scan_cache_get(entries, ARRAY_SIZE(entries));
+
+	shell_print(sh, "%-32s %-17s %4s %3s %6s", "SSID", "BSSID", "RSSI", "Ch", "Age s");
+
+	for (size_t i = 0; i < n; i++) {
+		shell_print(sh, "%-32s %02x:%02x:%02x:%02x:%02x:%02x %4d %3u %6u",
+			    entries[i].ssid, entries[i].bssid[0], entries[i].bssid[1],
+			    entries[i].bssid[2], entries[i].bssid[3], entries[i].bssid[4],
+			    entries[i].bssid[5], entries[i].rssi, entries[i].channel,
+			    (uint32_t)((now - entries[i].seen_ms) / MSEC_PER_SEC));
+	}
+
+	return 0;
+}
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct scan_cache_stats s;
+
+	scan_cache_stats_get(&s);
+
+	shell_print(sh, "Scans: %u, failed %u, last %u ms, average %u ms", s.scans,
+		    s.scan_failures, s.scan_last_ms,
+		    s.scans ? (uint32_t)(s.scan_total_ms / s.scans) : 0);
+	shell_print(sh, "Results: %u, added %u, expired %u, cached %u", s.results, s.added,
+		    s.expired, s.entries);
+	shell_print(sh, "Listings: %u hits, %u misses", s.hits, s.misses);
+
+	return 0;
+}
+
+static int cmd_refresh(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int err = scan_cache_refresh();
+
+	if (err) {
+		shell_error(sh, "scan_cache_refresh, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+static int cmd_start(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int err = scan_cache_start();
+
+	if (err) {
+		shell_error(sh, "scan_cache_start, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_scan_cache,
+	SHELL_CMD(show, NULL, "List the cached access points", cmd_show),
+	SHELL_CMD(stats, NULL, "Show scan cost and cache hit statistics", cmd_stats),
+	SHELL_CMD(refresh, NULL, "Start a scan now", cmd_refresh),
+	SHELL_CMD(start, NULL, "Start background scanning", cmd_start),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(scan_cache, &sub_scan_cache, "Background Wi-Fi scan cache", NULL);
+#endif /* CONFIG_SHELL */
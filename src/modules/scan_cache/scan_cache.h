@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _SCAN_CACHE_H_
+#define _SCAN_CACHE_H_
+
+/* Background Wi-Fi scan cache.
+ *
+ * Scans run in the background at a fixed interval, and their results are merged into a cache
+ * of access points, deduplicated by BSSID and sorted by RSSI. Access points that have not been
+ * seen for the maximum age are dropped. Listings are served from the cache without waiting for
+ * a scan. On Native Sim, scan results come from a simulated source.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/wifi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct scan_cache_entry {
+	char ssid[WIFI_SSID_MAX_LEN + 1];
+	uint8_t ssid_len;
+	uint8_t bssid[WIFI_MAC_ADDR_LEN];
+	int8_t rssi;
+	uint8_t channel;
+	uint8_t band;
+	uint8_t security;
+
+	/* Uptime that the access point was last seen at */
+	int64_t seen_ms;
+};
+
+struct scan_cache_stats {
+	uint32_t scans;
+	uint32_t scan_failures;
+	/* Duration of the last scan, and of all scans */
+	uint32_t scan_last_ms;
+	uint64_t scan_total_ms;
+	/* Results received, and access points added to and aged out of the cache */
+	uint32_t results;
+	uint32_t added;
+	uint32_t expired;
+	/* Listings served from a fresh cache, and listings that found it empty or stale */
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t entries;
+};
+
+/**
+ * @brief Start background scanning. The first scan is started right away.
+ *
+ * @retval 0 on success.
+ * @return Negative error code otherwise.
+ */
+int scan_cache_start(void);
+
+/**
+ * @brief Stop background scanning. The cache is kept. A scan in progress is not aborted.
+ */
+void scan_cache_stop(void);
+
+/**
+ * @brief Start a scan now, unless one is in progress.
+ *
+ * @retval 0 if a scan was started.
+ * @retval -EBUSY if a scan is in progress.
+ * @return Negative error code otherwise.
+ */
+int scan_cache_refresh(void);
+
+/**
+ * @brief Get the cached access points, strongest first.
+ *
+ * Does not wait for a scan. A stale or empty cache is counted as a miss, and starts a scan if
+ * background scanning is running.
+ *
+ * @param entries Buffer for the access points.
+ * @param max Size of the buffer, in entries.
+ *
+ * @return Number of access points copied.
+ */
+size_t scan_cache_get(struct scan_cache_entry *entries, size_t max);
+
+/**
+ * @brief Get the scan and cache statistics.
+ *
+ * @param stats Statistics.
+ */
+void scan_cache_stats_get(struct scan_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCAN_CACHE_H_ */
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _SCAN_SOURCE_H_
+#define _SCAN_SOURCE_H_
+
+/* Source of scan results for the scan cache. Implemented by the Wi-Fi driver source, and on
+ * Native Sim by the simulated source. The source reports each result with
+ * scan_cache_result_add(), and the end of the scan with scan_cache_scan_done().
+ */
+
+#include "scan_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the scan source.
+ *
+ * @retval 0 on success.
+ * @return Negative error code otherwise.
+ */
+int scan_source_init(void);
+
+/**
+ * @brief Start a scan.
+ *
+ * @retval 0 if the scan was started.
+ * @return Negative error code otherwise.
+ */
+int scan_source_start(void);
+
+/**
+ * @brief Add a scan result to the cache. Called by the source.
+ *
+ * @param entry Access point. The time it was seen at is set by the cache.
+ */
+void scan_cache_result_add(const struct scan_cache_entry *entry);
+
+/**
+ * @brief Report the end of a scan. Called by the source.
+ *
+ * @param status 0 if the scan succeeded, error code otherwise.
+ */
+void scan_cache_scan_done(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCAN_SOURCE_H_ */
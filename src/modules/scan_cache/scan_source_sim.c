@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "scan_source.h"
+
+/* Register log module */
+LOG_MODULE_DECLARE(scan_cache, CONFIG_MQTT_SAMPLE_SCAN_CACHE_LOG_LEVEL);
+
+/* Simulated access points. Each has a base RSSI that results jitter around, and is missing
+ * from some scans, so that the cache sees updates, reorders and ageing.
+ */
+struct sim_ap {
+	uint8_t bssid[WIFI_MAC_ADDR_LEN];
+	int8_t rssi;
+	uint8_t channel;
+	/* Chance in percent that the access point is missing from a scan */
+	uint8_t miss_percent;
+};
+
+static struct sim_ap aps[CONFIG_MQTT_SAMPLE_SCAN_CACHE_SIM_NETWORKS];
+static uint32_t seed = CONFIG_MQTT_SAMPLE_SCAN_CACHE_SIM_SEED;
+
+static void scan_work_fn(struct k_work *work);
+
+/* Work - Delivers the results of a scan once the simulated scan time has passed */
+static K_WORK_DELAYABLE_DEFINE(scan_work, scan_work_fn);
+
+/* Deterministic for a given seed, so that runs can be compared */
+static uint32_t sim_rand(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+static void scan_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	for (size_t i = 0; i < ARRAY_SIZE(aps); i++) {
+		struct scan_cache_entry entry = {
+			.channel = aps[i].channel,
+			.band = WIFI_FREQ_BAND_2_4_GHZ,
+			.security = WIFI_SECURITY_TYPE_PSK,
+		};
+
+		if ((sim_rand() % 100) < aps[i].miss_percent) {
+			continue;
+		}
+
+		entry.rssi = aps[i].rssi + (int8_t)(sim_rand() % 9) - 4;
+		entry.ssid_len = snprintf(entry.ssid, sizeof(entry.ssid), "sim-ap-%02u",
+					  (unsigned int)i);
+		memcpy(entry.bssid, aps[i].bssid, sizeof(entry.bssid));
+
+		scan_cache_result_add(&entry);
+	}
+
+	scan_cache_scan_done(0);
+}
+
+int scan_source_init(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(aps); i++) {
+		aps[i].bssid[0] = 0x02;
+		aps[i].bssid[5] = (uint8_t)i;
+		aps[i].rssi = -40 - (int8_t)(sim_rand() % 50);
+		aps[i].channel = 1 + (sim_rand() % 13);
+		aps[i].miss_percent = (i % 4 == 0) ? 50 : 5;
+	}
+
+	LOG_INF("Simulated scan source, %zu access points", ARRAY_SIZE(aps));
+
+	return 0;
+}
+
+int scan_source_start(void)
+{
+	k_work_reschedule(&scan_work, K_MSEC(CONFIG_MQTT_SAMPLE_SCAN_CACHE_SIM_SCAN_MS));
+
+	return 0;
+}
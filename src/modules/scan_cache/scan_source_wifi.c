@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/wifi_mgmt.h>
+
+#include "scan_source.h"
+
+/* Register log module */
+LOG_MODULE_DECLARE(scan_cache, CONFIG_MQTT_SAMPLE_SCAN_CACHE_LOG_LEVEL);
+
+#define WIFI_EVENT_MASK (NET_EVENT_WIFI_SCAN_RESULT | NET_EVENT_WIFI_SCAN_DONE)
+
+static struct net_mgmt_event_callback wifi_cb;
+
+static void wifi_event_handler(struct net_mgmt_event_callback *cb, uint32_t event,
+			       struct net_if *iface)
+{
+	ARG_UNUSED(iface);
+
+	switch (event) {
+	case NET_EVENT_WIFI_SCAN_RESULT: {
+		const struct wifi_scan_result *result = (const struct wifi_scan_result *)cb->info;
+		struct scan_cache_entry entry = {
+			.ssid_len = MIN(result->ssid_length, WIFI_SSID_MAX_LEN),
+			.rssi = result->rssi,
+			.channel = result->channel,
+			.band = result->band,
+			.security = result->security,
+		};
+
+		/* Hidden networks cannot be listed */
+		if (entry.ssid_len == 0) {
+			break;
+		}
+
+		memcpy(entry.ssid, result->ssid, entry.ssid_len);
+		memcpy(entry.bssid, result->mac, sizeof(entry.bssid));
+
+		scan_cache_result_add(&entry);
+		break;
+	}
+	case NET_EVENT_WIFI_SCAN_DONE: {
+		const struct wifi_status *status = (const struct wifi_status *)cb->info;
+
+		scan_cache_scan_done(status->status);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+int scan_source_init(void)
+{
+	net_mgmt_init_event_callback(&wifi_cb, wifi_event_handler, WIFI_EVENT_MASK);
+	net_mgmt_add_event_callback(&wifi_cb);
+
+	return 0;
+}
+
+int scan_source_start(void)
+{
+	struct net_if *iface = net_if_get_first_wifi();
+
+	if (iface == NULL) {
+		return -ENODEV;
+	}
+
+	return net_mgmt(NET_REQUEST_WIFI_SCAN, iface, NULL, 0);
+}
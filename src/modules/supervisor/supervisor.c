@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/sys/reboot.h>
+#include <zephyr/task_wdt/task_wdt.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#include "message_channel.h"
+#include "supervisor.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(supervisor, CONFIG_MQTT_SAMPLE_SUPERVISOR_LOG_LEVEL);
+
+#define RESTART_WINDOW_MS (CONFIG_MQTT_SAMPLE_SUPERVISOR_RESTART_WINDOW_SECONDS * MSEC_PER_SEC)
+#define RECOVERY_TIMEOUT K_SECONDS(CONFIG_MQTT_SAMPLE_SUPERVISOR_RECOVERY_TIMEOUT_SECONDS)
+
+/* Outcome of the faults of one class, over all supervised modules */
+struct fault_stats {
+	uint32_t faults;
+	uint32_t restarts;
+	uint32_t escalations;
+
+	/* Time from the fault to the module being back in service */
+	uint32_t recoveries;
+	uint32_t recovery_last_ms;
+	uint32_t recovery_max_ms;
+	uint64_t recovery_total_ms;
+};
+
+static const char *const fault_names[] = {
+	[SUPERVISOR_FAULT_ERROR] = "error",
+	[SUPERVISOR_FAULT_HEARTBEAT] = "heartbeat",
+	[SUPERVISOR_FAULT_INJECTED] = "injected",
+};
+
+static struct fault_stats stats[SUPERVISOR_FAULT_COUNT];
+static sys_slist_t modules = SYS_SLIST_STATIC_INIT(&modules);
+
+/* Protects the statistics and the recovery state of the modules, which are changed from the
+ * system workqueue and from the contexts of the modules.
+ */
+static struct k_spinlock lock;
+
+/* Called from the task watchdog's timer when a module misses its heartbeat deadline */
+static void wdt_callback(int channel_id, void *user_data)
+{
+	struct supervisor_module *module = user_data;
+
+	/* Rearm the channel, otherwise it expires again right away */
+	(void)task_wdt_feed(channel_id);
+
+	supervisor_fault(module, SUPERVISOR_FAULT_HEARTBEAT, -ETIMEDOUT);
+}
+
+/* Reboot, reporting the fault as a fatal error of the module. The crash context records the
+ * module's name as the file, and the fault class as the line.
+ */
+static void escalate(struct supervisor_module *module, enum supervisor_fault fault, int err)
+{
+	/* Recorded by the crash context as <module>:<line>. The line is the fault class counted
+	 * from 1, so that an escalated handler error does not read as line 0.
+	 */
+	struct fatal_error error = {
+		.file = module->name,
+		.line = fault + 1,
+		.err = err,
+	};
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	stats[fault].escalations++;
+
+	k_spin_unlock(&lock, key);
+
+	LOG_ERR("Escalating the %s fault of %s to a reboot", fault_names[fault], module->name);
+
+	if (zbus_chan_pub(&FATAL_ERROR_CHAN, &error, K_SECONDS(10))) {
+		LOG_ERR("Sending a message on the fatal error channel failed, rebooting");
+		LOG_PANIC();
+		IF_ENABLED(CONFIG_REBOOT, (sys_reboot(0)));
+	}
+}
+
+static void fault_work_fn(struct k_work *work)
+{
+	int err;
+	struct supervisor_module *module = CONTAINER_OF(work, struct supervisor_module,
+							fault_work);
+	enum supervisor_fault fault = module->pending_fault;
+	int fault_err = module->pending_err;
+	int64_t now = k_uptime_get();
+	bool escalated = false;
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	stats[fault].faults++;
+
+	/* A fault during the recovery from another one adds to the recovery time of the first */
+	if (!module->recovering) {
+		module->recovering = true;
+		module->recovering_fault = fault;
+		module->fault_ms = now;
+	}
+
+	if ((now - module->window_start_ms) > RESTART_WINDOW_MS) {
+		module->window_start_ms = now;
+		module->window_restarts = 0;
+	}
+
+	if ((module->restart == NULL) ||
+	    (module->window_restarts >= CONFIG_MQTT_SAMPLE_SUPERVISOR_MAX_RESTARTS)) {
+		escalated = true;
+	} else {
+		module->window_restarts++;
+		module->restarts++;
+		stats[fault].restarts++;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	LOG_WRN("%s fault of %s, error: %d", fault_names[fault], module->name, fault_err);
+
+	if (escalated) {
+		escalate(module, fault, fault_err);
+		return;
+	}
+
+	/* The restart may take a while, so it is not counted against the heartbeat deadline */
+	if (module->wdt_channel >= 0) {
+		(void)task_wdt_feed(module->wdt_channel);
+	}
+
+	err = module->restart();
+	if (err) {
+		LOG_ERR("Restarting %s failed, error: %d", module->name, err);
+		escalate(module, fault, err);
+		return;
+	}
+
+	k_work_reschedule(&module->timeout_work, RECOVERY_TIMEOUT);
+
+	/* Faults reported from now on are handled */
+	atomic_set(&module->fault_pending, 0);
+}
+
+/* The module is not back in service in time, which is a fault of the same class again */
+static void timeout_work_fn(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct supervisor_module *module = CONTAINER_OF(dwork, struct supervisor_module,
+							timeout_work);
+
+	/* Recovered before the timeout was scheduled */
+	if (!module->recovering) {
+		return;
+	}
+
+	LOG_WRN("%s not recovered in time", module->name);
+
+	supervisor_fault(module, module->recovering_fault, -ETIMEDOUT);
+}
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+static void report_work_fn(struct k_work *work);
+
+/* Work - Runs on the system workqueue, reports recoveries on the telemetry topic */
+static K_WORK_DEFINE(report_work, report_work_fn);
+
+/* Last recovery, to be reported */
+static struct {
+	const char *module;
+	enum supervisor_fault fault;
+	uint32_t recovery_ms;
+} last_recovery;
+
+static void report_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	struct telemetry telemetry;
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	snprintk(telemetry.string, sizeof(telemetry.string), "recovered %s fault:%s ms:%u",
+		 last_recovery.module, fault_names[last_recovery.fault],
+		 last_recovery.recovery_ms);
+
+	k_spin_unlock(&lock, key);
+
+	err = telemetry_publish(&telemetry, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("telemetry_publish, error: %d", err);
+	}
+}
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+
+int supervisor_register(struct supervisor_module *module)
+{
+	k_work_init(&module->fault_work, fault_work_fn);
+	k_work_init_delayable(&module->timeout_work, timeout_work_fn);
+	atomic_set(&module->fault_pending, 0);
+	module->recovering = false;
+	module->window_start_ms = k_uptime_get();
+	module->window_restarts = 0;
+	module->restarts = 0;
+	module->wdt_channel = -1;
+
+	if (module->deadline_ms) {
+		module->wdt_channel = task_wdt_add(module->deadline_ms, wdt_callback, module);
+		if (module->wdt_channel < 0) {
+			LOG_ERR("task_wdt_add, error: %d", module->wdt_channel);
+			return module->wdt_channel;
+		}
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	sys_slist_append(&modules, &module->node);
+
+	k_spin_unlock(&lock, key);
+
+	LOG_DBG("Supervising %s, heartbeat deadline: %u ms", module->name, module->deadline_ms);
+
+	return 0;
+}
+
+void supervisor_heartbeat(struct supervisor_module *module)
+{
+	if (module->wdt_channel >= 0) {
+		(void)task_wdt_feed(module->wdt_channel);
+	}
+}
+
+void supervisor_fault(struct supervisor_module *module, enum supervisor_fault fault, int err)
+{
+	if (!atomic_cas(&module->fault_pending, 0, 1)) {
+		return;
+	}
+
+	module->pending_fault = fault;
+	module->pending_err = err;
+
+	k_work_submit(&module->fault_work);
+}
+
+void supervisor_recovered(struct supervisor_module *module)
+{
+	uint32_t recovery_ms;
+	enum supervisor_fault fault;
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (!module->recovering) {
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	fault = module->recovering_fault;
+	recovery_ms = (uint32_t)(k_uptime_get() - module->fault_ms);
+	module->recovering = false;
+
+	stats[fault].recoveries++;
+	stats[fault].recovery_last_ms = recovery_ms;
+	stats[fault].recovery_max_ms = MAX(stats[fault].recovery_max_ms, recovery_ms);
+	stats[fault].recovery_total_ms += recovery_ms;
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+	last_recovery.module = module->name;
+	last_recovery.fault = fault;
+	last_recovery.recovery_ms = recovery_ms;
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+
+	k_spin_unlock(&lock, key);
+
+	k_work_cancel_delayable(&module->timeout_work);
+
+	LOG_INF("%s recovered from a %s fault in %u ms", module->name, fault_names[fault],
+		recovery_ms);
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+	k_work_submit(&report_work);
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+}
+
+static int supervisor_init(void)
+{
+	int err;
+	const struct device *hw_wdt = NULL;
+
+#if defined(CONFIG_TASK_WDT_HW_FALLBACK)
+	/* Reboots the device if the task watchdog itself stops being serviced */
+	hw_wdt = DEVICE_DT_GET_OR_NULL(DT_ALIAS(watchdog0));
+#endif /* CONFIG_TASK_WDT_HW_FALLBACK */
+
+	err = task_wdt_init(hw_wdt);
+	if (err) {
+		LOG_ERR("task_wdt_init, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+/* Initialized after the crash context's boot delay, and before the modules, which register
+ * when they are initialized.
+ */
+SYS_INIT(supervisor_init, APPLICATION, 2);
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct supervisor_module *module;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&modules, module, node) {
+		shell_print(sh, "%s: deadline %u ms, %u restarts%s", module->name,
+			    module->deadline_ms, module->restarts,
+			    module->recovering ? ", recovering" : "");
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(stats); i++) {
+		const struct fault_stats *s = &stats[i];
+
+		shell_print(sh, "%s: %u faults, %u restarts, %u escalations, %u recovered, "
+			    "recovery last %u ms, mean %u ms, max %u ms", fault_names[i],
+			    s->faults, s->restarts, s->escalations, s->recoveries,
+			    s->recovery_last_ms,
+			    s->recoveries ? (uint32_t)(s->recovery_total_ms / s->recoveries) : 0,
+			    s->recovery_max_ms);
+	}
+
+	return 0;
+}
+
+static int cmd_fault(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+
+	struct supervisor_module *module;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&modules, module, node) {
+		if (strcmp(module->name, argv[1]) == 0) {
+			supervisor_fault(module, SUPERVISOR_FAULT_INJECTED, -EIO);
+			shell_print(sh, "Fault injected in %s", module->name);
+			return 0;
+		}
+	}
+
+	shell_error(sh, "No supervised module named %s", argv[1]);
+
+	return -ENOENT;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_supervisor,
+	SHELL_CMD(show, NULL, "Show the supervised modules and the recovery times", cmd_show),
+	SHELL_CMD_ARG(fault, NULL, "Inject a fault in a module <name>", cmd_fault, 2, 0),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(supervisor, &sub_supervisor, "Module supervisor", NULL);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _SUPERVISOR_H_
+#define _SUPERVISOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Classes of faults that a supervised module recovers from */
+enum supervisor_fault {
+	/* The module's handler failed */
+	SUPERVISOR_FAULT_ERROR,
+
+	/* The module did not send a heartbeat before its deadline */
+	SUPERVISOR_FAULT_HEARTBEAT,
+
+	/* Injected from the shell */
+	SUPERVISOR_FAULT_INJECTED,
+
+	SUPERVISOR_FAULT_COUNT,
+};
+
+/**
+ * @brief Restart the module in place, called from the supervisor's workqueue.
+ *	  The restart can complete asynchronously, the module calls supervisor_recovered()
+ *	  once it is back in service.
+ *
+ * @retval 0 if the restart was started.
+ * @retval -errno if the module cannot be restarted, which escalates to a reboot.
+ */
+typedef int (*supervisor_restart_t)(void);
+
+/* Module under supervision, owned by the module. Only the first fields are set by it. */
+struct supervisor_module {
+	const char *name;
+
+	/* Maximum time between heartbeats, 0 to not watch for heartbeats */
+	uint32_t deadline_ms;
+
+	/* NULL if the module cannot be restarted, in which case each fault escalates */
+	supervisor_restart_t restart;
+
+	/* Private, set by the supervisor */
+	sys_snode_t node;
+	struct k_work fault_work;
+	struct k_work_delayable timeout_work;
+	int wdt_channel;
+	atomic_t fault_pending;
+	enum supervisor_fault pending_fault;
+	int pending_err;
+	bool recovering;
+	enum supervisor_fault recovering_fault;
+	int64_t fault_ms;
+	int64_t window_start_ms;
+	uint16_t window_restarts;
+	uint32_t restarts;
+};
+
+/**
+ * @brief Put a module under supervision. Its first heartbeat deadline starts now.
+ *
+ * @param module Module, which must stay valid.
+ *
+ * @retval 0 on success.
+ * @retval -errno if the task watchdog channel could not be added.
+ */
+int supervisor_register(struct supervisor_module *module);
+
+/**
+ * @brief Report that the module is alive, which moves its heartbeat deadline.
+ *
+ * @param module Module.
+ */
+void supervisor_heartbeat(struct supervisor_module *module);
+
+/**
+ * @brief Report a fault of the module, which is restarted in place. The device reboots
+ *	  instead if the module cannot be restarted, or has been restarted too often.
+ *	  Can be called from any context. Faults reported while one is handled are dropped.
+ *
+ * @param module Module.
+ * @param fault Class of the fault.
+ * @param err Error code of the fault.
+ */
+void supervisor_fault(struct supervisor_module *module, enum supervisor_fault fault, int err);
+
+/**
+ * @brief Report that the module is back in service after a restart. Ends the recovery time
+ *	  of the fault. Does nothing if the module is not recovering.
+ *
+ * @param module Module.
+ */
+void supervisor_recovered(struct supervisor_module *module);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SUPERVISOR_H_ */
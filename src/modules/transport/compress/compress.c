@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "compress.h"
+
+#define WINDOW_MASK (COMPRESS_WINDOW_SIZE - 1)
+
+/* Bit stream helpers */
+
+static int put_bits(struct compress_enc *enc, uint32_t value, uint8_t bits)
+{
+	if ((enc->bit_pos + bits) > (enc->out_size * 8)) {
+		return -ENOMEM;
+	}
+
+	while (bits--) {
+		size_t byte = enc->bit_pos / 8;
+		uint8_t mask = 0x80 >> (enc->bit_pos % 8);
+
+		if (value & (1UL << bits)) {
+			enc->out[byte] |= mask;
+		} else {
+			enc->out[byte] &= ~mask;
+		}
+
+		enc->bit_pos++;
+	}
+
+	return 0;
+}
+
+struct bit_reader {
+	const uint8_t *buf;
+	size_t len;
+	size_t bit_pos;
+};
+
+static int get_bits(struct bit_reader *reader, uint8_t bits, uint32_t *value)
+{
+	if ((reader->bit_pos + bits) > (reader->len * 8)) {
+		return -EBADMSG;
+	}
+
+	*value = 0;
+
+	while (bits--) {
+		size_t byte = reader->bit_pos / 8;
+		uint8_t mask = 0x80 >> (reader->bit_pos % 8);
+
+		*value = (*value << 1) | ((reader->buf[byte] & mask) ? 1 : 0);
+		reader->bit_pos++;
+	}
+
+	return 0;
+}
+
+/* Encoder */
+
+/* Get the byte at a position relative to the start of the data currently being fed.
+ * Negative positions refer to the history of previously fed data.
+ */
+static uint8_t byte_at(const struct compress_enc *enc, const uint8_t *in, ptrdiff_t pos)
+{
+	if (pos >= 0) {
+		return in[pos];
+	}
+
+	return enc->history[(enc->history_head + pos) & WINDOW_MASK];
+}
+
+static void history_push(struct compress_enc *enc, const uint8_t *in, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		enc->history[enc->history_head] = in[i];
+		enc->history_head = (enc->history_head + 1) & WINDOW_MASK;
+	}
+
+	enc->history_len += len;
+	if (enc->history_len > COMPRESS_WINDOW_SIZE) {
+		enc->history_len = COMPRESS_WINDOW_SIZE;
+	}
+}
+
+/* Find the longest match for the data at pos within the window. */
+static size_t match_find(const struct compress_enc *enc, const uint8_t *in, size_t len,
+			 size_t pos, size_t *distance)
+{
+	size_t reach = enc->history_len + pos;
+	size_t limit = len - pos;
+	size_t best = 0;
+
+	if (reach > COMPRESS_WINDOW_SIZE) {
+		reach = COMPRESS_WINDOW_SIZE;
+	}
+
+	if (limit > COMPRESS_MAX_MATCH) {
+		limit = COMPRESS_MAX_MATCH;
+	}
+
+	for (size_t dist = 1; dist <= reach; dist++) {
+		ptrdiff_t src = (ptrdiff_t)pos - (ptrdiff_t)dist;
+		size_t n = 0;
+
+		/* Matches may overlap the data being encoded, the decoder copies byte by byte. */
+		while ((n < limit) && (byte_at(enc, in, src + n) == in[pos + n])) {
+			n++;
+		}
+
+		if (n > best) {
+			best = n;
+			*distance = dist;
+
+			if (best == limit) {
+				break;
+			}
+		}
+	}
+
+	return best;
+}
+
+void compress_enc_init(struct compress_enc *enc, uint8_t *out, size_t out_size)
+{
+	enc->history_len = 0;
+	enc->history_head = 0;
+	enc->out = out;
+	enc->out_size = out_size;
+	enc->bit_pos = 0;
+}
+
+int compress_enc_feed(struct compress_enc *enc, const uint8_t *in, size_t len)
+{
+	size_t pos = 0;
+	int err;
+
+	while (pos < len) {
+		size_t distance = 0;
+		size_t match = match_find(enc, in, len, pos, &distance);
+
+		if (match >= COMPRESS_MIN_MATCH) {
+			err = put_bits(enc, 0, 1) ?:
+			      put_bits(enc, distance - 1, COMPRESS_WINDOW_BITS) ?:
+			      put_bits(enc, match - COMPRESS_MIN_MATCH, COMPRESS_LOOKAHEAD_BITS);
+		} else {
+			match = 1;
+			err = put_bits(enc, 1, 1) ?: put_bits(enc, in[pos], 8);
+		}
+
+		if (err) {
+			return err;
+		}
+
+		pos += match;
+	}
+
+	history_push(enc, in, len);
+
+	return 0;
+}
+
+size_t compress_enc_len(const struct compress_enc *enc)
+{
+	return (enc->bit_pos + 7) / 8;
+}
+
+/* Framing */
+
+static size_t varint_put(uint8_t *buf, size_t value)
+{
+	size_t i = 0;
+
+	do {
+		buf[i] = value & 0x7F;
+		value >>= 7;
+
+		if (value) {
+			buf[i] |= 0x80;
+		}
+
+		i++;
+	} while (value);
+
+	return i;
+}
+
+static int varint_get(const uint8_t *buf, size_t len, size_t *value, size_t *used)
+{
+	size_t i = 0;
+	uint8_t shift = 0;
+
+	*value = 0;
+
+	do {
+		if ((i >= len) || (shift >= (sizeof(size_t) * 8))) {
+			return -EBADMSG;
+		}
+
+		*value |= (size_t)(buf[i] & 0x7F) << shift;
+		shift += 7;
+	} while (buf[i++] & 0x80);
+
+	*used = i;
+
+	return 0;
+}
+
+static int frame_raw(const uint8_t *in, size_t len, uint8_t *out, size_t out_size)
+{
+	if ((len + 1) > out_size) {
+		return -EMSGSIZE;
+	}
+
+	out[0] = COMPRESS_HEADER_RAW;
+	memcpy(&out[1], in, len);
+
+	return len + 1;
+}
+
+int compress_frame(struct compress_enc *enc, const uint8_t *in, size_t len,
+		   uint8_t *out, size_t out_size, bool *compressed)
+{
+	/* Header byte plus the longest possible varint of the original length. */
+	uint8_t header[1 + ((sizeof(size_t) * 8 + 6) / 7)];
+	size_t header_len;
+	int err;
+
+	if (compressed) {
+		*compressed = false;
+	}
+
+	header[0] = COMPRESS_HEADER_FLAG |
+		    ((COMPRESS_WINDOW_BITS - 4) << 3) |
+		    (COMPRESS_LOOKAHEAD_BITS - 2);
+	header_len = 1 + varint_put(&header[1], len);
+
+	/* Only bother compressing if there is room for something smaller than the original. */
+	if ((out_size <= header_len) || (len <= header_len)) {
+		return frame_raw(in, len, out, out_size);
+	}
+
+	/* Limit the bit stream so that anything not smaller than the original is abandoned. */
+	size_t budget = ((out_size < (len + 1)) ? out_size : (len + 1)) - header_len;
+
+	compress_enc_init(enc, &out[header_len], budget);
+
+	err = compress_enc_feed(enc, in, len);
+	if (err || ((header_len + compress_enc_len(enc)) >= (len + 1))) {
+		/* The data does not shrink, bypass compression. */
+		return frame_raw(in, len, out, out_size);
+	}
+
+	memcpy(out, header, header_len);
+
+	if (compressed) {
+		*compressed = true;
+	}
+
+	return header_len + compress_enc_len(enc);
+}
+
+int compress_unframe(const uint8_t *in, size_t len, uint8_t *out, size_t out_size)
+{
+	struct bit_reader reader;
+	uint8_t window_bits, lookahead_bits, min_match;
+	size_t original_len, used, pos = 0;
+	int err;
+
+	if (len < 1) {
+		return -EBADMSG;
+	}
+
+	if (!(in[0] & COMPRESS_HEADER_FLAG)) {
+		if ((len - 1) > out_size) {
+			return -EMSGSIZE;
+		}
+
+		memcpy(out, &in[1], len - 1);
+
+		return len - 1;
+	}
+
+	/* Parameters are taken from the header so that frames from encoders with other window
+	 * sizes can be decoded.
+	 */
+	window_bits = ((in[0] >> 3) & 0x0F) + 4;
+	lookahead_bits = (in[0] & 0x07) + 2;
+	min_match = ((1 + window_bits + lookahead_bits) / 9) + 1;
+
+	err = varint_get(&in[1], len - 1, &original_len, &used);
+	if (err) {
+		return err;
+	}
+
+	if (original_len > out_size) {
+		return -EMSGSIZE;
+	}
+
+	reader.buf = &in[1 + used];
+	reader.len = len - 1 - used;
+	reader.bit_pos = 0;
+
+	while (pos < original_len) {
+		uint32_t literal, index, count;
+
+		err = get_bits(&reader, 1, &literal);
+		if (err) {
+			return err;
+		}
+
+		if (literal) {
+			err = get_bits(&reader, 8, &literal);
+			if (err) {
+				return err;
+			}
+
+			out[pos++] = literal;
+			continue;
+		}
+
+		err = get_bits(&reader, window_bits, &index) ?:
+		      get_bits(&reader, lookahead_bits, &count);
+		if (err) {
+			return err;
+		}
+
+		size_t distance = index + 1;
+
+		count += min_match;
+
+		if ((distance > pos) || ((pos + count) > original_len)) {
+			return -EBADMSG;
+		}
+
+		while (count--) {
+			out[pos] = out[pos - distance];
+			pos++;
+		}
+	}
+
+	return original_len;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _COMPRESS_H_
+#define _COMPRESS_H_
+
+/* Small-window streaming LZSS compressor, similar to heatshrink, used to compress large
+ * messages before they are published.
+ *
+ * The encoder keeps a history of the last 2^COMPRESS_WINDOW_BITS bytes, so RAM usage is
+ * bounded regardless of how much data is fed through it. The decoder only needs the output
+ * buffer as history.
+ *
+ * The library has no dependencies on Zephyr so that the decoder can be built and used in
+ * host side tools and tests.
+ *
+ * Frame layout:
+ *   byte 0	Header. Bit 7 set if the frame is compressed, bits 6-3 hold the window bits
+ *		minus 4 and bits 2-0 the lookahead bits minus 2. 0x00 for an uncompressed frame.
+ *   byte 1-	Compressed frame: Original length as a varint, followed by the LZSS bit stream.
+ *		Uncompressed frame: The original data.
+ *
+ * LZSS bit stream, MSB first:
+ *   1 <8 bit literal>
+ *   0 <window bits: distance - 1> <lookahead bits: length - COMPRESS_MIN_MATCH>
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_WINDOW_BITS)
+#define COMPRESS_WINDOW_BITS CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_WINDOW_BITS
+#define COMPRESS_LOOKAHEAD_BITS CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_LOOKAHEAD_BITS
+#else
+#define COMPRESS_WINDOW_BITS 8
+#define COMPRESS_LOOKAHEAD_BITS 4
+#endif
+
+#define COMPRESS_WINDOW_SIZE (1 << COMPRESS_WINDOW_BITS)
+
+/* Shortest back-reference that is smaller than the literals it replaces. */
+#define COMPRESS_MIN_MATCH (((1 + COMPRESS_WINDOW_BITS + COMPRESS_LOOKAHEAD_BITS) / 9) + 1)
+#define COMPRESS_MAX_MATCH (COMPRESS_MIN_MATCH + (1 << COMPRESS_LOOKAHEAD_BITS) - 1)
+
+/** @brief Header value of an uncompressed frame. */
+#define COMPRESS_HEADER_RAW 0x00
+
+/** @brief Header flag set in compressed frames. */
+#define COMPRESS_HEADER_FLAG 0x80
+
+/** @brief Streaming encoder state, must be initialized with compress_enc_init(). */
+struct compress_enc {
+	uint8_t history[COMPRESS_WINDOW_SIZE];
+	size_t history_len;
+	size_t history_head;
+	uint8_t *out;
+	size_t out_size;
+	size_t bit_pos;
+};
+
+/** @brief Initialize a streaming encoder.
+ *
+ *  @param enc Pointer to encoder state.
+ *  @param out Buffer that the bit stream is written to.
+ *  @param out_size Size of buffer.
+ */
+void compress_enc_init(struct compress_enc *enc, uint8_t *out, size_t out_size);
+
+/** @brief Feed data through the encoder. Can be called multiple times, back-references
+ *	   reach into data from previous calls.
+ *
+ *  @param enc Pointer to encoder state.
+ *  @param in Data to compress.
+ *  @param len Length of data.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -ENOMEM If the output buffer is full.
+ */
+int compress_enc_feed(struct compress_enc *enc, const uint8_t *in, size_t len);
+
+/** @brief Get the length of the bit stream written so far, rounded up to whole bytes. */
+size_t compress_enc_len(const struct compress_enc *enc);
+
+/** @brief Build a frame from a buffer. The data is compressed if that makes it smaller,
+ *	   otherwise an uncompressed frame is built.
+ *
+ *  @param enc Encoder state used as scratch space.
+ *  @param in Data to frame.
+ *  @param len Length of data.
+ *  @param out Buffer that the frame is written to.
+ *  @param out_size Size of buffer.
+ *  @param compressed Set to true if the frame is compressed. Can be NULL.
+ *
+ *  @return Length of the frame if successful. Otherwise, a negative error code is returned.
+ *  @retval -EMSGSIZE If not even an uncompressed frame fits in the output buffer.
+ */
+int compress_frame(struct compress_enc *enc, const uint8_t *in, size_t len,
+		   uint8_t *out, size_t out_size, bool *compressed);
+
+/** @brief Extract the original data from a frame.
+ *
+ *  @param in Frame.
+ *  @param len Length of frame.
+ *  @param out Buffer that the original data is written to.
+ *  @param out_size Size of buffer.
+ *
+ *  @return Length of the original data if successful. Otherwise, a negative error code
+ *	    is returned.
+ *  @retval -EMSGSIZE If the output buffer is too small.
+ *  @retval -EBADMSG If the frame is truncated or corrupt.
+ */
+int compress_unframe(const uint8_t *in, size_t len, uint8_t *out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _COMPRESS_H_ */
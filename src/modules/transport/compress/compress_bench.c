@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Benchmark of the payload compression stage. Runs once at boot and logs compression ratio,
+ * encode and decode throughput and RAM usage for a set of representative payloads.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
+
+#include "bench_clock.h"
+#include "compress.h"
+
+LOG_MODULE_REGISTER(compress_bench, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_LEVEL);
+
+#define BENCH_THREAD_STACK_SIZE 2048
+#define BENCH_ITERATIONS 10
+#define BENCH_SIZE CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_BENCHMARK_SIZE
+
+static struct compress_enc enc;
+static uint8_t input[BENCH_SIZE];
+static uint8_t frame[BENCH_SIZE + 16];
+static uint8_t output[BENCH_SIZE];
+
+/* Payload generators. Each fills the input buffer and returns the number of bytes used. */
+
+static size_t json_fill(void)
+{
+	size_t len = 0;
+
+	for (int i = 0; ; i++) {
+		int ret = snprintk((char *)&input[len], sizeof(input) - len,
+				   "{\"ts\":%d,\"temp\":%d.%d,\"hum\":%d,\"bat\":%d}\n",
+				   1000 + (i * 60), 21 + (i % 3), i % 10, 40 + (i % 5), 3700 - i);
+
+		if ((ret < 0) || (ret >= (sizeof(input) - len))) {
+			return len;
+		}
+
+		len += ret;
+	}
+}
+
+static size_t log_fill(void)
+{
+	static const char *const lines[] = {
+		"<inf> transport: Published message on topic: \"%d/my/publish/topic\"\n",
+		"<inf> network: Network connectivity established, uptime %d\n",
+		"<wrn> transport: Failed to send payload, err: -%d\n",
+		"<inf> sampler: Sample %d sent on the payload channel\n",
+	};
+	size_t len = 0;
+
+	for (int i = 0; ; i++) {
+		int ret = snprintk((char *)&input[len], sizeof(input) - len,
+				   lines[i % ARRAY_SIZE(lines)], i * 17);
+
+		if ((ret < 0) || (ret >= (sizeof(input) - len))) {
+			return len;
+		}
+
+		len += ret;
+	}
+}
+
+static size_t random_fill(void)
+{
+	sys_rand_get(input, sizeof(input));
+
+	return sizeof(input);
+}
+
+static uint32_t kib_per_sec(size_t bytes, uint64_t ns)
+{
+	return (uint32_t)(((uint64_t)bytes * NSEC_PER_SEC) / (MAX(ns, 1) * 1024));
+}
+
+static void bench_run(const char *name, size_t (*fill)(void))
+{
+	size_t len = fill();
+	uint64_t encode_ns = 0, decode_ns = 0, start;
+	bool compressed = false;
+	int frame_len = 0, decoded_len = 0;
+
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		start = bench_clock_ns();
+		frame_len = compress_frame(&enc, input, len, frame, sizeof(frame), &compressed);
+		encode_ns += bench_clock_ns() - start;
+
+		if (frame_len < 0) {
+			LOG_ERR("%s: compress_frame, error: %d", name, frame_len);
+			return;
+		}
+
+		start = bench_clock_ns();
+		decoded_len = compress_unframe(frame, frame_len, output, sizeof(output));
+		decode_ns += bench_clock_ns() - start;
+	}
+
+	uint32_t ratio = (len * 100) / frame_len;
+	bool verified = (decoded_len == len) && (memcmp(input, output, len) == 0);
+
+	LOG_INF("%s: %zu B -> %d B (%s), ratio: %u.%02u, encode: %u KiB/s, decode: %u KiB/s, "
+		"decode check: %s",
+		name, len, frame_len, compressed ? "compressed" : "bypassed",
+		ratio / 100, ratio % 100,
+		kib_per_sec(len * BENCH_ITERATIONS, encode_ns),
+		kib_per_sec(len * BENCH_ITERATIONS, decode_ns),
+		verified ? "passed" : "FAILED");
+}
+
+static void compress_bench_task(void)
+{
+	size_t unused = 0;
+	int err;
+
+	LOG_INF("Compression benchmark, window: %d B, lookahead: %d bits, payload: %d B",
+		COMPRESS_WINDOW_SIZE, COMPRESS_LOOKAHEAD_BITS, BENCH_SIZE);
+
+	bench_run("json", json_fill);
+	bench_run("log", log_fill);
+	bench_run("random", random_fill);
+
+	err = k_thread_stack_space_get(k_current_get(), &unused);
+	if (err) {
+		LOG_WRN("k_thread_stack_space_get, error: %d", err);
+	}
+
+	LOG_INF("RAM: encoder state: %zu B, peak stack: %zu B",
+		sizeof(enc), BENCH_THREAD_STACK_SIZE - unused);
+}
+
+K_THREAD_DEFINE(compress_bench_task_id,
+		BENCH_THREAD_STACK_SIZE,
+		compress_bench_task, NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
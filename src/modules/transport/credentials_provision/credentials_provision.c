@@ -4,8 +4,22 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_MODEM_KEY_MGMT)
 #include <modem/modem_key_mgmt.h>
 #include <modem/nrf_modem_lib.h>
+#else
+#include <zephyr/net/tls_credentials.h>
+#endif /* CONFIG_MODEM_KEY_MGMT */
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+/* Register log module */
+LOG_MODULE_REGISTER(credentials_provision, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_LEVEL);
 
 static const unsigned char ca_certificate[] = {
 #if __has_include("ca-cert.pem")
@@ -59,87 +73,287 @@ static const unsigned char device_certificate_2[] = {
 
 #endif /* CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG != -1 */
 
-static int credentials_provision(void)
+enum credential_kind { CREDENTIAL_CA, CREDENTIAL_CERT, CREDENTIAL_KEY };
+
+enum credential_status { CREDENTIAL_ABSENT, CREDENTIAL_UNCHANGED, CREDENTIAL_WRITTEN,
+			 CREDENTIAL_FAILED };
+
+struct credential {
+	int sec_tag;
+	enum credential_kind kind;
+
+	/* PEM content, NUL terminated */
+	const unsigned char *data;
+	size_t size;
+
+	/* Outcome of the last provisioning */
+	enum credential_status status;
+	uint32_t check_us;
+	uint32_t write_us;
+};
+
+#define CREDENTIAL(_sec_tag, _kind, _data) \
+	{ .sec_tag = (_sec_tag), .kind = (_kind), .data = (_data), .size = sizeof(_data) }
+
+/* A client certificate is listed before its private key, see key_unchanged() */
+static struct credential credentials[] = {
+	CREDENTIAL(CONFIG_MQTT_HELPER_SEC_TAG, CREDENTIAL_CA, ca_certificate),
+	CREDENTIAL(CONFIG_MQTT_HELPER_SEC_TAG, CREDENTIAL_CERT, device_certificate),
+	CREDENTIAL(CONFIG_MQTT_HELPER_SEC_TAG, CREDENTIAL_KEY, private_key),
+#if CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG != -1
+	CREDENTIAL(CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG, CREDENTIAL_CA, ca_certificate_2),
+	CREDENTIAL(CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG, CREDENTIAL_CERT, device_certificate_2),
+	CREDENTIAL(CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG, CREDENTIAL_KEY, private_key_2),
+#endif /* CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG != -1 */
+};
+
+/* Duration of the last provisioning */
+static uint32_t provision_us;
+
+static const char *const kind_names[] = {
+	[CREDENTIAL_CA] = "CA certificate",
+	[CREDENTIAL_CERT] = "client certificate",
+	[CREDENTIAL_KEY] = "private key",
+};
+
+static const char *const status_names[] = {
+	[CREDENTIAL_ABSENT] = "absent",
+	[CREDENTIAL_UNCHANGED] = "unchanged",
+	[CREDENTIAL_WRITTEN] = "written",
+	[CREDENTIAL_FAILED] = "failed",
+};
+
+static uint32_t us_since(int64_t start_ticks)
 {
-	int err = 0;
+	return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks() - start_ticks);
+}
 
-	if (sizeof(ca_certificate) > 1) {
-		err = modem_key_mgmt_write(CONFIG_MQTT_HELPER_SEC_TAG,
-					   MODEM_KEY_MGMT_CRED_TYPE_CA_CHAIN,
-					   ca_certificate,
-					   sizeof(ca_certificate) - 1);
-		if (err) {
-			return err;
+/* Client certificate stored in the same security tag as a private key */
+static const struct credential *cert_of(const struct credential *key)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(credentials); i++) {
+		if ((credentials[i].sec_tag == key->sec_tag) &&
+		    (credentials[i].kind == CREDENTIAL_CERT)) {
+			return &credentials[i];
 		}
 	}
 
-	if (sizeof(device_certificate) > 1) {
-		err = modem_key_mgmt_write(CONFIG_MQTT_HELPER_SEC_TAG,
-					   MODEM_KEY_MGMT_CRED_TYPE_PUBLIC_CERT,
-					   device_certificate,
-					   sizeof(device_certificate) - 1);
-		if (err) {
-			return err;
-		}
+	return NULL;
+}
+
+#if defined(CONFIG_MODEM_KEY_MGMT)
+static const enum modem_key_mgmt_cred_type modem_types[] = {
+	[CREDENTIAL_CA] = MODEM_KEY_MGMT_CRED_TYPE_CA_CHAIN,
+	[CREDENTIAL_CERT] = MODEM_KEY_MGMT_CRED_TYPE_PUBLIC_CERT,
+	[CREDENTIAL_KEY] = MODEM_KEY_MGMT_CRED_TYPE_PRIVATE_CERT,
+};
+
+/* The modem does not give private keys back, so a private key is taken as unchanged if it
+ * exists and the client certificate that it belongs to is unchanged.
+ */
+static bool key_unchanged(const struct credential *cred)
+{
+	int err;
+	bool exists;
+	const struct credential *cert = cert_of(cred);
+
+	if ((cert == NULL) || (cert->status != CREDENTIAL_UNCHANGED)) {
+		return false;
 	}
 
-	if (sizeof(private_key) > 1) {
-		err = modem_key_mgmt_write(CONFIG_MQTT_HELPER_SEC_TAG,
-					   MODEM_KEY_MGMT_CRED_TYPE_PRIVATE_CERT,
-					   private_key,
-					   sizeof(private_key) - 1);
-		if (err) {
-			return err;
-		}
+	err = modem_key_mgmt_exists(cred->sec_tag, modem_types[cred->kind], &exists);
+	if (err) {
+		LOG_DBG("modem_key_mgmt_exists, error: %d", err);
+		return false;
 	}
 
-	/* Secondary security tag entries. */
+	return exists;
+}
 
-#if CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG != -1
+static bool credential_unchanged(const struct credential *cred)
+{
+	if (cred->kind == CREDENTIAL_KEY) {
+		return key_unchanged(cred);
+	}
 
-	if (sizeof(ca_certificate_2) > 1) {
-		err = modem_key_mgmt_write(CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG,
-					   MODEM_KEY_MGMT_CRED_TYPE_CA_CHAIN,
-					   ca_certificate_2,
-					   sizeof(ca_certificate_2) - 1);
-		if (err) {
-			return err;
-		}
+	/* Compared by the modem, without reading the credential out */
+	return modem_key_mgmt_cmp(cred->sec_tag, modem_types[cred->kind], cred->data,
+				  cred->size - 1) == 0;
+}
+
+static int credential_write(const struct credential *cred)
+{
+	return modem_key_mgmt_write(cred->sec_tag, modem_types[cred->kind], cred->data,
+				    cred->size - 1);
+}
+#else
+static const enum tls_credential_type tls_types[] = {
+	[CREDENTIAL_CA] = TLS_CREDENTIAL_CA_CERTIFICATE,
+	[CREDENTIAL_CERT] = TLS_CREDENTIAL_SERVER_CERTIFICATE,
+	[CREDENTIAL_KEY] = TLS_CREDENTIAL_PRIVATE_KEY,
+};
+
+#if defined(CONFIG_TLS_CREDENTIALS_BACKEND_VOLATILE)
+/* The volatile backend starts empty on every boot, and only references the credentials */
+static bool credential_unchanged(const struct credential *cred)
+{
+	ARG_UNUSED(cred);
+
+	return false;
+}
+#else
+/* With a persistent backend, the stored credential is read back and compared */
+static bool credential_unchanged(const struct credential *cred)
+{
+	int err;
+	char probe;
+	size_t len = sizeof(probe);
+	void *stored;
+	bool unchanged;
+
+	/* Fails with -EFBIG and sets the length of the stored credential, if there is one */
+	err = tls_credential_get(cred->sec_tag, tls_types[cred->kind], &probe, &len);
+	if ((err != -EFBIG) || (len != cred->size)) {
+		return false;
 	}
 
-	if (sizeof(device_certificate_2) > 1) {
-		err = modem_key_mgmt_write(CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG,
-					   MODEM_KEY_MGMT_CRED_TYPE_PUBLIC_CERT,
-					   device_certificate_2,
-					   sizeof(device_certificate_2) - 1);
-		if (err) {
-			return err;
-		}
+	stored = k_malloc(len);
+	if (stored == NULL) {
+		LOG_DBG("No memory to compare the %s, writing it", kind_names[cred->kind]);
+		return false;
+	}
+
+	err = tls_credential_get(cred->sec_tag, tls_types[cred->kind], stored, &len);
+	unchanged = (err == 0) && (memcmp(stored, cred->data, len) == 0);
+
+	k_free(stored);
+
+	return unchanged;
+}
+#endif /* CONFIG_TLS_CREDENTIALS_BACKEND_VOLATILE */
+
+static int credential_write(const struct credential *cred)
+{
+	int err;
+
+	err = tls_credential_delete(cred->sec_tag, tls_types[cred->kind]);
+	if (err && (err != -ENOENT)) {
+		LOG_DBG("tls_credential_delete, error: %d", err);
 	}
 
-	if (sizeof(private_key_2) > 1) {
-		err = modem_key_mgmt_write(CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG,
-					   MODEM_KEY_MGMT_CRED_TYPE_PRIVATE_CERT,
-					   private_key_2,
-					   sizeof(private_key_2) - 1);
+	/* mbed TLS needs the NUL terminator of PEM credentials */
+	return tls_credential_add(cred->sec_tag, tls_types[cred->kind], cred->data, cred->size);
+}
+#endif /* CONFIG_MODEM_KEY_MGMT */
+
+/* Write the credentials that differ from the stored ones, or all of them if forced. A failed
+ * write does not stop the others, and the first error is returned.
+ */
+static int credentials_provision(bool force)
+{
+	int err;
+	int first_err = 0;
+	int64_t start = k_uptime_ticks();
+	int64_t step;
+	size_t written = 0;
+	size_t unchanged = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(credentials); i++) {
+		struct credential *cred = &credentials[i];
+
+		cred->check_us = 0;
+		cred->write_us = 0;
+
+		if (cred->size <= 1) {
+			cred->status = CREDENTIAL_ABSENT;
+			continue;
+		}
+
+		if (!force) {
+			step = k_uptime_ticks();
+
+			if (credential_unchanged(cred)) {
+				cred->check_us = us_since(step);
+				cred->status = CREDENTIAL_UNCHANGED;
+				unchanged++;
+				continue;
+			}
+
+			cred->check_us = us_since(step);
+		}
+
+		step = k_uptime_ticks();
+		err = credential_write(cred);
+		cred->write_us = us_since(step);
+
 		if (err) {
-			return err;
+			LOG_ERR("Writing the %s of sec_tag %d failed, error: %d",
+				kind_names[cred->kind], cred->sec_tag, err);
+			cred->status = CREDENTIAL_FAILED;
+
+			if (first_err == 0) {
+				first_err = err;
+			}
+
+			continue;
 		}
+
+		cred->status = CREDENTIAL_WRITTEN;
+		written++;
 	}
 
-#endif /* CONFIG_MQTT_HELPER_SECONDARY_SEC_TAG != -1 */
+	provision_us = us_since(start);
+
+	LOG_INF("Credentials provisioned in %u us, %zu written, %zu unchanged", provision_us,
+		written, unchanged);
 
-	return err;
+	return first_err;
 }
 
+#if defined(CONFIG_MODEM_KEY_MGMT)
 NRF_MODEM_LIB_ON_INIT(mqtt_sample_init_hook, on_modem_lib_init, NULL);
 
 static void on_modem_lib_init(int ret, void *ctx)
 {
 	if (ret != 0) {
-		printk("Modem library did not initialize: %d\n", ret);
+		LOG_ERR("Modem library did not initialize: %d", ret);
 		return;
 	}
 
-	credentials_provision();
+	credentials_provision(IS_ENABLED(CONFIG_MQTT_SAMPLE_TRANSPORT_CREDENTIALS_FORCE));
+}
+#else
+static int credentials_provision_init(void)
+{
+	return credentials_provision(IS_ENABLED(CONFIG_MQTT_SAMPLE_TRANSPORT_CREDENTIALS_FORCE));
 }
+
+SYS_INIT(credentials_provision_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif /* CONFIG_MODEM_KEY_MGMT */
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	for (size_t i = 0; i < ARRAY_SIZE(credentials); i++) {
+		const struct credential *cred = &credentials[i];
+
+		shell_print(sh, "sec_tag %d %s: %s, %zu bytes, check %u us, write %u us",
+			    cred->sec_tag, kind_names[cred->kind], status_names[cred->status],
+			    cred->size - 1, cred->check_us, cred->write_us);
+	}
+
+	shell_print(sh, "Provisioned in %u us", provision_us);
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_credentials,
+	SHELL_CMD(show, NULL, "Show the outcome of the credential provisioning", cmd_show),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(credentials, &sub_credentials, "Credential provisioning", NULL);
+#endif /* CONFIG_SHELL */
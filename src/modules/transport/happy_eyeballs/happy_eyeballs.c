@@ -0,0 +1,614 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/printk.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#include <posix_native_task.h>
+#include <posix_board_if.h>
+#include <cmdline.h>
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+#include "happy_eyeballs.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(happy_eyeballs, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_LEVEL);
+
+#define ADDRESSES_MAX CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_ADDRESSES_MAX
+#define HOSTNAME_LEN_MAX 64
+#define REMEMBER_MS (CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_REMEMBER_SECONDS * MSEC_PER_SEC)
+
+/* Family that connected first, per broker */
+struct family_entry {
+	char hostname[HOSTNAME_LEN_MAX];
+	sa_family_t family;
+	int64_t updated_ms;
+};
+
+static struct family_entry families[CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_BROKERS];
+
+/* Only used from the transport workqueue and the shell */
+static K_MUTEX_DEFINE(families_lock);
+
+/* Parameters of the race. Set from Kconfig, and on native_sim from the command line. */
+static struct {
+	uint32_t attempt_delay_ms;
+	bool serial;
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	char *blackhole;
+	uint32_t bench_runs;
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+} params = {
+	.attempt_delay_ms = CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_ATTEMPT_DELAY_MS,
+};
+
+static const char *family_name(sa_family_t family)
+{
+	return (family == AF_INET6) ? "ipv6" : "ipv4";
+}
+
+static struct family_entry *family_entry_find(const char *hostname)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(families); i++) {
+		if (families[i].family &&
+		    (strncmp(families[i].hostname, hostname, HOSTNAME_LEN_MAX - 1) == 0)) {
+			return &families[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Family to try first, the winner of the last race for the broker unless it has expired */
+static sa_family_t family_preferred(const char *hostname, bool *remembered)
+{
+	sa_family_t family = AF_INET6;
+	struct family_entry *entry;
+
+	*remembered = false;
+
+	k_mutex_lock(&families_lock, K_FOREVER);
+
+	entry = family_entry_find(hostname);
+	if (entry && ((k_uptime_get() - entry->updated_ms) < REMEMBER_MS)) {
+		family = entry->family;
+		*remembered = true;
+	}
+
+	k_mutex_unlock(&families_lock);
+
+	return family;
+}
+
+static void family_remember(const char *hostname, sa_family_t family)
+{
+	struct family_entry *entry;
+
+	k_mutex_lock(&families_lock, K_FOREVER);
+
+	entry = family_entry_find(hostname);
+	if (entry == NULL) {
+		/* Replace the least recently updated entry */
+		entry = &families[0];
+
+		for (size_t i = 1; i < ARRAY_SIZE(families); i++) {
+			if (families[i].updated_ms < entry->updated_ms) {
+				entry = &families[i];
+			}
+		}
+
+		strncpy(entry->hostname, hostname, sizeof(entry->hostname) - 1);
+		entry->hostname[sizeof(entry->hostname) - 1] = '\0';
+	}
+
+	entry->family = family;
+	entry->updated_ms = k_uptime_get();
+
+	k_mutex_unlock(&families_lock);
+}
+
+static int address_parse(const char *str, uint16_t port, struct sockaddr *addr)
+{
+	struct sockaddr_in6 *addr6 = net_sin6(addr);
+	struct sockaddr_in *addr4 = net_sin(addr);
+
+	if (zsock_inet_pton(AF_INET6, str, &addr6->sin6_addr) == 1) {
+		addr6->sin6_family = AF_INET6;
+		addr6->sin6_port = htons(port);
+		return 0;
+	}
+
+	if (zsock_inet_pton(AF_INET, str, &addr4->sin_addr) == 1) {
+		addr4->sin_family = AF_INET;
+		addr4->sin_port = htons(port);
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+/* Addresses from the static list, used where the broker has no DNS record */
+static size_t addresses_static(uint16_t port, struct sockaddr_storage *addrs)
+{
+	char list[] = CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_STATIC_ADDRESSES;
+	char *save;
+	size_t count = 0;
+
+	for (char *token = strtok_r(list, ", ", &save); token && (count < ADDRESSES_MAX);
+	     token = strtok_r(NULL, ", ", &save)) {
+		if (address_parse(token, port, (struct sockaddr *)&addrs[count])) {
+			LOG_ERR("Invalid static broker address: %s", token);
+			continue;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+static size_t addresses_resolve(const char *hostname, uint16_t port,
+				struct sockaddr_storage *addrs)
+{
+	int err;
+	size_t count = 0;
+	struct zsock_addrinfo *result;
+	struct zsock_addrinfo hints = {
+		.ai_family = AF_UNSPEC,
+		.ai_socktype = SOCK_STREAM,
+	};
+
+	if (strlen(CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_STATIC_ADDRESSES)) {
+		return addresses_static(port, addrs);
+	}
+
+	err = zsock_getaddrinfo(hostname, NULL, &hints, &result);
+	if (err) {
+		LOG_DBG("zsock_getaddrinfo, error: %d", err);
+		return 0;
+	}
+
+	for (struct zsock_addrinfo *ai = result; ai && (count < ADDRESSES_MAX); ai = ai->ai_next) {
+		if ((ai->ai_family != AF_INET) && (ai->ai_family != AF_INET6)) {
+			continue;
+		}
+
+		memcpy(&addrs[count], ai->ai_addr, ai->ai_addrlen);
+
+		if (ai->ai_family == AF_INET6) {
+			net_sin6((struct sockaddr *)&addrs[count])->sin6_port = htons(port);
+		} else {
+			net_sin((struct sockaddr *)&addrs[count])->sin_port = htons(port);
+		}
+
+		count++;
+	}
+
+	zsock_freeaddrinfo(result);
+
+	return count;
+}
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* Replace the addresses of a family with an unused address on the local subnet, so that the
+ * connection attempts get no answer at all, as with a broken route.
+ */
+static void addresses_blackhole(struct sockaddr_storage *addrs, size_t count, uint16_t port)
+{
+	const char *replacement;
+	sa_family_t family;
+
+	if (params.blackhole == NULL) {
+		return;
+	}
+
+	if (strcmp(params.blackhole, "ipv4") == 0) {
+		family = AF_INET;
+		replacement = CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_BLACKHOLE_IPV4;
+	} else if (strcmp(params.blackhole, "ipv6") == 0) {
+		family = AF_INET6;
+		replacement = CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_BLACKHOLE_IPV6;
+	} else {
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (addrs[i].ss_family == family) {
+			(void)address_parse(replacement, port, (struct sockaddr *)&addrs[i]);
+		}
+	}
+}
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+/* Order the addresses so that the families alternate, starting with the preferred family, and
+ * otherwise keeping the order of the resolver.
+ */
+static void addresses_order(const struct sockaddr_storage *in, size_t count,
+			    sa_family_t first, struct sockaddr_storage *out)
+{
+	size_t next[2] = { 0, 0 };
+	sa_family_t order[2] = { first, (first == AF_INET6) ? AF_INET : AF_INET6 };
+	size_t turn = 0;
+
+	for (size_t n = 0; n < count; n++) {
+		for (size_t tries = 0; tries < 2; tries++, turn ^= 1) {
+			while ((next[turn] < count) && (in[next[turn]].ss_family != order[turn])) {
+				next[turn]++;
+			}
+
+			if (next[turn] < count) {
+				out[n] = in[next[turn]++];
+				turn ^= 1;
+				break;
+			}
+		}
+	}
+}
+
+static int attempt_start(const struct sockaddr_storage *addr)
+{
+	int err;
+	int fd;
+	socklen_t len = (addr->ss_family == AF_INET6) ? sizeof(struct sockaddr_in6) :
+							 sizeof(struct sockaddr_in);
+
+	fd = zsock_socket(addr->ss_family, SOCK_STREAM, IPPROTO_TCP);
+	if (fd < 0) {
+		return -errno;
+	}
+
+	err = zsock_fcntl(fd, F_SETFL, O_NONBLOCK);
+	if (err < 0) {
+		err = -errno;
+		zsock_close(fd);
+		return err;
+	}
+
+	err = zsock_connect(fd, (const struct sockaddr *)addr, len);
+	if ((err < 0) && (errno != EINPROGRESS)) {
+		err = -errno;
+		zsock_close(fd);
+		return err;
+	}
+
+	return fd;
+}
+
+static int attempt_result(int fd, short revents)
+{
+	int err;
+	int error = 0;
+	socklen_t len = sizeof(error);
+
+	err = zsock_getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+	if (err < 0) {
+		return -errno;
+	}
+
+	if (error) {
+		return -error;
+	}
+
+	if (revents & (ZSOCK_POLLERR | ZSOCK_POLLHUP | ZSOCK_POLLNVAL)) {
+		return -ECONNREFUSED;
+	}
+
+	return 0;
+}
+
+/* Start a connection attempt every attempt delay, or as soon as an attempt fails, and return
+ * the index of the address that connects first.
+ */
+static int race(const struct sockaddr_storage *addrs, size_t count, uint8_t *attempts)
+{
+	int fds[ADDRESSES_MAX];
+	struct zsock_pollfd pollfds[ADDRESSES_MAX];
+	size_t pollidx[ADDRESSES_MAX];
+	int64_t now = k_uptime_get();
+	int64_t deadline = now + CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS_TIMEOUT_MS;
+	int64_t next_start = now;
+	size_t next = 0;
+	size_t in_progress = 0;
+	int winner = -ETIMEDOUT;
+	int last_err = -ETIMEDOUT;
+
+	for (size_t i = 0; i < count; i++) {
+		fds[i] = -1;
+	}
+
+	*attempts = 0;
+
+	while (winner < 0) {
+		size_t npoll = 0;
+		int64_t wake;
+		int ret;
+
+		now = k_uptime_get();
+		if (now >= deadline) {
+			break;
+		}
+
+		if ((next < count) && ((now >= next_start) || (in_progress == 0))) {
+			if (params.serial) {
+				/* One attempt at a time, the attempt delay is its timeout */
+				for (size_t i = 0; i < next; i++) {
+					if (fds[i] >= 0) {
+						zsock_close(fds[i]);
+						fds[i] = -1;
+					}
+				}
+
+				in_progress = 0;
+			}
+
+			(*attempts)++;
+
+			fds[next] = attempt_start(&addrs[next]);
+			if (fds[next] < 0) {
+				last_err = fds[next];
+				fds[next] = -1;
+				next++;
+				continue;
+			}
+
+			next++;
+			in_progress++;
+			next_start = now + params.attempt_delay_ms;
+		}
+
+		if (in_progress == 0) {
+			/* All attempts failed */
+			break;
+		}
+
+		for (size_t i = 0; i < next; i++) {
+			if (fds[i] >= 0) {
+				pollfds[npoll] = (struct zsock_pollfd) {
+					.fd = fds[i],
+					.events = ZSOCK_POLLOUT,
+				};
+				pollidx[npoll++] = i;
+			}
+		}
+
+		wake = (next < count) ? MIN(next_start, deadline) : deadline;
+
+		ret = zsock_poll(pollfds, npoll, (int)MAX(wake - now, 0));
+		if (ret < 0) {
+			last_err = -errno;
+			LOG_ERR("zsock_poll, error: %d", last_err);
+			break;
+		}
+
+		for (size_t p = 0; p < npoll; p++) {
+			size_t i = pollidx[p];
+			int err;
+
+			if (pollfds[p].revents == 0) {
+				continue;
+			}
+
+			err = attempt_result(fds[i], pollfds[p].revents);
+			if (err == 0) {
+				winner = i;
+				break;
+			}
+
+			LOG_DBG("Attempt %zu failed, error: %d", i, err);
+
+			zsock_close(fds[i]);
+			fds[i] = -1;
+			in_progress--;
+			last_err = err;
+
+			/* Start the next attempt right away */
+			next_start = k_uptime_get();
+		}
+	}
+
+	/* The MQTT helper opens its own connection to the winner */
+	for (size_t i = 0; i < next; i++) {
+		if (fds[i] >= 0) {
+			zsock_close(fds[i]);
+		}
+	}
+
+	return (winner >= 0) ? winner : last_err;
+}
+
+static int happy_eyeballs_run(const char *hostname, uint16_t port,
+			      struct happy_eyeballs_result *result)
+{
+	struct sockaddr_storage resolved[ADDRESSES_MAX];
+	struct sockaddr_storage addrs[ADDRESSES_MAX];
+	const struct sockaddr_storage *addr;
+	sa_family_t first;
+	size_t count;
+	int64_t start_ms;
+	int ret;
+
+	memset(result, 0, sizeof(*result));
+
+	count = addresses_resolve(hostname, port, resolved);
+	if (count == 0) {
+		return -EAGAIN;
+	}
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	addresses_blackhole(resolved, count, port);
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+	first = family_preferred(hostname, &result->remembered);
+	addresses_order(resolved, count, first, addrs);
+
+	start_ms = k_uptime_get();
+
+	ret = race(addrs, count, &result->attempts);
+	if (ret < 0) {
+		LOG_WRN("No connection to %s after %u attempts, error: %d", hostname,
+			result->attempts, ret);
+		return ret;
+	}
+
+	addr = &addrs[ret];
+
+	result->connect_ms = (uint32_t)(k_uptime_get() - start_ms);
+	result->family = addr->ss_family;
+
+	if (addr->ss_family == AF_INET6) {
+		zsock_inet_ntop(AF_INET6, &net_sin6((struct sockaddr *)addr)->sin6_addr,
+				result->addr, sizeof(result->addr));
+	} else {
+		zsock_inet_ntop(AF_INET, &net_sin((struct sockaddr *)addr)->sin_addr,
+				result->addr, sizeof(result->addr));
+	}
+
+	family_remember(hostname, addr->ss_family);
+
+	LOG_INF("Connected to %s over %s in %u ms, %u attempts%s", result->addr,
+		family_name(result->family), result->connect_ms, result->attempts,
+		result->remembered ? ", remembered family first" : "");
+
+	return 0;
+}
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* Race the connection a number of times and exit, the first race without a remembered family */
+static void bench_run(const char *hostname, uint16_t port)
+{
+	int err;
+	struct happy_eyeballs_result result;
+
+	for (uint32_t run = 0; run < params.bench_runs; run++) {
+		err = happy_eyeballs_run(hostname, port, &result);
+
+		printk("HAPPY_EYEBALLS_RESULT {\"run\":%u,\"error\":%d,\"family\":\"%s\","
+		       "\"addr\":\"%s\",\"connect_ms\":%u,\"attempts\":%u,\"remembered\":%s,"
+		       "\"blackhole\":\"%s\",\"attempt_delay_ms\":%u,\"serial\":%s}\n",
+		       run, err, err ? "" : family_name(result.family), result.addr,
+		       result.connect_ms, result.attempts, result.remembered ? "true" : "false",
+		       params.blackhole ? params.blackhole : "none", params.attempt_delay_ms,
+		       params.serial ? "true" : "false");
+
+		/* Let the closed connections settle before the next race */
+		k_sleep(K_MSEC(100));
+	}
+
+	posix_exit(0);
+}
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+int happy_eyeballs_connect(const char *hostname, uint16_t port,
+			   struct happy_eyeballs_result *result)
+{
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+	if (params.bench_runs) {
+		bench_run(hostname, port);
+	}
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+	return happy_eyeballs_run(hostname, port, result);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int64_t now = k_uptime_get();
+
+	shell_print(sh, "Attempt delay: %u ms%s", params.attempt_delay_ms,
+		    params.serial ? ", serial" : "");
+
+	k_mutex_lock(&families_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(families); i++) {
+		if (families[i].family == 0) {
+			continue;
+		}
+
+		shell_print(sh, "%s: %s, %lld s ago", families[i].hostname,
+			    family_name(families[i].family),
+			    (now - families[i].updated_ms) / MSEC_PER_SEC);
+	}
+
+	k_mutex_unlock(&families_lock);
+
+	return 0;
+}
+
+static int cmd_forget(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	k_mutex_lock(&families_lock, K_FOREVER);
+	memset(families, 0, sizeof(families));
+	k_mutex_unlock(&families_lock);
+
+	shell_print(sh, "Remembered families cleared");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_happy_eyeballs,
+	SHELL_CMD(show, NULL, "Show the family remembered per broker", cmd_show),
+	SHELL_CMD(forget, NULL, "Clear the remembered families", cmd_forget),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(happy_eyeballs, &sub_happy_eyeballs, "Dual-stack broker connection", NULL);
+#endif /* CONFIG_SHELL */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+static void happy_eyeballs_args_add(void)
+{
+	static struct args_struct_t args[] = {
+		{
+			.option = "he-blackhole",
+			.name = "ipv4|ipv6",
+			.type = 's',
+			.dest = (void *)&params.blackhole,
+			.descript = "Black-hole the broker addresses of a family",
+		},
+		{
+			.option = "he-attempt-delay",
+			.name = "ms",
+			.type = 'u',
+			.dest = (void *)&params.attempt_delay_ms,
+			.descript = "Delay between connection attempts",
+		},
+		{
+			.is_switch = true,
+			.option = "he-serial",
+			.type = 'b',
+			.dest = (void *)&params.serial,
+			.descript = "Abandon each attempt after the attempt delay",
+		},
+		{
+			.option = "he-bench-runs",
+			.name = "count",
+			.type = 'u',
+			.dest = (void *)&params.bench_runs,
+			.descript = "Race the broker connection, print the results and exit",
+		},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(args);
+}
+
+NATIVE_TASK(happy_eyeballs_args_add, PRE_BOOT_1, 10);
+#endif /* CONFIG_BOARD_NATIVE_SIM */
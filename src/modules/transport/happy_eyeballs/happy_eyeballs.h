@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HAPPY_EYEBALLS_H_
+#define _HAPPY_EYEBALLS_H_
+
+/* Dual-stack connection racing, in the manner of RFC 8305.
+ *
+ * The broker is resolved for both address families, and the addresses are ordered so that the
+ * families alternate, starting with the family that connected first the last time for the
+ * same broker, or IPv6. TCP connections are started one attempt delay apart, without waiting
+ * for the previous ones to fail, and the first to complete wins. A family that is black-holed
+ * therefore costs one attempt delay instead of a TCP connection timeout.
+ *
+ * The race only selects the address. Its sockets are closed, and the MQTT helper connects to
+ * the winning address.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <zephyr/net/net_ip.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct happy_eyeballs_result {
+	/* Address that connected first */
+	char addr[NET_IPV6_ADDR_LEN];
+	sa_family_t family;
+
+	/* Time from the first connection attempt to the first connection */
+	uint32_t connect_ms;
+
+	/* Connection attempts started */
+	uint8_t attempts;
+
+	/* Set if the family was tried first because it won the last race for the broker */
+	bool remembered;
+};
+
+/**
+ * @brief Race connections to the addresses of a host, and return the first that connects.
+ *
+ * Blocks until a connection completes, all attempts fail, or the race times out.
+ *
+ * @param hostname Host name, also the key that the winning family is remembered by.
+ * @param port TCP port.
+ * @param result Winning address.
+ *
+ * @retval 0 on success.
+ * @retval -EAGAIN if the host could not be resolved.
+ * @retval -ETIMEDOUT if no connection completed before the race timed out.
+ * @return Negative error code of the last failed attempt otherwise.
+ */
+int happy_eyeballs_connect(const char *hostname, uint16_t port,
+			   struct happy_eyeballs_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HAPPY_EYEBALLS_H_ */
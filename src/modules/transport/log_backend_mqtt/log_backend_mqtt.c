@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Log backend that formats log messages into a RAM ring buffer. The transport module drains
+ * the buffer and uploads it over MQTT while connected.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log_backend.h>
+#include <zephyr/logging/log_output.h>
+#include <zephyr/sys/ring_buffer.h>
+#if defined(CONFIG_LOG_DICTIONARY_SUPPORT)
+#include <zephyr/logging/log_output_dict.h>
+#endif /* CONFIG_LOG_DICTIONARY_SUPPORT */
+
+#include "log_backend_mqtt.h"
+
+RING_BUF_DECLARE(log_ring, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_BUFFER_SIZE);
+
+/* Protects the ring buffer, which is written by the logging thread and read by transport. */
+static struct k_spinlock log_ring_lock;
+
+/* Number of bytes dropped because the ring buffer was full */
+static uint32_t dropped_bytes;
+
+static int char_out(uint8_t *data, size_t length, void *ctx)
+{
+	ARG_UNUSED(ctx);
+
+	k_spinlock_key_t key = k_spin_lock(&log_ring_lock);
+	uint32_t written = ring_buf_put(&log_ring, data, length);
+
+	dropped_bytes += length - written;
+	k_spin_unlock(&log_ring_lock, key);
+
+	/* Always report the data as consumed, log output is dropped rather than blocking. */
+	return length;
+}
+
+static uint8_t output_buf[CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_OUTPUT_SIZE];
+LOG_OUTPUT_DEFINE(log_output_mqtt, char_out, output_buf, sizeof(output_buf));
+
+static void process(const struct log_backend *const backend, union log_msg_generic *msg)
+{
+	ARG_UNUSED(backend);
+
+#if defined(CONFIG_LOG_DICTIONARY_SUPPORT)
+	log_dict_output_msg_process(&log_output_mqtt, &msg->log, LOG_OUTPUT_FLAG_TIMESTAMP);
+#else
+	log_output_msg_process(&log_output_mqtt, &msg->log,
+			       LOG_OUTPUT_FLAG_TIMESTAMP | LOG_OUTPUT_FLAG_LEVEL);
+#endif /* CONFIG_LOG_DICTIONARY_SUPPORT */
+}
+
+static void dropped(const struct log_backend *const backend, uint32_t cnt)
+{
+	ARG_UNUSED(backend);
+
+#if defined(CONFIG_LOG_DICTIONARY_SUPPORT)
+	log_dict_output_dropped_process(&log_output_mqtt, cnt);
+#else
+	log_output_dropped_process(&log_output_mqtt, cnt);
+#endif /* CONFIG_LOG_DICTIONARY_SUPPORT */
+}
+
+static void panic(const struct log_backend *const backend)
+{
+	ARG_UNUSED(backend);
+
+	/* Nothing can be uploaded after a panic, the buffered data is left in RAM. */
+}
+
+static const struct log_backend_api log_backend_mqtt_api = {
+	.process = process,
+	.dropped = dropped,
+	.panic = panic,
+};
+
+LOG_BACKEND_DEFINE(log_backend_mqtt, log_backend_mqtt_api, true);
+
+size_t log_backend_mqtt_claim(uint8_t **data, size_t size)
+{
+	k_spinlock_key_t key = k_spin_lock(&log_ring_lock);
+	uint32_t claimed = ring_buf_get_claim(&log_ring, data, size);
+
+	k_spin_unlock(&log_ring_lock, key);
+
+	return claimed;
+}
+
+void log_backend_mqtt_finish(size_t size)
+{
+	k_spinlock_key_t key = k_spin_lock(&log_ring_lock);
+	int err = ring_buf_get_finish(&log_ring, size);
+
+	k_spin_unlock(&log_ring_lock, key);
+
+	__ASSERT_NO_MSG(err == 0);
+	ARG_UNUSED(err);
+}
+
+uint32_t log_backend_mqtt_dropped_get(void)
+{
+	return dropped_bytes;
+}
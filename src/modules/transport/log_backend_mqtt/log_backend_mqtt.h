@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _LOG_BACKEND_MQTT_H_
+#define _LOG_BACKEND_MQTT_H_
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Claim a contiguous block of buffered log data for upload.
+ *
+ *	   Log messages are stored dictionary encoded when CONFIG_LOG_DICTIONARY_SUPPORT is
+ *	   enabled, and must be decoded with the log dictionary generated by the build.
+ *	   Otherwise they are stored as text.
+ *
+ *  @param data Set to the start of the block.
+ *  @param size Maximum size of the block.
+ *
+ *  @return Size of the block, 0 if there is no buffered log data.
+ */
+size_t log_backend_mqtt_claim(uint8_t **data, size_t size);
+
+/** @brief Release a block claimed with log_backend_mqtt_claim().
+ *
+ *  @param size Number of bytes that were uploaded and can be discarded. Pass 0 to keep the
+ *		block for a later upload attempt.
+ */
+void log_backend_mqtt_finish(size_t size);
+
+/** @brief Get the number of bytes of log data that were dropped because the buffer was full. */
+uint32_t log_backend_mqtt_dropped_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOG_BACKEND_MQTT_H_ */
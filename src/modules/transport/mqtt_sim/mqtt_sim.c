@@ -0,0 +1,608 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#include <posix_native_task.h>
+#include <cmdline.h>
+#endif /* CONFIG_BOARD_NATIVE_SIM */
+
+#include "mqtt_sim.h"
+
+/* Register log module */
+LOG_MODULE_REGISTER(mqtt_sim, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_LEVEL);
+
+enum sim_state {
+	SIM_UNINITIALIZED,
+	SIM_DISCONNECTED,
+	SIM_CONNECTING,
+	SIM_CONNECTED,
+};
+
+/* Message waiting for its PUBACK */
+struct pending {
+	struct k_work_delayable work;
+	uint16_t message_id;
+	int64_t due_ms;
+	bool used;
+};
+
+static struct mqtt_sim_script script = {
+	.connack_delay_ms = CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_CONNACK_DELAY_MS,
+	.puback_delay_ms = CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_PUBACK_DELAY_MS,
+	.puback_jitter_ms = CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_PUBACK_JITTER_MS,
+	.puback_loss_permille = CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_PUBACK_LOSS_PERMILLE,
+	.connect_failures = CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_CONNECT_FAILURES,
+	.disconnect_after = CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_DISCONNECT_AFTER,
+};
+
+/* Seed of the generator used for jitter and loss, so that runs can be reproduced */
+static uint32_t seed = CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_SEED;
+
+static struct mqtt_sim_stats stats;
+static struct mqtt_helper_cb cb;
+static enum sim_state state;
+static uint16_t msg_id;
+
+/* Publishes on the current connection */
+static uint32_t conn_publishes;
+
+/* Uptime at which the last connection was lost, -1 if it was not */
+static int64_t lost_at_ms = -1;
+static int disconnect_result;
+
+static struct pending pubacks[CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_IN_FLIGHT];
+static uint16_t suback_id;
+
+/* Protects the state above. The API is called from the transport module, callbacks are
+ * called from the simulator's workqueue and scripting is done from the shell.
+ */
+static struct k_spinlock lock;
+
+K_THREAD_STACK_DEFINE(sim_stack_area, CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM_STACK_SIZE);
+static struct k_work_q sim_work_q;
+
+static void connack_work_fn(struct k_work *work);
+static void suback_work_fn(struct k_work *work);
+static void disconnect_work_fn(struct k_work *work);
+
+/* Work - Runs on the simulator's workqueue, in place of the MQTT helper's thread */
+static K_WORK_DELAYABLE_DEFINE(connack_work, connack_work_fn);
+static K_WORK_DELAYABLE_DEFINE(suback_work, suback_work_fn);
+static K_WORK_DEFINE(disconnect_work, disconnect_work_fn);
+
+/* xorshift32, must be called with lock held */
+static uint32_t sim_rand(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+static void connack_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (state != SIM_CONNECTING) {
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	state = SIM_CONNECTED;
+	conn_publishes = 0;
+	stats.connects++;
+
+	if (lost_at_ms >= 0) {
+		stats.reconnect_last_ms = k_uptime_get() - lost_at_ms;
+		stats.reconnect_max_ms = MAX(stats.reconnect_max_ms, stats.reconnect_last_ms);
+		lost_at_ms = -1;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	LOG_DBG("CONNACK");
+
+	if (cb.on_connack) {
+		cb.on_connack(MQTT_CONNECTION_ACCEPTED, false);
+	}
+}
+
+static void puback_work_fn(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct pending *entry = CONTAINER_OF(dwork, struct pending, work);
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint16_t message_id;
+
+	/* The entry may have been freed by a disconnect, and reused, since it was scheduled */
+	if (!entry->used || (state != SIM_CONNECTED) || (k_uptime_get() < entry->due_ms)) {
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	message_id = entry->message_id;
+	entry->used = false;
+	stats.pubacks++;
+
+	k_spin_unlock(&lock, key);
+
+	if (cb.on_puback) {
+		cb.on_puback(message_id, 0);
+	}
+}
+
+static void suback_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	bool connected = (state == SIM_CONNECTED);
+	uint16_t message_id = suback_id;
+
+	k_spin_unlock(&lock, key);
+
+	if (connected && cb.on_suback) {
+		cb.on_suback(message_id, 0);
+	}
+}
+
+static void disconnect_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	int result = disconnect_result;
+
+	k_spin_unlock(&lock, key);
+
+	LOG_DBG("Disconnected, result: %d", result);
+
+	if (cb.on_disconnect) {
+		cb.on_disconnect(result);
+	}
+}
+
+/* Must be called with lock held. Returns NULL if too many messages are in flight. */
+static struct pending *pending_get(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(pubacks); i++) {
+		if (!pubacks[i].used) {
+			return &pubacks[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with lock held. Messages in flight are never acknowledged. */
+static void connection_lost(int result, bool injected)
+{
+	state = SIM_DISCONNECTED;
+	disconnect_result = result;
+
+	if (injected) {
+		stats.disconnects_injected++;
+		lost_at_ms = k_uptime_get();
+	} else {
+		stats.disconnects++;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(pubacks); i++) {
+		if (pubacks[i].used) {
+			pubacks[i].used = false;
+			stats.pubacks_lost++;
+		}
+	}
+
+	/* Pending work returns early now that the state has changed, so it does not need to
+	 * be cancelled. The disconnect is reported asynchronously, as the MQTT helper does.
+	 */
+	k_work_submit_to_queue(&sim_work_q, &disconnect_work);
+}
+
+int mqtt_sim_init(struct mqtt_helper_cfg *cfg)
+{
+	static bool started;
+	k_spinlock_key_t key;
+
+	if (!started) {
+		struct k_work_queue_config queue_cfg = {
+			.name = "mqtt_sim",
+		};
+
+		/* Same priority as the MQTT helper's thread */
+		k_work_queue_init(&sim_work_q);
+		k_work_queue_start(&sim_work_q, sim_stack_area,
+				   K_THREAD_STACK_SIZEOF(sim_stack_area),
+				   K_LOWEST_APPLICATION_THREAD_PRIO, &queue_cfg);
+
+		for (size_t i = 0; i < ARRAY_SIZE(pubacks); i++) {
+			k_work_init_delayable(&pubacks[i].work, puback_work_fn);
+		}
+
+		started = true;
+	}
+
+	key = k_spin_lock(&lock);
+
+	cb = cfg->cb;
+	state = SIM_DISCONNECTED;
+
+	/* xorshift never leaves 0 */
+	seed = MAX(seed, 1);
+
+	k_spin_unlock(&lock, key);
+
+	LOG_WRN("Using the simulated MQTT broker");
+
+	return 0;
+}
+
+int mqtt_sim_deinit(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if ((state == SIM_CONNECTED) || (state == SIM_CONNECTING)) {
+		k_spin_unlock(&lock, key);
+		return -EBUSY;
+	}
+
+	cb = (struct mqtt_helper_cb){ 0 };
+	state = SIM_UNINITIALIZED;
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+int mqtt_sim_connect(struct mqtt_helper_conn_params *conn_params)
+{
+	ARG_UNUSED(conn_params);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint32_t delay_ms;
+
+	if (state != SIM_DISCONNECTED) {
+		k_spin_unlock(&lock, key);
+		return -EOPNOTSUPP;
+	}
+
+	if (script.connect_failures > 0) {
+		script.connect_failures--;
+		stats.connects_refused++;
+		k_spin_unlock(&lock, key);
+		return -ECONNREFUSED;
+	}
+
+	state = SIM_CONNECTING;
+	delay_ms = script.connack_delay_ms;
+
+	k_spin_unlock(&lock, key);
+
+	k_work_reschedule_for_queue(&sim_work_q, &connack_work, K_MSEC(delay_ms));
+
+	return 0;
+}
+
+int mqtt_sim_disconnect(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if ((state != SIM_CONNECTED) && (state != SIM_CONNECTING)) {
+		k_spin_unlock(&lock, key);
+		return -ENOTCONN;
+	}
+
+	connection_lost(0, false);
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+int mqtt_sim_publish(const struct mqtt_publish_param *param)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct pending *entry = NULL;
+	uint32_t delay_ms;
+
+	if (state != SIM_CONNECTED) {
+		k_spin_unlock(&lock, key);
+		return -ENOTCONN;
+	}
+
+	/* QoS 0 messages are not acknowledged, so they need no entry */
+	if (param->message.topic.qos != MQTT_QOS_0_AT_MOST_ONCE) {
+		entry = pending_get();
+		if (entry == NULL) {
+			k_spin_unlock(&lock, key);
+			return -ENOBUFS;
+		}
+	}
+
+	stats.publishes++;
+	conn_publishes++;
+
+	if (entry && ((sim_rand() % 1000) < script.puback_loss_permille)) {
+		stats.pubacks_lost++;
+	} else if (entry) {
+		delay_ms = script.puback_delay_ms;
+		if (script.puback_jitter_ms > 0) {
+			delay_ms += sim_rand() % (script.puback_jitter_ms + 1);
+		}
+
+		entry->used = true;
+		entry->message_id = param->message_id;
+		entry->due_ms = k_uptime_get() + delay_ms;
+
+		k_work_reschedule_for_queue(&sim_work_q, &entry->work, K_MSEC(delay_ms));
+	}
+
+	if ((script.disconnect_after > 0) && (conn_publishes >= script.disconnect_after)) {
+		connection_lost(-ECONNRESET, true);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+int mqtt_sim_subscribe(struct mqtt_subscription_list *sub_list)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint32_t delay_ms = script.puback_delay_ms;
+
+	if (state != SIM_CONNECTED) {
+		k_spin_unlock(&lock, key);
+		return -ENOTCONN;
+	}
+
+	suback_id = sub_list->message_id;
+
+	k_spin_unlock(&lock, key);
+
+	k_work_reschedule_for_queue(&sim_work_q, &suback_work, K_MSEC(delay_ms));
+
+	return 0;
+}
+
+uint16_t mqtt_sim_msg_id_get(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	/* Message ID 0 is not allowed */
+	msg_id = (msg_id == UINT16_MAX) ? 1 : (msg_id + 1);
+
+	k_spin_unlock(&lock, key);
+
+	return msg_id;
+}
+
+void mqtt_sim_script_set(const struct mqtt_sim_script *new_script)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	script = *new_script;
+
+	k_spin_unlock(&lock, key);
+}
+
+void mqtt_sim_script_get(struct mqtt_sim_script *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*out = script;
+
+	k_spin_unlock(&lock, key);
+}
+
+int mqtt_sim_disconnect_inject(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if ((state != SIM_CONNECTED) && (state != SIM_CONNECTING)) {
+		k_spin_unlock(&lock, key);
+		return -ENOTCONN;
+	}
+
+	connection_lost(-ECONNRESET, true);
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+void mqtt_sim_stats_get(struct mqtt_sim_stats *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*out = stats;
+
+	k_spin_unlock(&lock, key);
+}
+
+void mqtt_sim_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memset(&stats, 0, sizeof(stats));
+
+	k_spin_unlock(&lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+/* Script parameters by name, for the shell */
+static const struct {
+	const char *name;
+	size_t offset;
+} script_params[] = {
+	{ "connack_delay", offsetof(struct mqtt_sim_script, connack_delay_ms) },
+	{ "puback_delay", offsetof(struct mqtt_sim_script, puback_delay_ms) },
+	{ "puback_jitter", offsetof(struct mqtt_sim_script, puback_jitter_ms) },
+	{ "puback_loss", offsetof(struct mqtt_sim_script, puback_loss_permille) },
+	{ "connect_failures", offsetof(struct mqtt_sim_script, connect_failures) },
+	{ "disconnect_after", offsetof(struct mqtt_sim_script, disconnect_after) },
+};
+
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct mqtt_sim_script current;
+	struct mqtt_sim_stats counters;
+
+	mqtt_sim_script_get(&current);
+	mqtt_sim_stats_get(&counters);
+
+	for (size_t i = 0; i < ARRAY_SIZE(script_params); i++) {
+		shell_print(sh, "%-18s %u", script_params[i].name,
+			    *(uint32_t *)((uint8_t *)&current + script_params[i].offset));
+	}
+
+	shell_print(sh, "Connects: %u, refused: %u", counters.connects, counters.connects_refused);
+	shell_print(sh, "Disconnects: %u, injected: %u", counters.disconnects,
+		    counters.disconnects_injected);
+	shell_print(sh, "Publishes: %u, PUBACKs: %u, lost: %u", counters.publishes,
+		    counters.pubacks, counters.pubacks_lost);
+	shell_print(sh, "Reconnect time: last %u ms, max %u ms", counters.reconnect_last_ms,
+		    counters.reconnect_max_ms);
+
+	return 0;
+}
+
+static int cmd_set(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+
+	struct mqtt_sim_script current;
+
+	mqtt_sim_script_get(&current);
+
+	for (size_t i = 0; i < ARRAY_SIZE(script_params); i++) {
+		if (strcmp(argv[1], script_params[i].name) == 0) {
+			*(uint32_t *)((uint8_t *)&current + script_params[i].offset) =
+				strtoul(argv[2], NULL, 0);
+			mqtt_sim_script_set(&current);
+			return 0;
+		}
+	}
+
+	shell_error(sh, "Unknown parameter: %s", argv[1]);
+
+	return -EINVAL;
+}
+
+static int cmd_disconnect(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int err = mqtt_sim_disconnect_inject();
+
+	if (err) {
+		shell_error(sh, "Not connected");
+		return err;
+	}
+
+	return 0;
+}
+
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	mqtt_sim_stats_reset();
+	shell_print(sh, "Simulated broker counters reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_mqtt_sim,
+	SHELL_CMD(show, NULL, "Show the script and the counters", cmd_show),
+	SHELL_CMD_ARG(set, NULL, "Set a script parameter: set <name> <value>", cmd_set, 3, 0),
+	SHELL_CMD(disconnect, NULL, "Drop the connection", cmd_disconnect),
+	SHELL_CMD(reset, NULL, "Clear the counters", cmd_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(mqtt_sim, &sub_mqtt_sim, "Simulated MQTT broker", NULL);
+#endif /* CONFIG_SHELL */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+static void mqtt_sim_args_add(void)
+{
+	static struct args_struct_t args[] = {
+		{
+			.option = "mqtt-sim-connack-delay",
+			.name = "ms",
+			.type = 'u',
+			.dest = (void *)&script.connack_delay_ms,
+			.descript = "Simulated broker CONNACK delay",
+		},
+		{
+			.option = "mqtt-sim-puback-delay",
+			.name = "ms",
+			.type = 'u',
+			.dest = (void *)&script.puback_delay_ms,
+			.descript = "Simulated broker PUBACK delay",
+		},
+		{
+			.option = "mqtt-sim-puback-jitter",
+			.name = "ms",
+			.type = 'u',
+			.dest = (void *)&script.puback_jitter_ms,
+			.descript = "Simulated broker random extra PUBACK delay",
+		},
+		{
+			.option = "mqtt-sim-puback-loss",
+			.name = "permille",
+			.type = 'u',
+			.dest = (void *)&script.puback_loss_permille,
+			.descript = "Simulated broker PUBACKs lost per thousand publishes",
+		},
+		{
+			.option = "mqtt-sim-connect-failures",
+			.name = "count",
+			.type = 'u',
+			.dest = (void *)&script.connect_failures,
+			.descript = "Simulated broker connection attempts refused",
+		},
+		{
+			.option = "mqtt-sim-disconnect-after",
+			.name = "count",
+			.type = 'u',
+			.dest = (void *)&script.disconnect_after,
+			.descript = "Simulated broker publishes before dropping the connection",
+		},
+		{
+			.option = "mqtt-sim-seed",
+			.name = "seed",
+			.type = 'u',
+			.dest = (void *)&seed,
+			.descript = "Simulated broker random seed, must not be 0",
+		},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(args);
+}
+
+NATIVE_TASK(mqtt_sim_args_add, PRE_BOOT_1, 10);
+#endif /* CONFIG_BOARD_NATIVE_SIM */
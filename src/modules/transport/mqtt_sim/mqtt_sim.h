@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _MQTT_SIM_H_
+#define _MQTT_SIM_H_
+
+/* Simulated MQTT helper.
+ *
+ * Implements the subset of the MQTT helper API that the transport module uses, without a
+ * socket or a broker. Connections are accepted, and messages acknowledged, after scripted
+ * delays. Connection attempts can be refused, PUBACKs can be lost, and the connection can be
+ * dropped, so that the transport module's reconnect and publish behavior can be exercised
+ * deterministically. Callbacks are called from the simulator's own workqueue, as the MQTT
+ * helper calls them from its own thread.
+ */
+
+#include <zephyr/kernel.h>
+#include <net/mqtt_helper.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Scripted behavior of the simulated broker. */
+struct mqtt_sim_script {
+	/* Time from a connection attempt to the CONNACK */
+	uint32_t connack_delay_ms;
+
+	/* Time from a publish to its PUBACK, and from a subscribe to its SUBACK */
+	uint32_t puback_delay_ms;
+
+	/* Random extra PUBACK delay, up to this many milliseconds */
+	uint32_t puback_jitter_ms;
+
+	/* PUBACKs that are never received, per thousand publishes */
+	uint32_t puback_loss_permille;
+
+	/* Number of upcoming connection attempts that are refused */
+	uint32_t connect_failures;
+
+	/* Drop the connection after this many publishes on it, 0 to never drop it */
+	uint32_t disconnect_after;
+};
+
+/** @brief Counters of the simulated broker. */
+struct mqtt_sim_stats {
+	uint32_t connects;
+	uint32_t connects_refused;
+	uint32_t disconnects;
+	uint32_t disconnects_injected;
+	uint32_t publishes;
+	uint32_t pubacks;
+	uint32_t pubacks_lost;
+
+	/* Time from the loss of a connection to the CONNACK of the next one */
+	uint32_t reconnect_last_ms;
+	uint32_t reconnect_max_ms;
+};
+
+/* MQTT helper API, with the same semantics as the mqtt_helper_ functions */
+
+int mqtt_sim_init(struct mqtt_helper_cfg *cfg);
+int mqtt_sim_deinit(void);
+int mqtt_sim_connect(struct mqtt_helper_conn_params *conn_params);
+int mqtt_sim_disconnect(void);
+int mqtt_sim_publish(const struct mqtt_publish_param *param);
+int mqtt_sim_subscribe(struct mqtt_subscription_list *sub_list);
+uint16_t mqtt_sim_msg_id_get(void);
+
+/* Scripting API */
+
+/** @brief Set the behavior of the simulated broker. Takes effect for the next event. */
+void mqtt_sim_script_set(const struct mqtt_sim_script *script);
+
+/** @brief Get the behavior of the simulated broker. */
+void mqtt_sim_script_get(struct mqtt_sim_script *script);
+
+/** @brief Drop the connection, as if the broker closed it.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -ENOTCONN If not connected.
+ */
+int mqtt_sim_disconnect_inject(void);
+
+/** @brief Get the counters of the simulated broker. */
+void mqtt_sim_stats_get(struct mqtt_sim_stats *stats);
+
+/** @brief Clear the counters of the simulated broker. */
+void mqtt_sim_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_SIM_H_ */
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "message_channel.h"
+#include "stream.h"
+
+LOG_MODULE_REGISTER(stream, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_LEVEL);
+
+#define CHUNK_COUNT CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM_CHUNK_COUNT
+#define CHUNK_DATA_SIZE CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM_CHUNK_SIZE
+
+enum chunk_state {
+	/* Available to producers */
+	CHUNK_FREE,
+	/* Being written by the producer */
+	CHUNK_FILLING,
+	/* Waiting to be published */
+	CHUNK_READY,
+	/* Published, waiting for PUBACK */
+	CHUNK_IN_FLIGHT,
+	/* Acknowledged, released once all older chunks are acknowledged */
+	CHUNK_ACKED,
+};
+
+struct chunk {
+	enum chunk_state state;
+	uint16_t message_id;
+	uint16_t seq;
+	uint32_t offset;
+	size_t len;
+	uint8_t buf[STREAM_HEADER_SIZE + CHUNK_DATA_SIZE];
+};
+
+/* Chunks are used in ring order. head is the next chunk handed to the producer, tail the
+ * oldest chunk that has not been released.
+ */
+static struct chunk chunks[CHUNK_COUNT];
+static size_t head;
+static size_t tail;
+
+/* Number of chunks that the producer can take */
+static K_SEM_DEFINE(free_chunks, CHUNK_COUNT, CHUNK_COUNT);
+
+/* Protects the chunk ring and the state of the open stream */
+static K_MUTEX_DEFINE(stream_lock);
+
+/* State of the open stream */
+static struct {
+	bool open;
+	uint16_t id;
+	uint16_t seq;
+	uint32_t offset;
+	struct chunk *filling;
+} current;
+
+static uint16_t next_id;
+
+/* Wake up the transport module so that ready fragments are sent. Notifications carry no
+ * data and are coalesced by the transport, so a failed notification is not an error as
+ * long as one is already pending.
+ */
+static void notify(void)
+{
+	int not_used = -1;
+	int err;
+
+	err = zbus_chan_pub(&STREAM_CHAN, &not_used, K_NO_WAIT);
+	if (err) {
+		LOG_DBG("zbus_chan_pub, error: %d", err);
+	}
+}
+
+/* Must be called with stream_lock held. */
+static struct chunk *chunk_take(void)
+{
+	struct chunk *chunk = &chunks[head];
+
+	__ASSERT_NO_MSG(chunk->state == CHUNK_FREE);
+
+	head = (head + 1) % CHUNK_COUNT;
+
+	chunk->state = CHUNK_FILLING;
+	chunk->seq = current.seq++;
+	chunk->offset = current.offset;
+	chunk->len = STREAM_HEADER_SIZE;
+
+	return chunk;
+}
+
+/* Must be called with stream_lock held. */
+static void chunk_finalize(struct chunk *chunk, bool last)
+{
+	chunk->buf[0] = STREAM_VERSION;
+	chunk->buf[1] = last ? STREAM_FLAG_LAST : 0;
+	sys_put_be16(current.id, &chunk->buf[2]);
+	sys_put_be16(chunk->seq, &chunk->buf[4]);
+	sys_put_be32(chunk->offset, &chunk->buf[6]);
+
+	chunk->state = CHUNK_READY;
+	current.filling = NULL;
+}
+
+int stream_open(void)
+{
+	int id;
+
+	k_mutex_lock(&stream_lock, K_FOREVER);
+
+	if (current.open) {
+		k_mutex_unlock(&stream_lock);
+		return -EBUSY;
+	}
+
+	current.open = true;
+	current.id = next_id++;
+	current.seq = 0;
+	current.offset = 0;
+	current.filling = NULL;
+	id = current.id;
+
+	k_mutex_unlock(&stream_lock);
+
+	LOG_DBG("Stream %d opened", id);
+
+	return id;
+}
+
+int stream_write(const void *data, size_t len, k_timeout_t timeout)
+{
+	const uint8_t *src = data;
+	int err;
+
+	if (!current.open) {
+		return -EINVAL;
+	}
+
+	while (len) {
+		if (current.filling == NULL) {
+			err = k_sem_take(&free_chunks, timeout);
+			if (err) {
+				return -EAGAIN;
+			}
+
+			k_mutex_lock(&stream_lock, K_FOREVER);
+			current.filling = chunk_take();
+			k_mutex_unlock(&stream_lock);
+		}
+
+		struct chunk *chunk = current.filling;
+		size_t copy = MIN(len, sizeof(chunk->buf) - chunk->len);
+
+		memcpy(&chunk->buf[chunk->len], src, copy);
+		chunk->len += copy;
+		current.offset += copy;
+		src += copy;
+		len -= copy;
+
+		if (chunk->len == sizeof(chunk->buf)) {
+			k_mutex_lock(&stream_lock, K_FOREVER);
+			chunk_finalize(chunk, false);
+			k_mutex_unlock(&stream_lock);
+
+			notify();
+		}
+	}
+
+	return 0;
+}
+
+int stream_close(k_timeout_t timeout)
+{
+	int err;
+
+	if (!current.open) {
+		return -EINVAL;
+	}
+
+	/* The last fragment must be marked, so an empty chunk is sent if the data ended
+	 * exactly on a chunk boundary.
+	 */
+	if (current.filling == NULL) {
+		err = k_sem_take(&free_chunks, timeout);
+		if (err) {
+			return -EAGAIN;
+		}
+
+		k_mutex_lock(&stream_lock, K_FOREVER);
+		current.filling = chunk_take();
+		k_mutex_unlock(&stream_lock);
+	}
+
+	k_mutex_lock(&stream_lock, K_FOREVER);
+	chunk_finalize(current.filling, true);
+	current.open = false;
+	k_mutex_unlock(&stream_lock);
+
+	LOG_DBG("Stream %d closed, %u bytes", current.id, current.offset);
+
+	notify();
+
+	return 0;
+}
+
+int stream_fragment_claim(uint16_t message_id, struct stream_fragment *fragment)
+{
+	struct chunk *ready = NULL;
+	size_t in_flight = 0;
+
+	k_mutex_lock(&stream_lock, K_FOREVER);
+
+	/* Walk from the oldest chunk so that fragments are sent in order. */
+	for (size_t i = 0; i < CHUNK_COUNT; i++) {
+		struct chunk *chunk = &chunks[(tail + i) % CHUNK_COUNT];
+
+		if (chunk->state == CHUNK_IN_FLIGHT) {
+			in_flight++;
+		} else if ((chunk->state == CHUNK_READY) && (ready == NULL)) {
+			ready = chunk;
+		}
+	}
+
+	if ((ready == NULL) || (in_flight >= CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM_IN_FLIGHT)) {
+		k_mutex_unlock(&stream_lock);
+		return -ENODATA;
+	}
+
+	ready->state = CHUNK_IN_FLIGHT;
+	ready->message_id = message_id;
+	fragment->buf = ready->buf;
+	fragment->len = ready->len;
+
+	k_mutex_unlock(&stream_lock);
+
+	return 0;
+}
+
+void stream_fragment_unclaim(uint16_t message_id)
+{
+	k_mutex_lock(&stream_lock, K_FOREVER);
+
+	for (size_t i = 0; i < CHUNK_COUNT; i++) {
+		if ((chunks[i].state == CHUNK_IN_FLIGHT) && (chunks[i].message_id == message_id)) {
+			chunks[i].state = CHUNK_READY;
+			break;
+		}
+	}
+
+	k_mutex_unlock(&stream_lock);
+}
+
+bool stream_puback(uint16_t message_id, int result)
+{
+	bool found = false;
+	bool pending = false;
+
+	k_mutex_lock(&stream_lock, K_FOREVER);
+
+	for (size_t i = 0; i < CHUNK_COUNT; i++) {
+		if ((chunks[i].state == CHUNK_IN_FLIGHT) && (chunks[i].message_id == message_id)) {
+			found = true;
+
+			if (result) {
+				/* Sent again, ahead of newer chunks since they are sent in order */
+				chunks[i].state = CHUNK_READY;
+
+				LOG_WRN("Fragment %d at offset %u rejected, error: %d, resending",
+					chunks[i].seq, chunks[i].offset, result);
+				break;
+			}
+
+			chunks[i].state = CHUNK_ACKED;
+
+			LOG_DBG("Fragment %d at offset %u acknowledged", chunks[i].seq,
+				chunks[i].offset);
+			break;
+		}
+	}
+
+	/* Release acknowledged chunks in order, so that the ring keeps its ordering. */
+	while (chunks[tail].state == CHUNK_ACKED) {
+		chunks[tail].state = CHUNK_FREE;
+		tail = (tail + 1) % CHUNK_COUNT;
+		k_sem_give(&free_chunks);
+	}
+
+	for (size_t i = 0; i < CHUNK_COUNT; i++) {
+		if (chunks[i].state == CHUNK_READY) {
+			pending = true;
+			break;
+		}
+	}
+
+	k_mutex_unlock(&stream_lock);
+
+	/* The in-flight window has room again, send the next fragment. */
+	if (found && pending) {
+		notify();
+	}
+
+	return found;
+}
+
+void stream_resume(void)
+{
+	size_t resumed = 0;
+
+	k_mutex_lock(&stream_lock, K_FOREVER);
+
+	for (size_t i = 0; i < CHUNK_COUNT; i++) {
+		if (chunks[i].state == CHUNK_IN_FLIGHT) {
+			chunks[i].state = CHUNK_READY;
+			resumed++;
+		}
+	}
+
+	if (resumed) {
+		LOG_INF("Resuming stream upload from offset %u", chunks[tail].offset);
+	}
+
+	k_mutex_unlock(&stream_lock);
+}
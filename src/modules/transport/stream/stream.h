@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+/* Chunked streaming upload of data larger than the payload channel can carry.
+ *
+ * A producer opens a stream and writes data into it. The data is split into fixed size chunks
+ * that the transport module publishes as sequenced fragments with QoS 1. A chunk is kept until
+ * its PUBACK is received, so that after a reconnect the upload resumes from the oldest
+ * unacknowledged offset. Producers block when all chunks are in use, so RAM usage is bounded
+ * by CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM_CHUNK_COUNT regardless of the stream size.
+ *
+ * Fragment layout, integers are big endian:
+ *   byte 0	Version
+ *   byte 1	Flags, bit 0 is set in the last fragment of a stream
+ *   byte 2-3	Stream ID
+ *   byte 4-5	Sequence number of the fragment within the stream
+ *   byte 6-9	Offset of the fragment data within the stream
+ *   byte 10-	Fragment data
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_VERSION 1
+#define STREAM_HEADER_SIZE 10
+#define STREAM_FLAG_LAST BIT(0)
+
+/** @brief Fragment ready to be published by the transport module. */
+struct stream_fragment {
+	uint8_t *buf;
+	size_t len;
+};
+
+/* Producer API */
+
+/** @brief Open a new stream. Only one stream can be open at a time.
+ *
+ *  @return Stream ID if successful. Otherwise, a negative error code is returned.
+ *  @retval -EBUSY If a stream is already open.
+ */
+int stream_open(void);
+
+/** @brief Write data to the open stream. Blocks while all chunks are waiting to be
+ *	   acknowledged by the broker.
+ *
+ *  @param data Data to write.
+ *  @param len Length of data.
+ *  @param timeout Maximum time to wait for a free chunk.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -EINVAL If no stream is open.
+ *  @retval -EAGAIN If no chunk became free within the timeout. Part of the data may have
+ *		    been written.
+ */
+int stream_write(const void *data, size_t len, k_timeout_t timeout);
+
+/** @brief Close the open stream. The last chunk is marked and queued for sending.
+ *
+ *  @param timeout Maximum time to wait for a free chunk, needed if the stream is empty
+ *		   or the last chunk was already queued.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -EINVAL If no stream is open.
+ *  @retval -EAGAIN If no chunk became free within the timeout.
+ */
+int stream_close(k_timeout_t timeout);
+
+/* Transport API */
+
+/** @brief Claim the oldest fragment that is ready to be sent, if the number of fragments in
+ *	   flight allows it.
+ *
+ *  @param message_id MQTT message ID that the fragment will be published with.
+ *  @param fragment Set to the fragment to publish.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -ENODATA If no fragment is ready or the in-flight window is full.
+ */
+int stream_fragment_claim(uint16_t message_id, struct stream_fragment *fragment);
+
+/** @brief Return a claimed fragment that could not be published. */
+void stream_fragment_unclaim(uint16_t message_id);
+
+/** @brief Handle a PUBACK. Acknowledged chunks are released to producers, and chunks that
+ *	   the broker failed to accept are sent again.
+ *
+ *  @param message_id Message ID of the PUBACK.
+ *  @param result Result of the PUBACK, 0 if the message was accepted.
+ *
+ *  @return true If the message ID belonged to a stream fragment.
+ */
+bool stream_puback(uint16_t message_id, int result);
+
+/** @brief Requeue all fragments that were in flight, called after a reconnect so that
+ *	   the upload resumes from the oldest unacknowledged offset.
+ */
+void stream_resume(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _STREAM_H_ */
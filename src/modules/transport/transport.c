@@ -10,17 +10,50 @@
 #include <zephyr/smf.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/sys/printk.h>
+#include <zephyr/net/socket.h>
 #include <net/mqtt_helper.h>
 
 #include "client_id.h"
 #include "message_channel.h"
+#include "executor.h"
+#include "msg_trace.h"
+#include "boot_timeline.h"
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC)
+#include "ts_codec.h"
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS)
+#include "compress.h"
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+#include "stream.h"
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+#include "log_backend_mqtt.h"
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_LATENCY)
+#include "bench_clock.h"
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_LATENCY */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM)
+#include "mqtt_sim.h"
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS)
+#include "happy_eyeballs.h"
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS */
+
+#if defined(CONFIG_MQTT_SAMPLE_SUPERVISOR)
+#include "supervisor.h"
+#endif /* CONFIG_MQTT_SAMPLE_SUPERVISOR */
 
 /* Register log module */
 LOG_MODULE_REGISTER(transport, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_LEVEL);
 
-/* Register subscriber */
-ZBUS_SUBSCRIBER_DEFINE(transport, CONFIG_MQTT_SAMPLE_TRANSPORT_MESSAGE_QUEUE_SIZE);
-
 /* Forward declaration for publish function */
 static void publish(struct payload *payload);
 
@@ -34,13 +67,86 @@ static void connect_work_fn(struct k_work *work);
 /* Define connection work - Used to handle reconnection attempts to the MQTT broker */
 static K_WORK_DELAYABLE_DEFINE(connect_work, connect_work_fn);
 
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+static void log_upload_work_fn(struct k_work *work);
+
+/* Define log upload work - Used to periodically upload buffered log data while connected */
+static K_WORK_DELAYABLE_DEFINE(log_upload_work, log_upload_work_fn);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
+
+#if defined(CONFIG_MQTT_SAMPLE_SUPERVISOR)
+#define HEARTBEAT_DEADLINE_MS \
+	(CONFIG_MQTT_SAMPLE_SUPERVISOR_TRANSPORT_DEADLINE_SECONDS * MSEC_PER_SEC)
+
+static int transport_restart(void);
+static void heartbeat_work_fn(struct k_work *work);
+static void restart_work_fn(struct k_work *work);
+
+/* Define heartbeat work - Shows the supervisor that the module's workqueue is alive */
+static K_WORK_DELAYABLE_DEFINE(heartbeat_work, heartbeat_work_fn);
+
+/* Define restart work - Used to tear down and re-initialize the module on a fault */
+static K_WORK_DEFINE(restart_work, restart_work_fn);
+
+/* Set while the module is restarted, until the MQTT library has been initialized again */
+static atomic_t restarting;
+
+static struct supervisor_module supervised = {
+	.name = "transport",
+	.deadline_ms = HEARTBEAT_DEADLINE_MS,
+	.restart = transport_restart,
+};
+
+/* Faults restart the module in place when it is supervised, and reboot the device otherwise */
+#define TRANSPORT_FAULT(_err) supervisor_fault(&supervised, SUPERVISOR_FAULT_ERROR, (_err))
+#else
+#define TRANSPORT_FAULT(_err) SEND_FATAL_ERROR_CODE(_err)
+#endif /* CONFIG_MQTT_SAMPLE_SUPERVISOR */
+
+#if !defined(CONFIG_MQTT_SAMPLE_EXECUTOR)
 /* Define stack_area of application workqueue */
 K_THREAD_STACK_DEFINE(stack_area, CONFIG_MQTT_SAMPLE_TRANSPORT_WORKQUEUE_STACK_SIZE);
 
-/* Declare application workqueue. This workqueue is used to call mqtt_helper_connect(), and
- * schedule reconnectionn attempts upon network loss or disconnection from MQTT.
+/* Declare application workqueue */
+static struct k_work_q transport_work_q;
+#endif /* !CONFIG_MQTT_SAMPLE_EXECUTOR */
+
+/* Workqueue used to call mqtt_helper_connect(), and schedule reconnectionn attempts upon
+ * network loss or disconnection from MQTT. When running on the executor, the module's
+ * executor queue is used instead of a private workqueue.
  */
-static struct k_work_q transport_queue;
+static struct k_work_q *transport_queue;
+
+/* MQTT helper API used by the module. The calls go through this table so that the module can
+ * run against the simulated broker instead of the MQTT helper library.
+ */
+static const struct mqtt_api {
+	int (*init)(struct mqtt_helper_cfg *cfg);
+	int (*deinit)(void);
+	int (*connect)(struct mqtt_helper_conn_params *conn_params);
+	int (*disconnect)(void);
+	int (*publish)(const struct mqtt_publish_param *param);
+	int (*subscribe)(struct mqtt_subscription_list *sub_list);
+	uint16_t (*msg_id_get)(void);
+} mqtt = {
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM)
+	.init = mqtt_sim_init,
+	.deinit = mqtt_sim_deinit,
+	.connect = mqtt_sim_connect,
+	.disconnect = mqtt_sim_disconnect,
+	.publish = mqtt_sim_publish,
+	.subscribe = mqtt_sim_subscribe,
+	.msg_id_get = mqtt_sim_msg_id_get,
+#else
+	.init = mqtt_helper_init,
+	.deinit = mqtt_helper_deinit,
+	.connect = mqtt_helper_connect,
+	.disconnect = mqtt_helper_disconnect,
+	.publish = mqtt_helper_publish,
+	.subscribe = mqtt_helper_subscribe,
+	.msg_id_get = mqtt_helper_msg_id_get,
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM */
+};
 
 /* Internal states */
 enum module_state { MQTT_CONNECTED, MQTT_DISCONNECTED };
@@ -48,9 +154,122 @@ enum module_state { MQTT_CONNECTED, MQTT_DISCONNECTED };
 /* MQTT client ID buffer */
 static char client_id[CONFIG_MQTT_SAMPLE_TRANSPORT_CLIENT_ID_BUFFER_SIZE];
 
+/* Set once the client ID and the topics have been computed */
+static bool identity_ready;
+
+/* Broker address resolved ahead of the connection, as a string that mqtt_helper resolves
+ * without a DNS query.
+ */
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS)
+static char broker_addr[NET_IPV6_ADDR_LEN];
+#else
+static char broker_addr[NET_IPV4_ADDR_LEN];
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS */
+
+/* Time that network connectivity was reported at, bounds the resolution retries */
+static int64_t network_connected_ms;
+
+/* Deferral of data that is not urgent while the link is poor. Each kind of data has its own
+ * gate, only used from the context that sends that data.
+ */
+struct tx_gate {
+	const char *name;
+
+	/* Time that the data was first held back at, 0 if not deferred */
+	int64_t deferred_since_ms;
+};
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING)
+/* Last link quality level, written by the module's handler */
+static atomic_t link_level = ATOMIC_INIT(LINK_QUALITY_UNKNOWN);
+
+/* Whether deferred data can be sent now, because the link is not poor, or because it has been
+ * held back for the maximum time.
+ */
+static bool tx_gate_open(struct tx_gate *gate)
+{
+	int64_t now;
+
+	if (atomic_get(&link_level) != LINK_QUALITY_POOR) {
+		gate->deferred_since_ms = 0;
+		return true;
+	}
+
+	now = k_uptime_get();
+
+	if (gate->deferred_since_ms == 0) {
+		LOG_INF("Link quality poor, deferring %s", gate->name);
+		gate->deferred_since_ms = now;
+		return false;
+	}
+
+	if ((now - gate->deferred_since_ms) <
+	    (CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING_MAX_DEFER_SECONDS * MSEC_PER_SEC)) {
+		return false;
+	}
+
+	LOG_INF("Maximum deferral reached, sending %s", gate->name);
+	gate->deferred_since_ms = 0;
+
+	return true;
+}
+#else
+static inline bool tx_gate_open(struct tx_gate *gate)
+{
+	ARG_UNUSED(gate);
+
+	return true;
+}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING */
+
 static uint8_t pub_topic[sizeof(client_id) + sizeof(CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_TOPIC)];
 static uint8_t sub_topic[sizeof(client_id) + sizeof(CONFIG_MQTT_SAMPLE_TRANSPORT_SUBSCRIBE_TOPIC)];
 
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC)
+static uint8_t ts_topic[sizeof(client_id) + sizeof(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_TOPIC)];
+
+/* Block that samples are batched into before being published on the time-series topic. */
+static uint8_t ts_block[CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BUFFER_SIZE];
+static struct ts_codec_enc ts_enc;
+
+/* Time series of the samples in the current block. A block only holds one series. */
+static uint8_t ts_series;
+static struct tx_gate ts_gate = { .name = "time-series blocks" };
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+static uint8_t stream_topic[sizeof(client_id) + sizeof(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM_TOPIC)];
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+static uint8_t log_topic[sizeof(client_id) + sizeof(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_TOPIC)];
+static struct tx_gate log_gate = { .name = "log upload" };
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+static uint8_t telemetry_topic[sizeof(client_id) +
+			       sizeof(CONFIG_MQTT_SAMPLE_TRANSPORT_TELEMETRY_TOPIC)];
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS)
+/* Compressor state and the buffer that messages are framed into before publishing. The lock
+ * is needed because logs are published from the workqueue.
+ */
+static struct compress_enc compress_enc;
+static uint8_t compress_buf[CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_BUFFER_SIZE];
+static K_MUTEX_DEFINE(compress_lock);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_LATENCY)
+/* Publish latency accumulated since the last report */
+static struct {
+	uint32_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t log_ns;
+} latency;
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_LATENCY */
+
 /* User defined state object.
  * Used to transfer data between state changes.
  */
@@ -66,6 +285,11 @@ static struct s_object {
 
 	/* Payload */
 	struct payload payload;
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+	/* Telemetry */
+	struct telemetry telemetry;
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
 } s_obj;
 
 /* Callback handlers from MQTT helper library.
@@ -76,6 +300,8 @@ static void on_mqtt_connack(enum mqtt_conn_return_code return_code, bool session
 {
 	ARG_UNUSED(return_code);
 
+	boot_timeline_mark(BOOT_PHASE_CONNACK);
+
 	/* Publish transport connected status */
 	enum transport_status status = TRANSPORT_CONNECTED;
 	int ret = zbus_chan_pub(&TRANSPORT_CHAN, &status, K_SECONDS(1));
@@ -84,12 +310,25 @@ static void on_mqtt_connack(enum mqtt_conn_return_code return_code, bool session
 	}
 
 	smf_set_state(SMF_CTX(&s_obj), &state[MQTT_CONNECTED]);
+
+#if defined(CONFIG_MQTT_SAMPLE_SUPERVISOR)
+	supervisor_recovered(&supervised);
+#endif /* CONFIG_MQTT_SAMPLE_SUPERVISOR */
 }
 
 static void on_mqtt_disconnect(int result)
 {
 	ARG_UNUSED(result);
 
+#if defined(CONFIG_MQTT_SAMPLE_SUPERVISOR)
+	/* The restart continues now that the connection is closed. Queued ahead of the
+	 * connection attempt that entering the disconnected state schedules.
+	 */
+	if (atomic_get(&restarting)) {
+		k_work_submit_to_queue(transport_queue, &restart_work);
+	}
+#endif /* CONFIG_MQTT_SAMPLE_SUPERVISOR */
+
 	/* Publish transport disconnected status */
 	enum transport_status status = TRANSPORT_DISCONNECTED;
 	int ret = zbus_chan_pub(&TRANSPORT_CHAN, &status, K_SECONDS(1));
@@ -108,6 +347,37 @@ static void on_mqtt_publish(struct mqtt_helper_buf topic, struct mqtt_helper_buf
 							 topic.ptr);
 }
 
+static void on_mqtt_puback(uint16_t message_id, int result)
+{
+	static bool first_acked;
+
+	if (result) {
+		LOG_WRN("PUBACK error for message ID %d: %d", message_id, result);
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+		/* A rejected fragment would otherwise stay in flight and stall the upload */
+		(void)stream_puback(message_id, result);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+		return;
+	}
+
+	/* Time from boot to the first message acknowledged by the broker, the end of startup as
+	 * seen from the cloud.
+	 */
+	if (!first_acked) {
+		first_acked = true;
+		LOG_INF("First message acknowledged %lld ms after boot", k_uptime_get());
+		boot_timeline_mark(BOOT_PHASE_FIRST_PUBACK);
+	}
+
+	msg_trace_acked(message_id);
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+	(void)stream_puback(message_id, 0);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+}
+
 static void on_mqtt_suback(uint16_t message_id, int result)
 {
 	if ((message_id == SUBSCRIBE_TOPIC_ID) && (result == 0)) {
@@ -140,33 +410,405 @@ static int topics_prefix(void)
 		return -EMSGSIZE;
 	}
 
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC)
+	len = snprintk(ts_topic, sizeof(ts_topic), "%s/%s", client_id,
+		       CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_TOPIC);
+	if ((len < 0) || (len >= sizeof(ts_topic))) {
+		LOG_ERR("Time-series topic buffer too small");
+		return -EMSGSIZE;
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+	len = snprintk(stream_topic, sizeof(stream_topic), "%s/%s", client_id,
+		       CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM_TOPIC);
+	if ((len < 0) || (len >= sizeof(stream_topic))) {
+		LOG_ERR("Stream topic buffer too small");
+		return -EMSGSIZE;
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+	len = snprintk(log_topic, sizeof(log_topic), "%s/%s", client_id,
+		       CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_TOPIC);
+	if ((len < 0) || (len >= sizeof(log_topic))) {
+		LOG_ERR("Log topic buffer too small");
+		return -EMSGSIZE;
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+	len = snprintk(telemetry_topic, sizeof(telemetry_topic), "%s/%s", client_id,
+		       CONFIG_MQTT_SAMPLE_TRANSPORT_TELEMETRY_TOPIC);
+	if ((len < 0) || (len >= sizeof(telemetry_topic))) {
+		LOG_ERR("Telemetry topic buffer too small");
+		return -EMSGSIZE;
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
+
 	return 0;
 }
 
-static void publish(struct payload *payload)
+/* Compute the client ID and the topics. Done at boot, so that it runs while the network
+ * connects instead of on the connection's critical path. Done again before connecting if it
+ * failed at boot, as the hardware ID may not be available that early, for instance the IMEI
+ * before the modem is initialized.
+ */
+static int identity_prepare(void)
 {
 	int err;
 
+	if (identity_ready) {
+		return 0;
+	}
+
+	err = client_id_get(client_id, sizeof(client_id));
+	if (err) {
+		return err;
+	}
+
+	err = topics_prefix();
+	if (err) {
+		LOG_ERR("topics_prefix, error: %d", err);
+		return err;
+	}
+
+	identity_ready = true;
+	boot_timeline_mark(BOOT_PHASE_CLIENT_ID);
+
+	return 0;
+}
+
+/* Resolve the broker hostname. Used as the check that the network stack is ready to connect,
+ * in place of a fixed delay, and lets mqtt_helper connect without a second DNS query.
+ */
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS)
+static int broker_resolve(void)
+{
+	int err;
+	struct happy_eyeballs_result result;
+
+	/* Both families are raced, and the address that connects first is used */
+	err = happy_eyeballs_connect(CONFIG_MQTT_SAMPLE_TRANSPORT_BROKER_HOSTNAME,
+				     CONFIG_MQTT_HELPER_PORT, &result);
+	if (err) {
+		return err;
+	}
+
+	strcpy(broker_addr, result.addr);
+
+	LOG_DBG("Broker resolved to %s", broker_addr);
+	boot_timeline_mark(BOOT_PHASE_BROKER_RESOLVED);
+
+	return 0;
+}
+#else
+static int broker_resolve(void)
+{
+	int err;
+	struct zsock_addrinfo *result;
+	struct zsock_addrinfo hints = {
+		.ai_family = AF_INET,
+		.ai_socktype = SOCK_STREAM,
+	};
+
+	err = zsock_getaddrinfo(CONFIG_MQTT_SAMPLE_TRANSPORT_BROKER_HOSTNAME, NULL, &hints,
+				&result);
+	if (err) {
+		LOG_DBG("zsock_getaddrinfo, error: %d", err);
+		return -EAGAIN;
+	}
+
+	if (zsock_inet_ntop(AF_INET, &net_sin(result->ai_addr)->sin_addr, broker_addr,
+			    sizeof(broker_addr)) == NULL) {
+		err = -EINVAL;
+	}
+
+	zsock_freeaddrinfo(result);
+
+	if (err) {
+		return err;
+	}
+
+	LOG_DBG("Broker resolved to %s", broker_addr);
+	boot_timeline_mark(BOOT_PHASE_BROKER_RESOLVED);
+
+	return 0;
+}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_HAPPY_EYEBALLS */
+
+/* Publish a buffer with QoS 1 on the given topic. If compress is set and compression is
+ * enabled, the buffer is framed by the compression stage first.
+ */
+static int publish_raw(uint8_t *topic, void *data, size_t len, bool compress,
+		       uint16_t message_id)
+{
+	int err;
 	struct mqtt_publish_param param = {
-		.message.payload.data = payload->string,
-		.message.payload.len = strlen(payload->string),
+		.message.payload.data = data,
+		.message.payload.len = len,
 		.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE,
-		.message_id = mqtt_helper_msg_id_get(),
-		.message.topic.topic.utf8 = pub_topic,
-		.message.topic.topic.size = strlen(pub_topic),
+		.message_id = message_id,
+		.message.topic.topic.utf8 = topic,
+		.message.topic.topic.size = strlen(topic),
 	};
 
-	err = mqtt_helper_publish(&param);
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS)
+	if (compress) {
+		int ret;
+
+		k_mutex_lock(&compress_lock, K_FOREVER);
+
+		ret = compress_frame(&compress_enc, data, len, compress_buf,
+				     sizeof(compress_buf), NULL);
+		if (ret < 0) {
+			k_mutex_unlock(&compress_lock);
+			LOG_ERR("compress_frame, error: %d", ret);
+			return ret;
+		}
+
+		param.message.payload.data = compress_buf;
+		param.message.payload.len = ret;
+
+		err = mqtt.publish(&param);
+
+		k_mutex_unlock(&compress_lock);
+
+		if (err == 0) {
+			boot_timeline_mark(BOOT_PHASE_FIRST_PUBLISH);
+		}
+
+		return err;
+	}
+#else
+	ARG_UNUSED(compress);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS */
+
+	err = mqtt.publish(&param);
+	if (err == 0) {
+		boot_timeline_mark(BOOT_PHASE_FIRST_PUBLISH);
+	}
+
+	return err;
+}
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_LATENCY)
+static uint64_t latency_stamp(void)
+{
+	return bench_clock_ns();
+}
+
+/* Record the latency of a publish that started at start, and that started logging at
+ * log_start. A summary is printed with printk() so that it is available with logging disabled.
+ */
+static void latency_record(uint64_t start, uint64_t log_start)
+{
+	uint64_t end = bench_clock_ns();
+	uint64_t total_ns = end - start;
+
+	latency.count++;
+	latency.total_ns += total_ns;
+	latency.log_ns += end - log_start;
+	latency.max_ns = MAX(latency.max_ns, total_ns);
+
+	if (latency.count < CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_LATENCY_REPORT_INTERVAL) {
+		return;
+	}
+
+	printk("Publish latency over %u messages: avg %u ns, max %u ns, logging avg %u ns\n",
+	       latency.count,
+	       (uint32_t)(latency.total_ns / latency.count),
+	       (uint32_t)latency.max_ns,
+	       (uint32_t)(latency.log_ns / latency.count));
+
+	memset(&latency, 0, sizeof(latency));
+}
+#else
+static inline uint64_t latency_stamp(void)
+{
+	return 0;
+}
+
+static inline void latency_record(uint64_t start, uint64_t log_start)
+{
+	ARG_UNUSED(start);
+	ARG_UNUSED(log_start);
+}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_PUBLISH_LATENCY */
+
+/* Unused when samples are batched into time-series blocks. */
+static __maybe_unused void publish(struct payload *payload)
+{
+	int err;
+	size_t len = strlen(payload->string);
+	uint16_t message_id = mqtt.msg_id_get();
+	uint64_t start = latency_stamp();
+	uint64_t log_start;
+
+	err = publish_raw(pub_topic, payload->string, len,
+			  IS_ENABLED(CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_PUBLISH_TOPIC),
+			  message_id);
 	if (err) {
 		LOG_WRN("Failed to send payload, err: %d", err);
 		return;
 	}
 
-	LOG_INF("Published message: \"%.*s\" on topic: \"%.*s\"", param.message.payload.len,
-								  param.message.payload.data,
-								  param.message.topic.topic.size,
-								  param.message.topic.topic.utf8);
+#if defined(CONFIG_MQTT_SAMPLE_MSG_TRACE)
+	msg_trace_sent(payload->trace_id, message_id);
+#endif /* CONFIG_MQTT_SAMPLE_MSG_TRACE */
+
+	log_start = latency_stamp();
+
+	/* Debug level, formatting the payload on every publish is too costly to do by default. */
+	LOG_DBG("Published message: \"%.*s\" on topic: \"%s\"", (int)len, payload->string,
+		pub_topic);
+
+	latency_record(start, log_start);
+}
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC)
+/* Publish the current time-series block, if any, and start a new one. */
+static void ts_batch_flush(void)
+{
+	int err;
+	uint16_t count = ts_codec_enc_count(&ts_enc);
+	size_t len;
+
+	if (count == 0) {
+		return;
+	}
+
+	len = ts_codec_enc_finish(&ts_enc);
+
+	err = publish_raw(ts_topic, ts_block, len,
+			  IS_ENABLED(CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_TS_TOPIC),
+			  mqtt.msg_id_get());
+	if (err) {
+		LOG_WRN("Failed to send time-series block, err: %d", err);
+	} else {
+		LOG_INF("Published %d samples in %zu bytes on topic: \"%s\"", count, len, ts_topic);
+	}
+
+	(void)ts_codec_enc_init(&ts_enc, TS_CODEC_VALUE_DOUBLE, ts_block, sizeof(ts_block));
+	ts_gate.deferred_since_ms = 0;
+}
+
+/* Publish the current time-series block if it has reached the batch size, unless it is
+ * deferred. A deferred block keeps collecting samples until its buffer is full.
+ */
+static void ts_batch_send(void)
+{
+	if ((ts_codec_enc_count(&ts_enc) >= CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BATCH_SIZE) &&
+	    tx_gate_open(&ts_gate)) {
+		ts_batch_flush();
+	}
+}
+
+/* Add a sample to the current time-series block, publishing the block when it is full. */
+static void ts_batch_add(struct payload *payload)
+{
+	int err;
+
+	/* The deltas are only meaningful within a series */
+	if (payload->series != ts_series) {
+		ts_batch_flush();
+		ts_series = payload->series;
+	}
+
+	err = ts_codec_enc_add_double(&ts_enc, payload->timestamp, payload->value);
+	if ((err == -ENOMEM) || (err == -EINVAL)) {
+		/* The block is full, or the timestamp went backwards. Either way the sample
+		 * must start a new block.
+		 */
+		ts_batch_flush();
+
+		err = ts_codec_enc_add_double(&ts_enc, payload->timestamp, payload->value);
+	}
+
+	if (err) {
+		LOG_WRN("Failed to add sample to time-series block, err: %d", err);
+		return;
+	}
+
+	ts_batch_send();
+}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+/* Publish stream fragments until none are ready or the in-flight window is full. */
+static void stream_send(void)
+{
+	int err;
+	struct stream_fragment fragment;
+
+	while (true) {
+		uint16_t message_id = mqtt.msg_id_get();
+
+		if (stream_fragment_claim(message_id, &fragment)) {
+			return;
+		}
+
+		err = publish_raw(stream_topic, fragment.buf, fragment.len, false, message_id);
+		if (err) {
+			LOG_WRN("Failed to send stream fragment, err: %d", err);
+			stream_fragment_unclaim(message_id);
+			return;
+		}
+	}
+}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+/* Log upload work - Used to drain the log buffer to the log topic while connected. The
+ * amount sent per run is bounded, so that log output generated while uploading does not keep
+ * the work running.
+ */
+static void log_upload_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err;
+	uint8_t *data;
+	size_t len;
+	size_t sent = 0;
+	static uint32_t dropped_reported;
+	uint32_t dropped = log_backend_mqtt_dropped_get();
+
+	if (dropped != dropped_reported) {
+		LOG_WRN("%u bytes of log output dropped", dropped - dropped_reported);
+		dropped_reported = dropped;
+	}
+
+	if (!tx_gate_open(&log_gate)) {
+		k_work_reschedule_for_queue(transport_queue, &log_upload_work,
+				K_SECONDS(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_INTERVAL_SECONDS));
+		return;
+	}
+
+	while (sent < CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_BUFFER_SIZE) {
+		len = log_backend_mqtt_claim(&data, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_CHUNK_SIZE);
+		if (len == 0) {
+			break;
+		}
+
+		err = publish_raw(log_topic, data, len,
+				  IS_ENABLED(CONFIG_MQTT_SAMPLE_TRANSPORT_COMPRESS_LOG_TOPIC),
+				  mqtt.msg_id_get());
+		if (err) {
+			/* Keep the data for the next attempt */
+			log_backend_mqtt_finish(0);
+			LOG_DBG("Failed to send log data, err: %d", err);
+			break;
+		}
+
+		log_backend_mqtt_finish(len);
+		sent += len;
+	}
+
+	k_work_reschedule_for_queue(transport_queue, &log_upload_work,
+			K_SECONDS(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD_INTERVAL_SECONDS));
 }
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
 
 static void subscribe(void)
 {
@@ -188,7 +830,7 @@ static void subscribe(void)
 		LOG_INF("Subscribing to: %s", (char *)list.list[i].topic.utf8);
 	}
 
-	err = mqtt_helper_subscribe(&list);
+	err = mqtt.subscribe(&list);
 	if (err) {
 		LOG_ERR("Failed to subscribe to topics, error: %d", err);
 		return;
@@ -203,33 +845,50 @@ static void connect_work_fn(struct k_work *work)
 	ARG_UNUSED(work);
 
 	int err;
-	struct mqtt_helper_conn_params conn_params = {
-		.hostname.ptr = CONFIG_MQTT_SAMPLE_TRANSPORT_BROKER_HOSTNAME,
-		.hostname.size = strlen(CONFIG_MQTT_SAMPLE_TRANSPORT_BROKER_HOSTNAME),
-		.device_id.ptr = client_id,
-		.device_id.size = strlen(client_id),
-	};
+	const char *hostname = CONFIG_MQTT_SAMPLE_TRANSPORT_BROKER_HOSTNAME;
+	struct mqtt_helper_conn_params conn_params;
 
-	err = client_id_get(client_id, sizeof(client_id));
+	err = identity_prepare();
 	if (err) {
-		LOG_ERR("client_id_get, error: %d", err);
-		SEND_FATAL_ERROR();
+		LOG_ERR("identity_prepare, error: %d", err);
+		TRANSPORT_FAULT(err);
 		return;
 	}
 
-	err = topics_prefix();
-	if (err) {
-		LOG_ERR("topics_prefix, error: %d", err);
-		SEND_FATAL_ERROR();
-		return;
+	if (!IS_ENABLED(CONFIG_MQTT_SAMPLE_TRANSPORT_MQTT_SIM)) {
+		err = broker_resolve();
+		if ((err == -EAGAIN) &&
+		    ((k_uptime_get() - network_connected_ms) <
+		     (CONFIG_MQTT_SAMPLE_TRANSPORT_RECONNECTION_TIMEOUT_SECONDS * MSEC_PER_SEC))) {
+			/* Network stack not ready yet, typically the DHCP lease is pending */
+			k_work_reschedule_for_queue(transport_queue, &connect_work,
+					K_MSEC(CONFIG_MQTT_SAMPLE_TRANSPORT_RESOLVE_RETRY_MS));
+			return;
+		}
+
+		/* With TLS the hostname is needed for server name indication and certificate
+		 * verification, so the resolved address is only used without it.
+		 */
+		if ((err == 0) && !IS_ENABLED(CONFIG_MQTT_LIB_TLS)) {
+			hostname = broker_addr;
+		}
 	}
 
-	err = mqtt_helper_connect(&conn_params);
+	conn_params = (struct mqtt_helper_conn_params) {
+		.hostname.ptr = hostname,
+		.hostname.size = strlen(hostname),
+		.device_id.ptr = client_id,
+		.device_id.size = strlen(client_id),
+	};
+
+	boot_timeline_mark(BOOT_PHASE_MQTT_CONNECT);
+
+	err = mqtt.connect(&conn_params);
 	if (err) {
 		LOG_ERR("Failed connecting to MQTT, error code: %d", err);
 	}
 
-	k_work_reschedule_for_queue(&transport_queue, &connect_work,
+	k_work_reschedule_for_queue(transport_queue, &connect_work,
 			  K_SECONDS(CONFIG_MQTT_SAMPLE_TRANSPORT_RECONNECTION_TIMEOUT_SECONDS));
 }
 
@@ -244,7 +903,8 @@ static void disconnected_entry(void *o)
 	 * disconnected state.
 	 */
 	if (user_object->status == NETWORK_CONNECTED) {
-		k_work_reschedule_for_queue(&transport_queue, &connect_work, K_NO_WAIT);
+		network_connected_ms = k_uptime_get();
+		k_work_reschedule_for_queue(transport_queue, &connect_work, K_NO_WAIT);
 	}
 }
 
@@ -262,11 +922,12 @@ static void disconnected_run(void *o)
 
 	if ((user_object->status == NETWORK_CONNECTED) && (user_object->chan == &NETWORK_CHAN)) {
 
-		/* Wait for 5 seconds to ensure that the network stack is ready before
-		 * attempting to connect to MQTT. This delay is only needed when building for
-		 * Wi-Fi.
+		/* Connect right away. The connect work retries the broker resolution until the
+		 * network stack is ready, instead of waiting a fixed time.
 		 */
-		k_work_reschedule_for_queue(&transport_queue, &connect_work, K_SECONDS(5));
+		network_connected_ms = k_uptime_get();
+		k_work_reschedule_for_queue(transport_queue, &connect_work,
+					    K_MSEC(CONFIG_MQTT_SAMPLE_TRANSPORT_CONNECT_DELAY_MS));
 	}
 }
 
@@ -285,6 +946,17 @@ static void connected_entry(void *o)
 	k_work_cancel_delayable(&connect_work);
 
 	subscribe();
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+	/* Fragments that were in flight when the connection was lost are sent again */
+	stream_resume();
+	stream_send();
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+	/* Upload the log output buffered while disconnected */
+	k_work_reschedule_for_queue(transport_queue, &log_upload_work, K_NO_WAIT);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
 }
 
 /* Function executed when the module is in the connected state. */
@@ -297,15 +969,61 @@ static void connected_run(void *o)
 		 * This is to cleanup any internal library state.
 		 * The call to this function will cause on_mqtt_disconnect() to be called.
 		 */
-		(void)mqtt_helper_disconnect();
+		(void)mqtt.disconnect();
+		return;
+	}
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+	if (user_object->chan == &STREAM_CHAN) {
+		stream_send();
+		return;
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING)
+	if (user_object->chan == &LINK_QUALITY_CHAN) {
+		/* Send deferred data once the link improves, or its deferral deadline passed */
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC)
+		ts_batch_send();
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC */
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+		if (log_gate.deferred_since_ms && (atomic_get(&link_level) != LINK_QUALITY_POOR)) {
+			k_work_reschedule_for_queue(transport_queue, &log_upload_work, K_NO_WAIT);
+		}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
+
+		return;
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING */
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+	if (user_object->chan == &TELEMETRY_CHAN) {
+		int err = publish_raw(telemetry_topic, user_object->telemetry.string,
+				      strlen(user_object->telemetry.string), false,
+				      mqtt.msg_id_get());
+		if (err) {
+			LOG_WRN("Failed to send telemetry, err: %d", err);
+		}
+
 		return;
 	}
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
 
 	if (user_object->chan != &PAYLOAD_CHAN) {
 		return;
 	}
 
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC)
+	/* Payloads that are not part of a time series are published as they are */
+	if (user_object->payload.series == PAYLOAD_SERIES_NONE) {
+		publish(&user_object->payload);
+	} else {
+		ts_batch_add(&user_object->payload);
+	}
+#else
 	publish(&user_object->payload);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC */
 }
 
 /* Function executed when the module exits the connected state. */
@@ -314,6 +1032,10 @@ static void connected_exit(void *o)
 	ARG_UNUSED(o);
 
 	LOG_INF("Disconnected from MQTT broker");
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD)
+	k_work_cancel_delayable(&log_upload_work);
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_UPLOAD */
 }
 
 /* Construct state table */
@@ -324,87 +1046,263 @@ static const struct smf_state state[] = {
 					    NULL, NULL),
 };
 
-static void transport_task(void)
+/* MQTT helper configuration, also used when the module is restarted */
+static struct mqtt_helper_cfg mqtt_cfg = {
+	.cb = {
+		.on_connack = on_mqtt_connack,
+		.on_disconnect = on_mqtt_disconnect,
+		.on_publish = on_mqtt_publish,
+		.on_puback = on_mqtt_puback,
+		.on_suback = on_mqtt_suback,
+	},
+};
+
+#if defined(CONFIG_MQTT_SAMPLE_SUPERVISOR)
+static void heartbeat_work_fn(struct k_work *work)
 {
+	ARG_UNUSED(work);
+
+	supervisor_heartbeat(&supervised);
+
+	k_work_reschedule_for_queue(transport_queue, &heartbeat_work,
+				    K_MSEC(MAX(HEARTBEAT_DEADLINE_MS / 4, MSEC_PER_SEC)));
+}
+
+/* Restart work - Closes the connection, re-initializes the MQTT library and sets the module
+ * back to the disconnected state, which connects again if the network is up. Runs on the
+ * module's workqueue, so a restart cannot help if that workqueue is stuck, in which case the
+ * supervisor reboots the device once the recovery times out.
+ */
+static void restart_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
 	int err;
-	const struct zbus_channel *chan;
-	enum network_status status;
-	struct payload payload;
-	struct mqtt_helper_cfg cfg = {
-		.cb = {
-			.on_connack = on_mqtt_connack,
-			.on_disconnect = on_mqtt_disconnect,
-			.on_publish = on_mqtt_publish,
-			.on_suback = on_mqtt_suback,
-		},
-	};
 
+	if (!atomic_set(&restarting, 1)) {
+		LOG_WRN("Restarting");
+	}
+
+	k_work_cancel_delayable(&connect_work);
+
+	/* Continued from on_mqtt_disconnect() if there was a connection to close */
+	if (mqtt.disconnect() == 0) {
+		return;
+	}
+
+	err = mqtt.deinit();
+	if (err) {
+		LOG_ERR("mqtt_helper_deinit, error: %d", err);
+		atomic_clear(&restarting);
+		TRANSPORT_FAULT(err);
+		return;
+	}
+
+	err = mqtt.init(&mqtt_cfg);
+	if (err) {
+		LOG_ERR("mqtt_helper_init, error: %d", err);
+		atomic_clear(&restarting);
+		TRANSPORT_FAULT(err);
+		return;
+	}
+
+	atomic_clear(&restarting);
+
+	err = zbus_chan_read(&NETWORK_CHAN, &s_obj.status, K_SECONDS(1));
+	if (err) {
+		LOG_ERR("zbus_chan_read, error: %d", err);
+	}
+
+	/* Runs the exit action of the current state, and the entry action of the disconnected
+	 * state even if the module is already in it.
+	 */
+	smf_set_state(SMF_CTX(&s_obj), &state[MQTT_DISCONNECTED]);
+
+	/* Nothing more to do until the network is back, which is the module's normal state */
+	if (s_obj.status != NETWORK_CONNECTED) {
+		supervisor_recovered(&supervised);
+	}
+}
+
+static int transport_restart(void)
+{
+	k_work_submit_to_queue(transport_queue, &restart_work);
+
+	return 0;
+}
+#endif /* CONFIG_MQTT_SAMPLE_SUPERVISOR */
+
+static int transport_init(void)
+{
+	int err;
+
+#if defined(CONFIG_MQTT_SAMPLE_EXECUTOR)
+	transport_queue = executor_queue_get(CONFIG_MQTT_SAMPLE_TRANSPORT_EXECUTOR_QUEUE);
+#else
 	/* Initialize and start application workqueue.
 	 * This workqueue can be used to offload tasks and/or as a timer when wanting to
 	 * schedule functionality using the 'k_work' API.
 	 */
-	k_work_queue_init(&transport_queue);
-	k_work_queue_start(&transport_queue, stack_area,
+	transport_queue = &transport_work_q;
+
+	k_work_queue_init(transport_queue);
+	k_work_queue_start(transport_queue, stack_area,
 			   K_THREAD_STACK_SIZEOF(stack_area),
 			   K_HIGHEST_APPLICATION_THREAD_PRIO,
 			   NULL);
+#endif /* CONFIG_MQTT_SAMPLE_EXECUTOR */
 
-	err = mqtt_helper_init(&cfg);
+	err = mqtt.init(&mqtt_cfg);
 	if (err) {
 		LOG_ERR("mqtt_helper_init, error: %d", err);
-		SEND_FATAL_ERROR();
-		return;
+		SEND_FATAL_ERROR_CODE(err);
+		return err;
 	}
 
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC)
+	(void)ts_codec_enc_init(&ts_enc, TS_CODEC_VALUE_DOUBLE, ts_block, sizeof(ts_block));
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC */
 
+	/* Off the connection's critical path. Retried before connecting if not yet possible. */
+	err = identity_prepare();
+	if (err) {
+		LOG_DBG("identity_prepare, error: %d, retried when connecting", err);
+	}
 
 	/* Set initial state */
 	smf_set_initial(SMF_CTX(&s_obj), &state[MQTT_DISCONNECTED]);
 
-	while (!zbus_sub_wait(&transport, &chan, K_FOREVER)) {
+#if defined(CONFIG_MQTT_SAMPLE_SUPERVISOR)
+	err = supervisor_register(&supervised);
+	if (err) {
+		LOG_ERR("supervisor_register, error: %d", err);
+		SEND_FATAL_ERROR_CODE(err);
+		return err;
+	}
+
+	if (HEARTBEAT_DEADLINE_MS) {
+		k_work_reschedule_for_queue(transport_queue, &heartbeat_work, K_NO_WAIT);
+	}
+#endif /* CONFIG_MQTT_SAMPLE_SUPERVISOR */
+
+	return 0;
+}
+
+static void transport_handler(const struct zbus_channel *chan)
+{
+	int err;
+	enum network_status status;
+	struct payload payload;
+
+	s_obj.chan = chan;
+
+	if (&NETWORK_CHAN == chan) {
+
+		err = zbus_chan_read(&NETWORK_CHAN, &status, K_SECONDS(1));
+		if (err) {
+			LOG_ERR("zbus_chan_read, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
+		}
+
+		s_obj.status = status;
+
+		err = smf_run_state(SMF_CTX(&s_obj));
+		if (err) {
+			LOG_ERR("smf_run_state, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
+		}
+	}
+
+	if (&PAYLOAD_CHAN == chan) {
+
+		err = zbus_chan_read(&PAYLOAD_CHAN, &payload, K_SECONDS(1));
+
+		/* The next payload can be published once this one is copied out */
+		payload_consumed();
+
+		if (err) {
+			LOG_ERR("zbus_chan_read, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
+		}
+
+		s_obj.payload = payload;
 
-		s_obj.chan = chan;
+#if defined(CONFIG_MQTT_SAMPLE_MSG_TRACE)
+		msg_trace_mark(payload.trace_id, MSG_TRACE_DEQUEUED);
+#endif /* CONFIG_MQTT_SAMPLE_MSG_TRACE */
 
-		if (&NETWORK_CHAN == chan) {
+		err = smf_run_state(SMF_CTX(&s_obj));
+		if (err) {
+			LOG_ERR("smf_run_state, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
+		}
+	}
+
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM)
+	if (&STREAM_CHAN == chan) {
 
-			err = zbus_chan_read(&NETWORK_CHAN, &status, K_SECONDS(1));
-			if (err) {
-				LOG_ERR("zbus_chan_read, error: %d", err);
-				SEND_FATAL_ERROR();
-				return;
-			}
+		err = smf_run_state(SMF_CTX(&s_obj));
+		if (err) {
+			LOG_ERR("smf_run_state, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
+		}
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_STREAM */
 
-			s_obj.status = status;
+#if defined(CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING)
+	if (&LINK_QUALITY_CHAN == chan) {
+		struct link_quality quality;
 
-			err = smf_run_state(SMF_CTX(&s_obj));
-			if (err) {
-				LOG_ERR("smf_run_state, error: %d", err);
-				SEND_FATAL_ERROR();
-				return;
-			}
+		err = zbus_chan_read(&LINK_QUALITY_CHAN, &quality, K_SECONDS(1));
+		if (err) {
+			LOG_ERR("zbus_chan_read, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
 		}
 
-		if (&PAYLOAD_CHAN == chan) {
+		atomic_set(&link_level, quality.level);
 
-			err = zbus_chan_read(&PAYLOAD_CHAN, &payload, K_SECONDS(1));
-			if (err) {
-				LOG_ERR("zbus_chan_read, error: %d", err);
-				SEND_FATAL_ERROR();
-				return;
-			}
+		err = smf_run_state(SMF_CTX(&s_obj));
+		if (err) {
+			LOG_ERR("smf_run_state, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
+		}
+	}
+#endif /* CONFIG_MQTT_SAMPLE_TRANSPORT_LINK_GATING */
+
+#if defined(CONFIG_MQTT_SAMPLE_TELEMETRY)
+	if (&TELEMETRY_CHAN == chan) {
+
+		err = zbus_chan_read(&TELEMETRY_CHAN, &s_obj.telemetry, K_SECONDS(1));
 
-			s_obj.payload = payload;
+		/* The next line can be published once this one is copied out */
+		telemetry_consumed();
+
+		if (err) {
+			LOG_ERR("zbus_chan_read, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
+		}
 
-			err = smf_run_state(SMF_CTX(&s_obj));
-			if (err) {
-				LOG_ERR("smf_run_state, error: %d", err);
-				SEND_FATAL_ERROR();
-				return;
-			}
+		err = smf_run_state(SMF_CTX(&s_obj));
+		if (err) {
+			LOG_ERR("smf_run_state, error: %d", err);
+			TRANSPORT_FAULT(err);
+			return;
 		}
 	}
+#endif /* CONFIG_MQTT_SAMPLE_TELEMETRY */
 }
 
-K_THREAD_DEFINE(transport_task_id,
-		CONFIG_MQTT_SAMPLE_TRANSPORT_THREAD_STACK_SIZE,
-		transport_task, NULL, NULL, NULL, 3, 0, 0);
+/* Register subscriber, or listener if the module runs on the executor */
+EXECUTOR_MODULE_DEFINE(transport,
+		       CONFIG_MQTT_SAMPLE_TRANSPORT_MESSAGE_QUEUE_SIZE,
+		       transport_init, transport_handler,
+		       CONFIG_MQTT_SAMPLE_TRANSPORT_THREAD_STACK_SIZE, 3,
+		       CONFIG_MQTT_SAMPLE_TRANSPORT_EXECUTOR_QUEUE);
@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "ts_codec.h"
+
+/* Marker for "no previous XOR window", used before the first non-zero XOR of a block. */
+#define NO_WINDOW 0xFF
+
+/* Leading zeros are stored in 5 bits. */
+#define LEADING_MAX 31
+
+/* Number of bits in each varint group, the remaining bit is the continuation flag. */
+#define VARINT_GROUP_BITS 7
+
+/* Bit stream helpers */
+
+static size_t stream_bits(size_t size)
+{
+	return (size - TS_CODEC_HEADER_SIZE) * 8;
+}
+
+static int put_bits(struct ts_codec_enc *enc, uint64_t value, uint8_t bits)
+{
+	uint8_t *stream = enc->buf + TS_CODEC_HEADER_SIZE;
+
+	if ((enc->bit_pos + bits) > stream_bits(enc->size)) {
+		return -ENOMEM;
+	}
+
+	while (bits--) {
+		size_t byte = enc->bit_pos / 8;
+		uint8_t mask = 0x80 >> (enc->bit_pos % 8);
+
+		if (value & (1ULL << bits)) {
+			stream[byte] |= mask;
+		} else {
+			stream[byte] &= ~mask;
+		}
+
+		enc->bit_pos++;
+	}
+
+	return 0;
+}
+
+static int get_bits(struct ts_codec_dec *dec, uint8_t bits, uint64_t *value)
+{
+	const uint8_t *stream = dec->buf + TS_CODEC_HEADER_SIZE;
+
+	if ((dec->bit_pos + bits) > stream_bits(dec->len)) {
+		return -EBADMSG;
+	}
+
+	*value = 0;
+
+	while (bits--) {
+		size_t byte = dec->bit_pos / 8;
+		uint8_t mask = 0x80 >> (dec->bit_pos % 8);
+
+		*value = (*value << 1) | ((stream[byte] & mask) ? 1 : 0);
+		dec->bit_pos++;
+	}
+
+	return 0;
+}
+
+static int64_t sign_extend(uint64_t value, uint8_t bits)
+{
+	uint64_t sign = 1ULL << (bits - 1);
+
+	return (int64_t)((value ^ sign) - sign);
+}
+
+static uint64_t zigzag_encode(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static int put_varint(struct ts_codec_enc *enc, uint64_t value)
+{
+	int err;
+
+	do {
+		uint8_t group = value & 0x7F;
+
+		value >>= VARINT_GROUP_BITS;
+		if (value) {
+			group |= 0x80;
+		}
+
+		err = put_bits(enc, group, 8);
+		if (err) {
+			return err;
+		}
+	} while (value);
+
+	return 0;
+}
+
+static int get_varint(struct ts_codec_dec *dec, uint64_t *value)
+{
+	uint64_t group;
+	uint8_t shift = 0;
+	int err;
+
+	*value = 0;
+
+	do {
+		if (shift >= 64) {
+			return -EBADMSG;
+		}
+
+		err = get_bits(dec, 8, &group);
+		if (err) {
+			return err;
+		}
+
+		*value |= (group & 0x7F) << shift;
+		shift += VARINT_GROUP_BITS;
+	} while (group & 0x80);
+
+	return 0;
+}
+
+/* Timestamp encoding */
+
+static int put_timestamp(struct ts_codec_enc *enc, uint64_t timestamp)
+{
+	int64_t delta, dod;
+	int err;
+
+	if (enc->count == 0) {
+		return put_varint(enc, timestamp);
+	}
+
+	if (timestamp < enc->prev_ts) {
+		return -EINVAL;
+	}
+
+	/* In unsigned arithmetic, which wraps instead of overflowing for large deltas */
+	delta = (int64_t)(timestamp - enc->prev_ts);
+	dod = (int64_t)((uint64_t)delta - (uint64_t)enc->prev_delta);
+
+	if (dod == 0) {
+		err = put_bits(enc, 0x0, 1);
+	} else if ((dod >= -64) && (dod <= 63)) {
+		err = put_bits(enc, 0x2, 2) ?: put_bits(enc, (uint64_t)dod & 0x7F, 7);
+	} else if ((dod >= -256) && (dod <= 255)) {
+		err = put_bits(enc, 0x6, 3) ?: put_bits(enc, (uint64_t)dod & 0x1FF, 9);
+	} else if ((dod >= -2048) && (dod <= 2047)) {
+		err = put_bits(enc, 0xE, 4) ?: put_bits(enc, (uint64_t)dod & 0xFFF, 12);
+	} else {
+		err = put_bits(enc, 0xF, 4) ?: put_varint(enc, zigzag_encode(dod));
+	}
+
+	if (err) {
+		return err;
+	}
+
+	enc->prev_delta = delta;
+
+	return 0;
+}
+
+static int get_timestamp(struct ts_codec_dec *dec, uint64_t *timestamp)
+{
+	uint64_t bits;
+	int64_t dod;
+	int err;
+
+	if (dec->index == 0) {
+		return get_varint(dec, timestamp);
+	}
+
+	/* Count the number of leading ones in the control prefix, at most four. */
+	uint8_t ones = 0;
+
+	do {
+		err = get_bits(dec, 1, &bits);
+		if (err) {
+			return err;
+		}
+
+		ones += bits;
+	} while (bits && (ones < 4));
+
+	switch (ones) {
+	case 0:
+		dod = 0;
+		break;
+	case 1:
+		err = get_bits(dec, 7, &bits);
+		dod = sign_extend(bits, 7);
+		break;
+	case 2:
+		err = get_bits(dec, 9, &bits);
+		dod = sign_extend(bits, 9);
+		break;
+	case 3:
+		err = get_bits(dec, 12, &bits);
+		dod = sign_extend(bits, 12);
+		break;
+	default:
+		err = get_varint(dec, &bits);
+		dod = zigzag_decode(bits);
+		break;
+	}
+
+	if (err) {
+		return err;
+	}
+
+	dec->prev_delta = (int64_t)((uint64_t)dec->prev_delta + (uint64_t)dod);
+	*timestamp = dec->prev_ts + (uint64_t)dec->prev_delta;
+
+	return 0;
+}
+
+/* Value encoding */
+
+static int put_double(struct ts_codec_enc *enc, uint64_t value)
+{
+	uint64_t xor = value ^ enc->prev_value;
+	uint8_t leading, trailing, meaningful;
+	int err;
+
+	if (enc->count == 0) {
+		return put_bits(enc, value, 64);
+	}
+
+	if (xor == 0) {
+		return put_bits(enc, 0x0, 1);
+	}
+
+	leading = __builtin_clzll(xor);
+	trailing = __builtin_ctzll(xor);
+
+	if (leading > LEADING_MAX) {
+		leading = LEADING_MAX;
+	}
+
+	/* Reuse the previous window if the meaningful bits fit inside it. */
+	if ((enc->prev_leading != NO_WINDOW) &&
+	    (leading >= enc->prev_leading) && (trailing >= enc->prev_trailing)) {
+		meaningful = 64 - enc->prev_leading - enc->prev_trailing;
+
+		return put_bits(enc, 0x2, 2) ?:
+		       put_bits(enc, xor >> enc->prev_trailing, meaningful);
+	}
+
+	meaningful = 64 - leading - trailing;
+
+	err = put_bits(enc, 0x3, 2) ?:
+	      put_bits(enc, leading, 5) ?:
+	      put_bits(enc, meaningful - 1, 6) ?:
+	      put_bits(enc, xor >> trailing, meaningful);
+	if (err) {
+		return err;
+	}
+
+	enc->prev_leading = leading;
+	enc->prev_trailing = trailing;
+
+	return 0;
+}
+
+static int get_double(struct ts_codec_dec *dec, uint64_t *value)
+{
+	uint64_t bits, xor;
+	uint8_t meaningful;
+	int err;
+
+	if (dec->index == 0) {
+		return get_bits(dec, 64, value);
+	}
+
+	err = get_bits(dec, 1, &bits);
+	if (err) {
+		return err;
+	}
+
+	if (bits == 0) {
+		*value = dec->prev_value;
+		return 0;
+	}
+
+	err = get_bits(dec, 1, &bits);
+	if (err) {
+		return err;
+	}
+
+	if (bits) {
+		uint64_t leading, length;
+
+		err = get_bits(dec, 5, &leading) ?: get_bits(dec, 6, &length);
+		if (err) {
+			return err;
+		}
+
+		meaningful = length + 1;
+
+		if ((leading + meaningful) > 64) {
+			return -EBADMSG;
+		}
+
+		dec->prev_leading = leading;
+		dec->prev_trailing = 64 - leading - meaningful;
+	} else if (dec->prev_leading == NO_WINDOW) {
+		return -EBADMSG;
+	}
+
+	meaningful = 64 - dec->prev_leading - dec->prev_trailing;
+
+	err = get_bits(dec, meaningful, &xor);
+	if (err) {
+		return err;
+	}
+
+	*value = dec->prev_value ^ (xor << dec->prev_trailing);
+
+	return 0;
+}
+
+static int put_int(struct ts_codec_enc *enc, uint64_t value)
+{
+	return put_varint(enc, zigzag_encode((int64_t)(value - enc->prev_value)));
+}
+
+static int get_int(struct ts_codec_dec *dec, uint64_t *value)
+{
+	uint64_t bits;
+	int err;
+
+	err = get_varint(dec, &bits);
+	if (err) {
+		return err;
+	}
+
+	*value = dec->prev_value + (uint64_t)zigzag_decode(bits);
+
+	return 0;
+}
+
+/* Public API */
+
+int ts_codec_enc_init(struct ts_codec_enc *enc, enum ts_codec_value_type type,
+		      uint8_t *buf, size_t size)
+{
+	if ((enc == NULL) || (buf == NULL) || (size <= TS_CODEC_HEADER_SIZE)) {
+		return -EINVAL;
+	}
+
+	if ((type != TS_CODEC_VALUE_DOUBLE) && (type != TS_CODEC_VALUE_INT)) {
+		return -EINVAL;
+	}
+
+	memset(enc, 0, sizeof(*enc));
+
+	enc->buf = buf;
+	enc->size = size;
+	enc->type = type;
+	enc->prev_leading = NO_WINDOW;
+
+	return 0;
+}
+
+static int enc_add(struct ts_codec_enc *enc, enum ts_codec_value_type type,
+		   uint64_t timestamp, uint64_t value)
+{
+	struct ts_codec_enc snapshot = *enc;
+	int err;
+
+	if (enc->type != type) {
+		return -EINVAL;
+	}
+
+	if (enc->count == UINT16_MAX) {
+		return -ENOMEM;
+	}
+
+	err = put_timestamp(enc, timestamp);
+	if (!err) {
+		err = (type == TS_CODEC_VALUE_DOUBLE) ? put_double(enc, value) :
+							put_int(enc, value);
+	}
+
+	if (err) {
+		/* Leave the block as it was so that it can still be finished and sent. */
+		*enc = snapshot;
+		return err;
+	}
+
+	enc->prev_ts = timestamp;
+	enc->prev_value = value;
+	enc->count++;
+
+	return 0;
+}
+
+int ts_codec_enc_add_double(struct ts_codec_enc *enc, uint64_t timestamp, double value)
+{
+	uint64_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	return enc_add(enc, TS_CODEC_VALUE_DOUBLE, timestamp, bits);
+}
+
+int ts_codec_enc_add_int(struct ts_codec_enc *enc, uint64_t timestamp, int64_t value)
+{
+	return enc_add(enc, TS_CODEC_VALUE_INT, timestamp, (uint64_t)value);
+}
+
+size_t ts_codec_enc_finish(struct ts_codec_enc *enc)
+{
+	enc->buf[0] = (TS_CODEC_VERSION << 4) | (enc->type & 0x0F);
+	enc->buf[1] = enc->count & 0xFF;
+	enc->buf[2] = enc->count >> 8;
+
+	return TS_CODEC_HEADER_SIZE + ((enc->bit_pos + 7) / 8);
+}
+
+int ts_codec_dec_init(struct ts_codec_dec *dec, const uint8_t *buf, size_t len)
+{
+	if ((dec == NULL) || (buf == NULL) || (len < TS_CODEC_HEADER_SIZE)) {
+		return -EINVAL;
+	}
+
+	if ((buf[0] >> 4) != TS_CODEC_VERSION) {
+		return -ENOTSUP;
+	}
+
+	memset(dec, 0, sizeof(*dec));
+
+	dec->buf = buf;
+	dec->len = len;
+	dec->type = buf[0] & 0x0F;
+	dec->count = buf[1] | (buf[2] << 8);
+	dec->prev_leading = NO_WINDOW;
+
+	if ((dec->type != TS_CODEC_VALUE_DOUBLE) && (dec->type != TS_CODEC_VALUE_INT)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int dec_next(struct ts_codec_dec *dec, enum ts_codec_value_type type,
+		    uint64_t *timestamp, uint64_t *value)
+{
+	int err;
+
+	if (dec->type != type) {
+		return -EINVAL;
+	}
+
+	if (dec->index >= dec->count) {
+		return -ENODATA;
+	}
+
+	err = get_timestamp(dec, timestamp);
+	if (!err) {
+		err = (type == TS_CODEC_VALUE_DOUBLE) ? get_double(dec, value) :
+							get_int(dec, value);
+	}
+
+	if (err) {
+		return err;
+	}
+
+	dec->prev_ts = *timestamp;
+	dec->prev_value = *value;
+	dec->index++;
+
+	return 0;
+}
+
+int ts_codec_dec_next_double(struct ts_codec_dec *dec, uint64_t *timestamp, double *value)
+{
+	uint64_t bits;
+	int err;
+
+	err = dec_next(dec, TS_CODEC_VALUE_DOUBLE, timestamp, &bits);
+	if (err) {
+		return err;
+	}
+
+	memcpy(value, &bits, sizeof(bits));
+
+	return 0;
+}
+
+int ts_codec_dec_next_int(struct ts_codec_dec *dec, uint64_t *timestamp, int64_t *value)
+{
+	uint64_t bits;
+	int err;
+
+	err = dec_next(dec, TS_CODEC_VALUE_INT, timestamp, &bits);
+	if (err) {
+		return err;
+	}
+
+	*value = (int64_t)bits;
+
+	return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _TS_CODEC_H_
+#define _TS_CODEC_H_
+
+/* Gorilla style time-series codec used to compress blocks of batched samples.
+ *
+ * Timestamps are encoded as delta-of-deltas, floating point values are XOR encoded against
+ * the previous value, and integer values are encoded as zigzag varints of their delta.
+ *
+ * The codec has no dependencies on Zephyr so that the decoder can be built and used in
+ * host side tools and tests.
+ *
+ * Block layout:
+ *   byte 0	Version (upper nibble) and value type (lower nibble)
+ *   byte 1-2	Number of samples in the block, little endian
+ *   byte 3-	Bit stream, MSB first
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Version of the block format written by the encoder. */
+#define TS_CODEC_VERSION 1
+
+/** @brief Size of the block header. */
+#define TS_CODEC_HEADER_SIZE 3
+
+enum ts_codec_value_type {
+	/** Values are IEEE 754 doubles, XOR encoded. */
+	TS_CODEC_VALUE_DOUBLE,
+	/** Values are signed integers, delta and zigzag varint encoded. */
+	TS_CODEC_VALUE_INT,
+};
+
+/** @brief Encoder state, must be initialized with ts_codec_enc_init(). */
+struct ts_codec_enc {
+	uint8_t *buf;
+	size_t size;
+	size_t bit_pos;
+	enum ts_codec_value_type type;
+	uint16_t count;
+	uint64_t prev_ts;
+	int64_t prev_delta;
+	uint64_t prev_value;
+	uint8_t prev_leading;
+	uint8_t prev_trailing;
+};
+
+/** @brief Decoder state, must be initialized with ts_codec_dec_init(). */
+struct ts_codec_dec {
+	const uint8_t *buf;
+	size_t len;
+	size_t bit_pos;
+	enum ts_codec_value_type type;
+	uint16_t count;
+	uint16_t index;
+	uint64_t prev_ts;
+	int64_t prev_delta;
+	uint64_t prev_value;
+	uint8_t prev_leading;
+	uint8_t prev_trailing;
+};
+
+/** @brief Initialize an encoder for a new block.
+ *
+ *  @param enc Pointer to encoder state.
+ *  @param type Type of the values that will be added to the block.
+ *  @param buf Buffer that the block is written to.
+ *  @param size Size of buffer.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -EINVAL If a pointer is NULL, the type is unknown or the buffer is too small.
+ */
+int ts_codec_enc_init(struct ts_codec_enc *enc, enum ts_codec_value_type type,
+		      uint8_t *buf, size_t size);
+
+/** @brief Add a floating point sample to a block of type TS_CODEC_VALUE_DOUBLE.
+ *
+ *  If the sample does not fit, the encoder is left unchanged so that the block can be
+ *  finished and sent before the sample is added to a new block.
+ *
+ *  @param enc Pointer to encoder state.
+ *  @param timestamp Sample timestamp. Timestamps must be non-decreasing within a block.
+ *  @param value Sample value.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -ENOMEM If the sample does not fit in the remaining buffer.
+ *  @retval -EINVAL If the block type or timestamp order is wrong.
+ */
+int ts_codec_enc_add_double(struct ts_codec_enc *enc, uint64_t timestamp, double value);
+
+/** @brief Add an integer sample to a block of type TS_CODEC_VALUE_INT.
+ *
+ *  Same semantics as ts_codec_enc_add_double().
+ */
+int ts_codec_enc_add_int(struct ts_codec_enc *enc, uint64_t timestamp, int64_t value);
+
+/** @brief Get the number of samples added to the block. */
+static inline uint16_t ts_codec_enc_count(const struct ts_codec_enc *enc)
+{
+	return enc->count;
+}
+
+/** @brief Finish the block by writing the header.
+ *
+ *  @param enc Pointer to encoder state.
+ *
+ *  @return Length of the encoded block in bytes.
+ */
+size_t ts_codec_enc_finish(struct ts_codec_enc *enc);
+
+/** @brief Initialize a decoder for an encoded block.
+ *
+ *  @param dec Pointer to decoder state.
+ *  @param buf Encoded block.
+ *  @param len Length of the encoded block.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -EINVAL If the block header is malformed.
+ *  @retval -ENOTSUP If the block version is not supported.
+ */
+int ts_codec_dec_init(struct ts_codec_dec *dec, const uint8_t *buf, size_t len);
+
+/** @brief Decode the next floating point sample from a block of type TS_CODEC_VALUE_DOUBLE.
+ *
+ *  @return 0 If successful. Otherwise, a negative error code is returned.
+ *  @retval -ENODATA If all samples in the block have been decoded.
+ *  @retval -EBADMSG If the block is truncated or corrupt.
+ *  @retval -EINVAL If the block type is wrong.
+ */
+int ts_codec_dec_next_double(struct ts_codec_dec *dec, uint64_t *timestamp, double *value);
+
+/** @brief Decode the next integer sample from a block of type TS_CODEC_VALUE_INT.
+ *
+ *  Same semantics as ts_codec_dec_next_double().
+ */
+int ts_codec_dec_next_int(struct ts_codec_dec *dec, uint64_t *timestamp, int64_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TS_CODEC_H_ */
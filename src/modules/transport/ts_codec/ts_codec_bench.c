@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Benchmark that compares time-series encoded sample blocks against the plain strings that
+ * the sampler module sends over the payload channel. Runs once at boot and logs the result.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "bench_clock.h"
+#include "ts_codec.h"
+
+LOG_MODULE_REGISTER(ts_codec_bench, CONFIG_MQTT_SAMPLE_TRANSPORT_LOG_LEVEL);
+
+/* Same format as the sampler module uses for the payload string. */
+#define FORMAT_STRING "Hello MQTT! Current uptime is: %d"
+
+#define BENCH_THREAD_STACK_SIZE 2048
+
+/* Deterministic pseudo random generator, so that the data can be regenerated for verification
+ * without storing it.
+ */
+struct generator {
+	uint32_t state;
+	uint64_t timestamp;
+	double temperature;
+};
+
+static uint32_t generator_rand(struct generator *gen)
+{
+	gen->state = (gen->state * 1103515245U) + 12345U;
+
+	return gen->state >> 16;
+}
+
+static void generator_init(struct generator *gen)
+{
+	gen->state = 1;
+	gen->timestamp = 0;
+	gen->temperature = 21.5;
+}
+
+/* Produce the next sample. Timestamps follow the trigger interval with a few milliseconds of
+ * jitter, the value is a slowly drifting temperature with 0.25 degree resolution.
+ */
+static void generator_next(struct generator *gen, uint64_t *timestamp, double *value)
+{
+	gen->timestamp += (CONFIG_MQTT_SAMPLE_TRIGGER_TIMEOUT_SECONDS * MSEC_PER_SEC) +
+			  ((int)(generator_rand(gen) % 5) - 2);
+	gen->temperature += ((int)(generator_rand(gen) % 3) - 1) * 0.25;
+
+	*timestamp = gen->timestamp;
+	*value = gen->temperature;
+}
+
+struct bench_result {
+	size_t plain_bytes;
+	size_t encoded_bytes;
+	uint64_t encode_ns;
+	bool verified;
+};
+
+static int block_verify(const uint8_t *buf, size_t len, enum ts_codec_value_type type,
+			struct generator *gen)
+{
+	struct ts_codec_dec dec;
+	uint64_t timestamp, expected_timestamp;
+	double value, expected_value;
+	int64_t int_value;
+	int err;
+
+	err = ts_codec_dec_init(&dec, buf, len);
+	if (err) {
+		return err;
+	}
+
+	for (size_t i = 0; i < dec.count; i++) {
+		generator_next(gen, &expected_timestamp, &expected_value);
+
+		if (type == TS_CODEC_VALUE_INT) {
+			err = ts_codec_dec_next_int(&dec, &timestamp, &int_value);
+			value = int_value;
+			expected_value = expected_timestamp;
+		} else {
+			err = ts_codec_dec_next_double(&dec, &timestamp, &value);
+		}
+
+		if (err) {
+			return err;
+		}
+
+		if ((timestamp != expected_timestamp) || (value != expected_value)) {
+			return -EBADMSG;
+		}
+	}
+
+	return 0;
+}
+
+static void bench_run(enum ts_codec_value_type type, struct bench_result *result)
+{
+	static uint8_t buf[CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BUFFER_SIZE];
+	char plain[CONFIG_MQTT_SAMPLE_PAYLOAD_CHANNEL_STRING_MAX_SIZE];
+	struct generator gen, verify_gen;
+	struct ts_codec_enc enc;
+	uint64_t timestamp, start;
+	double value;
+	size_t remaining = CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BENCHMARK_SAMPLES;
+	int err;
+
+	memset(result, 0, sizeof(*result));
+	result->verified = true;
+
+	generator_init(&gen);
+	generator_init(&verify_gen);
+
+	while (remaining) {
+		(void)ts_codec_enc_init(&enc, type, buf, sizeof(buf));
+
+		while (remaining &&
+		       (ts_codec_enc_count(&enc) < CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BATCH_SIZE)) {
+			struct generator saved = gen;
+
+			generator_next(&gen, &timestamp, &value);
+
+			/* The integer stream mirrors the sampler, which sends its uptime. */
+			start = bench_clock_ns();
+			err = (type == TS_CODEC_VALUE_INT) ?
+			      ts_codec_enc_add_int(&enc, timestamp, timestamp) :
+			      ts_codec_enc_add_double(&enc, timestamp, value);
+			result->encode_ns += bench_clock_ns() - start;
+
+			if (err == -ENOMEM) {
+				/* Block full, regenerate this sample into the next block. */
+				gen = saved;
+				break;
+			}
+
+			result->plain_bytes += snprintk(plain, sizeof(plain), FORMAT_STRING,
+							(int)timestamp);
+			remaining--;
+		}
+
+		start = bench_clock_ns();
+		size_t len = ts_codec_enc_finish(&enc);
+
+		result->encode_ns += bench_clock_ns() - start;
+		result->encoded_bytes += len;
+
+		if (block_verify(buf, len, type, &verify_gen)) {
+			result->verified = false;
+		}
+	}
+}
+
+static void bench_report(const char *name, const struct bench_result *result)
+{
+	uint32_t samples = CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BENCHMARK_SAMPLES;
+	uint32_t ratio = (result->plain_bytes * 100) / MAX(result->encoded_bytes, 1);
+
+	LOG_INF("%s: %u samples, plain: %zu B, encoded: %zu B, ratio: %u.%02u, "
+		"encode: %u ns/sample, decode check: %s",
+		name, samples, result->plain_bytes, result->encoded_bytes,
+		ratio / 100, ratio % 100, (uint32_t)(result->encode_ns / samples),
+		result->verified ? "passed" : "FAILED");
+}
+
+static void ts_codec_bench_task(void)
+{
+	struct bench_result result;
+
+	LOG_INF("Time-series codec benchmark, batch size: %d, buffer size: %d",
+		CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BATCH_SIZE,
+		CONFIG_MQTT_SAMPLE_TRANSPORT_TS_CODEC_BUFFER_SIZE);
+
+	bench_run(TS_CODEC_VALUE_INT, &result);
+	bench_report("int (uptime)", &result);
+
+	bench_run(TS_CODEC_VALUE_DOUBLE, &result);
+	bench_report("double (temperature)", &result);
+}
+
+K_THREAD_DEFINE(ts_codec_bench_task_id,
+		BENCH_THREAD_STACK_SIZE,
+		ts_codec_bench_task, NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
@@ -12,19 +12,24 @@
 #endif /* CONFIG_DK_LIBRARY */
 
 #include "message_channel.h"
+#include "executor.h"
+#include "msg_trace.h"
 
 /* Register log module */
 LOG_MODULE_REGISTER(trigger, CONFIG_MQTT_SAMPLE_TRIGGER_LOG_LEVEL);
 
 static void message_send(void)
 {
-	int not_used = -1;
+	/* The trigger message carries the ID of the message's latency trace, if tracing is
+	 * enabled. It is otherwise not used.
+	 */
+	int trace_id = IS_ENABLED(CONFIG_MQTT_SAMPLE_MSG_TRACE) ? msg_trace_start() : -1;
 	int err;
 
-	err = zbus_chan_pub(&TRIGGER_CHAN, &not_used, K_SECONDS(1));
+	err = zbus_chan_pub(&TRIGGER_CHAN, &trace_id, K_SECONDS(1));
 	if (err) {
 		LOG_ERR("zbus_chan_pub, error: %d", err);
-		SEND_FATAL_ERROR();
+		SEND_FATAL_ERROR_CODE(err);
 	}
 }
 
@@ -37,18 +42,60 @@ static void button_handler(uint32_t button_states, uint32_t has_changed)
 }
 #endif /* CONFIG_DK_LIBRARY */
 
-static void trigger_task(void)
+static int buttons_init(void)
 {
 #if CONFIG_DK_LIBRARY
 	int err = dk_buttons_init(button_handler);
 
 	if (err) {
 		LOG_ERR("dk_buttons_init, error: %d", err);
-		SEND_FATAL_ERROR();
-		return;
+		SEND_FATAL_ERROR_CODE(err);
+		return err;
 	}
 #endif /* CONFIG_DK_LIBRARY */
 
+	return 0;
+}
+
+#if defined(CONFIG_MQTT_SAMPLE_EXECUTOR)
+static void trigger_work_fn(struct k_work *work);
+
+/* Define trigger work - Used to send triggers periodically on the executor */
+static K_WORK_DELAYABLE_DEFINE(trigger_work, trigger_work_fn);
+
+static void trigger_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	message_send();
+
+	k_work_reschedule_for_queue(executor_queue_get(CONFIG_MQTT_SAMPLE_TRIGGER_EXECUTOR_QUEUE),
+				    &trigger_work,
+				    K_SECONDS(CONFIG_MQTT_SAMPLE_TRIGGER_TIMEOUT_SECONDS));
+}
+
+static int trigger_init(void)
+{
+	int err = buttons_init();
+
+	if (err) {
+		return err;
+	}
+
+	k_work_reschedule_for_queue(executor_queue_get(CONFIG_MQTT_SAMPLE_TRIGGER_EXECUTOR_QUEUE),
+				    &trigger_work, K_NO_WAIT);
+
+	return 0;
+}
+
+SYS_INIT(trigger_init, APPLICATION, EXECUTOR_MODULE_INIT_PRIORITY);
+#else
+static void trigger_task(void)
+{
+	if (buttons_init()) {
+		return;
+	}
+
 	while (true) {
 		message_send();
 		k_sleep(K_SECONDS(CONFIG_MQTT_SAMPLE_TRIGGER_TIMEOUT_SECONDS));
@@ -58,3 +105,4 @@ static void trigger_task(void)
 K_THREAD_DEFINE(trigger_task_id,
 		CONFIG_MQTT_SAMPLE_TRIGGER_THREAD_STACK_SIZE,
 		trigger_task, NULL, NULL, NULL, 3, 0, 0);
+#endif /* CONFIG_MQTT_SAMPLE_EXECUTOR */
@@ -11,8 +11,13 @@
 #include <zephyr/zbus/zbus.h>
 
 #include "message_channel.h"
+#include "executor.h"
+#include "msg_trace.h"
+
+#if defined(CONFIG_SOFTAP_WIFI_PROVISION_MODULE)
+#include "wifi_provision.h"
+#endif /* CONFIG_SOFTAP_WIFI_PROVISION_MODULE */
 #include <net/softap_wifi_provision.h>
-#include <zephyr/net/wifi_credentials.h>
 
 LOG_MODULE_REGISTER(ui, LOG_LEVEL_INF);
 
@@ -42,9 +47,14 @@ static const struct gpio_dt_spec button2 = GPIO_DT_SPEC_GET(BUTTON_2_NODE, gpios
 static struct gpio_callback button2_cb_data;
 #endif
 
-/* Work queue for safe button handling */
-static struct k_work_q ui_work_q;
-static K_THREAD_STACK_DEFINE(ui_work_stack, 2048);
+/* Work queue for safe button handling. When running on the executor, the executor queue is
+ * used instead of a private work queue.
+ */
+#if !defined(CONFIG_MQTT_SAMPLE_EXECUTOR)
+static struct k_work_q ui_work_q_data;
+static K_THREAD_STACK_DEFINE(ui_work_stack, CONFIG_MQTT_SAMPLE_UI_WORKQUEUE_STACK_SIZE);
+#endif /* !CONFIG_MQTT_SAMPLE_EXECUTOR */
+static struct k_work_q *ui_work_q;
 
 /* Work items for button handling */
 #if DT_NODE_HAS_STATUS(BUTTON_1_NODE, okay)
@@ -164,9 +174,25 @@ static void button1_work_fn(struct k_work *work)
 	}
 
 	/* Create and publish button press message */
-	struct payload button_payload;
+	struct payload button_payload = { 0 };
+	int64_t uptime = k_uptime_get();
+	uint16_t trace_id = msg_trace_start();
+
 	snprintk(button_payload.string, sizeof(button_payload.string), 
-		 "Button 1 pressed at %lld", k_uptime_get());
+		 "Button 1 pressed at %lld", uptime);
+
+#if defined(CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE)
+	/* Report the button number as the sampled value, outside of the sampled time series */
+	button_payload.series = PAYLOAD_SERIES_NONE;
+	button_payload.timestamp = uptime;
+	button_payload.value = 1;
+#endif /* CONFIG_MQTT_SAMPLE_PAYLOAD_SAMPLE */
+
+#if defined(CONFIG_MQTT_SAMPLE_MSG_TRACE)
+	button_payload.trace_id = trace_id;
+#endif /* CONFIG_MQTT_SAMPLE_MSG_TRACE */
+
+	msg_trace_mark(trace_id, MSG_TRACE_SAMPLED);
 
 	LOG_INF("Button 1 pressed - publishing MQTT message");
 	
@@ -174,13 +200,16 @@ static void button1_work_fn(struct k_work *work)
 	int ret = zbus_chan_pub(&PAYLOAD_CHAN, &button_payload, K_SECONDS(1));
 	if (ret) {
 		LOG_ERR("Failed to publish button payload: %d", ret);
+		return;
 	}
+
+	msg_trace_mark(trace_id, MSG_TRACE_PUBLISHED);
 }
 
 static void button1_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
 {
 	/* Schedule work to handle button press safely */
-	k_work_submit_to_queue(&ui_work_q, &button1_work);
+	k_work_submit_to_queue(ui_work_q, &button1_work);
 }
 #endif
 
@@ -188,33 +217,19 @@ static void button1_pressed(const struct device *dev, struct gpio_callback *cb,
 static void button2_work_fn(struct k_work *work)
 {
 	LOG_INF("Button 2 pressed - resetting WiFi credentials and restarting provisioning");
-	
-	/* Check if credentials exist before reset */
-	bool credentials_before = !wifi_credentials_is_empty();
-	LOG_INF("WiFi credentials exist before reset: %s", credentials_before ? "YES" : "NO");
-	
-	/* Reset WiFi credentials directly - this is more reliable than using the async API */
-	int ret = wifi_credentials_delete_all();
+
+	/* Provisioning is initialized on the next boot, which finds no credentials */
+	int ret = wifi_provision_reset();
 	if (ret) {
-		LOG_ERR("Failed to delete WiFi credentials directly: %d", ret);
+		LOG_ERR("wifi_provision_reset, error: %d", ret);
 		return;
 	}
-	
-	LOG_INF("WiFi credentials deleted directly");
-	
-	/* Check if credentials exist after reset */
-	bool credentials_after = !wifi_credentials_is_empty();
-	LOG_INF("WiFi credentials exist after reset: %s", credentials_after ? "YES" : "NO");
-	
-	LOG_INF("WiFi credentials reset, rebooting for reprovisioning...");
-	/* Reboot to restart provisioning */
-	sys_reboot(SYS_REBOOT_COLD);
 }
 
 static void button2_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
 {
 	/* Schedule work to handle button press safely */
-	k_work_submit_to_queue(&ui_work_q, &button2_work);
+	k_work_submit_to_queue(ui_work_q, &button2_work);
 }
 #endif
 
@@ -369,27 +384,29 @@ static void transport_status_handler(const struct zbus_channel *chan)
 	}
 }
 
-/* ZBus subscribers */
-ZBUS_SUBSCRIBER_DEFINE(ui, 4);
-
-static void ui_task(void)
+static int ui_init(void)
 {
 	int ret;
-	const struct zbus_channel *chan;
 
 	LOG_INF("UI module started");
 
+#if defined(CONFIG_MQTT_SAMPLE_EXECUTOR)
+	ui_work_q = executor_queue_get(CONFIG_MQTT_SAMPLE_UI_EXECUTOR_QUEUE);
+#else
 	/* Initialize work queue */
-	k_work_queue_init(&ui_work_q);
-	k_work_queue_start(&ui_work_q, ui_work_stack,
+	ui_work_q = &ui_work_q_data;
+
+	k_work_queue_init(ui_work_q);
+	k_work_queue_start(ui_work_q, ui_work_stack,
 			   K_THREAD_STACK_SIZEOF(ui_work_stack),
 			   K_HIGHEST_APPLICATION_THREAD_PRIO, NULL);
+#endif /* CONFIG_MQTT_SAMPLE_EXECUTOR */
 
 	/* Initialize GPIOs */
 	ret = leds_init();
 	if (ret) {
 		LOG_ERR("Failed to initialize LEDs: %d", ret);
-		return;
+		return ret;
 	}
 
 	ret = buttons_init();
@@ -401,18 +418,24 @@ static void ui_task(void)
 	/* Set initial LED states */
 	update_led_states();
 
-	/* Main event loop - wait for messages on the UI subscriber */
-	while (!zbus_sub_wait(&ui, &chan, K_FOREVER)) {
-		
-		if (chan == &NETWORK_CHAN) {
-			network_status_handler(chan);
-		} else if (chan == &PROVISIONING_CHAN) {
-			provisioning_status_handler(chan);
-		} else if (chan == &TRANSPORT_CHAN) {
-			transport_status_handler(chan);
-		}
+	return 0;
+}
+
+/* Handle messages on the UI subscriber */
+static void ui_handler(const struct zbus_channel *chan)
+{
+	if (chan == &NETWORK_CHAN) {
+		network_status_handler(chan);
+	} else if (chan == &PROVISIONING_CHAN) {
+		provisioning_status_handler(chan);
+	} else if (chan == &TRANSPORT_CHAN) {
+		transport_status_handler(chan);
 	}
 }
 
-/* Start UI module thread */
-K_THREAD_DEFINE(ui_thread, 4096, ui_task, NULL, NULL, NULL, 5, 0, 0); 
\ No newline at end of file
+/* Register subscriber and start UI module thread, or run on the executor */
+EXECUTOR_MODULE_DEFINE(ui,
+		       CONFIG_MQTT_SAMPLE_UI_MESSAGE_QUEUE_SIZE,
+		       ui_init, ui_handler,
+		       CONFIG_MQTT_SAMPLE_UI_THREAD_STACK_SIZE, 5,
+		       CONFIG_MQTT_SAMPLE_UI_EXECUTOR_QUEUE);
@@ -17,9 +17,18 @@
 #include <zephyr/net/conn_mgr_connectivity.h>
 #include <zephyr/net/dhcpv4.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/net/wifi_credentials.h>
 #include <net/softap_wifi_provision.h>
 #include <zephyr/zbus/zbus.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif /* CONFIG_SHELL */
 #include "message_channel.h"
+#include "wifi_provision.h"
+#include "boot_timeline.h"
+#if defined(CONFIG_MQTT_SAMPLE_SCAN_CACHE)
+#include "scan_cache.h"
+#endif /* CONFIG_MQTT_SAMPLE_SCAN_CACHE */
 
 LOG_MODULE_REGISTER(wifi_provision, CONFIG_SOFTAP_WIFI_PROVISION_MODULE_LOG_LEVEL);
 
@@ -37,6 +46,20 @@ LOG_MODULE_REGISTER(wifi_provision, CONFIG_SOFTAP_WIFI_PROVISION_MODULE_LOG_LEVE
 	IF_ENABLED(CONFIG_REBOOT, (sys_reboot(0)))
 
 static bool wifi_provisioned = false;
+static bool provisioning_initialized;
+
+static void provisioning_completed_publish(void)
+{
+	int ret;
+	enum provisioning_status status = PROVISIONING_COMPLETED;
+
+	boot_timeline_mark(BOOT_PHASE_PROVISIONED);
+
+	ret = zbus_chan_pub(&PROVISIONING_CHAN, &status, K_SECONDS(1));
+	if (ret) {
+		LOG_ERR("Failed to publish provisioning completion: %d", ret);
+	}
+}
 
 /* Network event handlers removed - handled by network module */
 
@@ -71,12 +94,7 @@ static void softap_wifi_provision_handler(const struct softap_wifi_provision_evt
 	case SOFTAP_WIFI_PROVISION_EVT_COMPLETED:
 		LOG_INF("Provisioning completed");
 		wifi_provisioned = true;
-		status = PROVISIONING_COMPLETED;
-		ret = zbus_chan_pub(&PROVISIONING_CHAN, &status, K_SECONDS(1));
-		if (ret) {
-			LOG_ERR("Failed to publish provisioning completion: %d", ret);
-		}
-		LOG_INF("Network event callbacks registered");
+		provisioning_completed_publish();
 		break;
 
 	case SOFTAP_WIFI_PROVISION_EVT_UNPROVISIONED_REBOOT_NEEDED:
@@ -96,35 +114,57 @@ static void softap_wifi_provision_handler(const struct softap_wifi_provision_evt
 	}
 }
 
-static int wifi_power_saving_disable(void)
+/* Initialize the SoftAP provisioning library and run provisioning. Only done on boots without
+ * stored credentials, so that provisioned boots do not bring up the SoftAP, HTTP server and
+ * mDNS machinery.
+ */
+static int provisioning_run(void)
 {
 	int ret;
-	struct net_if *iface = net_if_get_first_wifi();
-	struct wifi_ps_params params = {
-		.enabled = WIFI_PS_DISABLED
-	};
 
-	ret = net_mgmt(NET_REQUEST_WIFI_PS, iface, &params, sizeof(params));
+	if (provisioning_initialized) {
+		return -EALREADY;
+	}
+
+	ret = softap_wifi_provision_init(softap_wifi_provision_handler);
 	if (ret) {
-		LOG_ERR("Failed to disable PSM, error: %d", ret);
+		LOG_ERR("softap_wifi_provision_init, error: %d", ret);
 		FATAL_ERROR();
 		return ret;
 	}
 
-	return 0;
-}
+	provisioning_initialized = true;
+	boot_timeline_mark(BOOT_PHASE_PROVISIONING_INIT);
 
-static int wifi_power_saving_enable(void)
-{
-	int ret;
-	struct net_if *iface = net_if_get_first_wifi();
-	struct wifi_ps_params params = {
-		.enabled = WIFI_PS_ENABLED
-	};
-
-	ret = net_mgmt(NET_REQUEST_WIFI_PS, iface, &params, sizeof(params));
+	ret = conn_mgr_all_if_up(true);
 	if (ret) {
-		LOG_ERR("Failed to enable PSM, error: %d", ret);
+		LOG_ERR("conn_mgr_all_if_up, error: %d", ret);
+		FATAL_ERROR();
+		return ret;
+	}
+
+	boot_timeline_mark(BOOT_PHASE_IF_UP);
+
+	LOG_INF("Network interface brought up");
+
+#if defined(CONFIG_MQTT_SAMPLE_SCAN_CACHE)
+	/* Background scans are stopped before SoftAP mode is entered, as a scan takes the radio
+	 * off the access point's channel and disrupts its clients.
+	 */
+	scan_cache_stop();
+#endif /* CONFIG_MQTT_SAMPLE_SCAN_CACHE */
+
+	ret = softap_wifi_provision_start();
+	switch (ret) {
+	case 0:
+		break;
+	case -EALREADY:
+		/* Credentials stored meanwhile, the library has nothing to provision */
+		LOG_INF("Wi-Fi credentials found, skipping provisioning");
+		provisioning_completed_publish();
+		break;
+	default:
+		LOG_ERR("softap_wifi_provision_start, error: %d", ret);
 		FATAL_ERROR();
 		return ret;
 	}
@@ -132,40 +172,58 @@ static int wifi_power_saving_enable(void)
 	return 0;
 }
 
-/* Function used to disable and re-enable PSM after a configured amount of time post provisioning.
- * This is to ensure that the device is discoverable via mDNS so that clients can
- * confirm that provisioning succeeded. This is needed due to mDNS SD being unstable
- * in Power Save Mode.
+/* The station connection, and the Wi-Fi stack's state, are only replaced by the SoftAP from a
+ * clean boot, so provisioning is not started in place.
  */
-static void psm_set(void)
+static void provisioning_reboot(void)
 {
-	int ret;
+	LOG_INF("No Wi-Fi credentials stored, rebooting to provision");
+	LOG_PANIC();
+	IF_ENABLED(CONFIG_REBOOT, (sys_reboot(SYS_REBOOT_COLD)));
+}
 
-	ret = wifi_power_saving_disable();
-	if (ret) {
-		LOG_ERR("wifi_power_saving_disable, error: %d", ret);
-		FATAL_ERROR();
-		return;
+int wifi_provision_start(void)
+{
+	if (!wifi_credentials_is_empty()) {
+		return 0;
+	}
+
+	/* Credentials deleted at runtime, for instance from the Wi-Fi credentials shell */
+	if (!provisioning_initialized) {
+		provisioning_reboot();
 	}
 
-	LOG_INF("PSM disabled");
+	return 1;
+}
 
-	k_sleep(K_SECONDS(CONFIG_SOFTAP_WIFI_PROVISION_MODULE_PSM_DISABLED_SECONDS));
+int wifi_provision_reset(void)
+{
+	int ret;
 
-	ret = wifi_power_saving_enable();
+	ret = wifi_credentials_delete_all();
 	if (ret) {
-		LOG_ERR("wifi_power_saving_enable, error: %d", ret);
-		FATAL_ERROR();		
-		return;
+		LOG_ERR("wifi_credentials_delete_all, error: %d", ret);
+		return ret;
 	}
 
-	LOG_INF("PSM enabled");
+	provisioning_reboot();
+
+	return 0;
+}
+
+bool wifi_provision_is_active(void)
+{
+	return provisioning_initialized && !wifi_provisioned;
+}
+
+bool wifi_provision_is_completed(void)
+{
+	return wifi_provisioned;
 }
 
 static void wifi_provision_task(void)
 {
 	int ret;
-	bool provisioning_completed = false;
 
 	LOG_INF("SoftAP Wi-Fi provision sample started");
 
@@ -176,54 +234,65 @@ static void wifi_provision_task(void)
 		LOG_ERR("Failed to publish initial provisioning status: %d", ret);
 	}
 
+	/* Provisioned boot, connect as a station right away */
+	if (!wifi_credentials_is_empty()) {
+		LOG_INF("Wi-Fi credentials found, skipping provisioning");
+		boot_timeline_mark(BOOT_PHASE_PROVISIONING_INIT);
 
+		ret = conn_mgr_all_if_up(true);
+		if (ret) {
+			LOG_ERR("conn_mgr_all_if_up, error: %d", ret);
+			FATAL_ERROR();
+			return;
+		}
 
-	ret = softap_wifi_provision_init(softap_wifi_provision_handler);
-	if (ret) {
-		LOG_ERR("softap_wifi_provision_init, error: %d", ret);
-		FATAL_ERROR();
-		return;
-	}
+		boot_timeline_mark(BOOT_PHASE_IF_UP);
 
-	ret = conn_mgr_all_if_up(true);
-	if (ret) {
-		LOG_ERR("conn_mgr_all_if_up, error: %d", ret);
-		FATAL_ERROR();
-		return;
-	}
+		wifi_provisioned = true;
 
-	LOG_INF("Network interface brought up");
+		/* Network connection is handled by the network module once it receives the
+		 * provisioning completion notification.
+		 */
+		provisioning_completed_publish();
 
-	ret = softap_wifi_provision_start();
-	switch (ret) {
-	case 0:
-		provisioning_completed = true;
-		break;
-	case -EALREADY:
-		LOG_INF("Wi-Fi credentials found, skipping provisioning");
-		provisioning_completed = true;
-		/* Notify network module that provisioning is complete */
-		enum provisioning_status status = PROVISIONING_COMPLETED;
-		ret = zbus_chan_pub(&PROVISIONING_CHAN, &status, K_SECONDS(1));
-		if (ret) {
-			LOG_ERR("Failed to publish provisioning completion: %d", ret);
-		}
-		break;
-	default:
-		LOG_ERR("softap_wifi_provision_start, error: %d", ret);
-		FATAL_ERROR();
+		/* Provisioning is only entered again by rebooting without credentials */
 		return;
 	}
 
-	/* Network connection will be handled by the network module after
-	 * it receives the provisioning completion notification */
+	(void)provisioning_run();
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_start(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
 
-	if (provisioning_completed) {
-		psm_set();
+	if (wifi_provision_start() == 0) {
+		shell_print(sh, "Wi-Fi credentials stored, use reset to provision again");
 	}
-    return;
+
+	return 0;
 }
 
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(sh);
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	return wifi_provision_reset();
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_wifi_provision,
+	SHELL_CMD(start, NULL, "Reboot to provision, if no credentials are stored", cmd_start),
+	SHELL_CMD(reset, NULL, "Delete the credentials and reboot to provision", cmd_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(wifi_provision, &sub_wifi_provision, "SoftAP Wi-Fi provisioning", NULL);
+#endif /* CONFIG_SHELL */
+
 // Set higher priority than network module 
 K_THREAD_DEFINE(wifi_provision_thread, 8192, wifi_provision_task, NULL, NULL, NULL,
 		2, 0, 0);
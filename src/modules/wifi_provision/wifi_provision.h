@@ -30,10 +30,12 @@ int wifi_provision_init(void);
  * @brief Start WiFi provisioning process
  *
  * This function will check if WiFi credentials are already stored.
- * If not, it will start the SoftAP provisioning process.
+ * If not, and provisioning is not already running, it reboots the device, as the SoftAP
+ * provisioning library is only initialized on boots without stored credentials. Provisioned
+ * boots connect as a station without it.
  *
  * @return 0 if credentials exist and device is ready to connect
- * @return 1 if provisioning was started
+ * @return 1 if provisioning is running, or the device is rebooting to provision
  * @return negative error code on failure
  */
 int wifi_provision_start(void);
@@ -41,6 +43,8 @@ int wifi_provision_start(void);
 /**
  * @brief Reset stored WiFi credentials
  *
+ * Deletes the stored credentials and reboots, so that provisioning starts on the next boot.
+ *
  * @return 0 on success, negative error code on failure
  */
 int wifi_provision_reset(void);
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#include "mqtt_sim.h"
+
+#define PUBLISH_MAX		200
+#define CONNACK_DELAY_MS	50
+#define PUBACK_DELAY_MS		20
+
+/* Time the simulator's work may run late by, as it runs on the tick after it is due */
+#define MARGIN_MS		5
+
+/* Time the test client waits before reconnecting, as the transport module would */
+#define RECONNECT_DELAY_MS	200
+
+static K_SEM_DEFINE(connack_sem, 0, 1);
+static K_SEM_DEFINE(disconnect_sem, 0, 1);
+static K_SEM_DEFINE(puback_sem, 0, PUBLISH_MAX);
+
+static enum mqtt_conn_return_code connack_code;
+static int disconnect_result;
+
+/* Publish time and publish to PUBACK latency of each message, by message ID */
+static int64_t published_ms[PUBLISH_MAX];
+static int64_t latency_ms[PUBLISH_MAX];
+
+/* Callbacks, called from the simulator's workqueue */
+
+static void on_connack(enum mqtt_conn_return_code return_code, bool session_present)
+{
+	ARG_UNUSED(session_present);
+
+	connack_code = return_code;
+	k_sem_give(&connack_sem);
+}
+
+static void on_disconnect(int result)
+{
+	disconnect_result = result;
+	k_sem_give(&disconnect_sem);
+}
+
+static void on_puback(uint16_t message_id, int result)
+{
+	size_t slot = message_id % PUBLISH_MAX;
+
+	ARG_UNUSED(result);
+
+	latency_ms[slot] = k_uptime_get() - published_ms[slot];
+	k_sem_give(&puback_sem);
+}
+
+static void broker_connect(void)
+{
+	struct mqtt_helper_conn_params params = { 0 };
+
+	zassert_ok(mqtt_sim_connect(&params));
+	zassert_ok(k_sem_take(&connack_sem, K_SECONDS(1)), "No CONNACK");
+	zassert_equal(connack_code, MQTT_CONNECTION_ACCEPTED);
+}
+
+static int broker_publish(uint16_t *message_id)
+{
+	struct mqtt_publish_param param = {
+		.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE,
+		.message.topic.topic.utf8 = (const uint8_t *)"test",
+		.message.topic.topic.size = sizeof("test") - 1,
+		.message_id = mqtt_sim_msg_id_get(),
+	};
+	size_t slot = param.message_id % PUBLISH_MAX;
+
+	published_ms[slot] = k_uptime_get();
+	latency_ms[slot] = -1;
+
+	if (message_id) {
+		*message_id = param.message_id;
+	}
+
+	return mqtt_sim_publish(&param);
+}
+
+static void *suite_setup(void)
+{
+	struct mqtt_helper_cfg cfg = {
+		.cb = {
+			.on_connack = on_connack,
+			.on_disconnect = on_disconnect,
+			.on_puback = on_puback,
+		},
+	};
+
+	zassert_ok(mqtt_sim_init(&cfg));
+
+	return NULL;
+}
+
+static void before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	struct mqtt_sim_script script = {
+		.connack_delay_ms = CONNACK_DELAY_MS,
+		.puback_delay_ms = PUBACK_DELAY_MS,
+	};
+
+	mqtt_sim_script_set(&script);
+	mqtt_sim_stats_reset();
+
+	k_sem_reset(&connack_sem);
+	k_sem_reset(&disconnect_sem);
+	k_sem_reset(&puback_sem);
+}
+
+static void after(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	/* Messages in flight are dropped with the connection, so tests do not interfere */
+	if (mqtt_sim_disconnect() == 0) {
+		zassert_ok(k_sem_take(&disconnect_sem, K_SECONDS(1)));
+	}
+}
+
+ZTEST(mqtt_sim, test_connect_refused)
+{
+	struct mqtt_helper_conn_params params = { 0 };
+	struct mqtt_sim_script script;
+	struct mqtt_sim_stats stats;
+	int64_t start_ms;
+
+	mqtt_sim_script_get(&script);
+	script.connect_failures = 2;
+	mqtt_sim_script_set(&script);
+
+	zassert_equal(mqtt_sim_connect(&params), -ECONNREFUSED);
+	zassert_equal(mqtt_sim_connect(&params), -ECONNREFUSED);
+
+	start_ms = k_uptime_get();
+	broker_connect();
+	zassert_within(k_uptime_get() - start_ms, CONNACK_DELAY_MS, MARGIN_MS);
+
+	/* Only one attempt at a time */
+	zassert_equal(mqtt_sim_connect(&params), -EOPNOTSUPP);
+
+	mqtt_sim_stats_get(&stats);
+	zassert_equal(stats.connects_refused, 2);
+	zassert_equal(stats.connects, 1);
+}
+
+ZTEST(mqtt_sim, test_puback_latency)
+{
+	struct mqtt_sim_script script;
+	struct mqtt_sim_stats stats;
+	uint16_t ids[50];
+
+	mqtt_sim_script_get(&script);
+	script.puback_jitter_ms = 10;
+	mqtt_sim_script_set(&script);
+
+	broker_connect();
+
+	for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+		zassert_ok(broker_publish(&ids[i]));
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+		zassert_ok(k_sem_take(&puback_sem, K_SECONDS(1)), "PUBACK %zu missing", i);
+	}
+
+	/* Each PUBACK arrives after the scripted delay, plus up to the jitter */
+	for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+		int64_t latency = latency_ms[ids[i] % PUBLISH_MAX];
+
+		zassert_between_inclusive(latency, PUBACK_DELAY_MS,
+					  PUBACK_DELAY_MS + script.puback_jitter_ms + MARGIN_MS,
+					  "message %u: %lld ms", ids[i], (long long)latency);
+	}
+
+	mqtt_sim_stats_get(&stats);
+	zassert_equal(stats.publishes, ARRAY_SIZE(ids));
+	zassert_equal(stats.pubacks, ARRAY_SIZE(ids));
+	zassert_equal(stats.pubacks_lost, 0);
+}
+
+ZTEST(mqtt_sim, test_puback_loss)
+{
+	struct mqtt_sim_script script;
+	struct mqtt_sim_stats stats;
+	uint32_t received = 0;
+
+	mqtt_sim_script_get(&script);
+	script.puback_loss_permille = 250;
+	mqtt_sim_script_set(&script);
+
+	broker_connect();
+
+	for (size_t i = 0; i < PUBLISH_MAX; i++) {
+		zassert_ok(broker_publish(NULL));
+	}
+
+	k_sleep(K_MSEC(PUBACK_DELAY_MS + 100));
+
+	while (k_sem_take(&puback_sem, K_NO_WAIT) == 0) {
+		received++;
+	}
+
+	mqtt_sim_stats_get(&stats);
+	zassert_equal(stats.publishes, PUBLISH_MAX);
+	zassert_equal(stats.pubacks, received);
+	zassert_equal(stats.pubacks + stats.pubacks_lost, PUBLISH_MAX);
+
+	/* A quarter of the PUBACKs is lost, within what a fixed seed can deviate by */
+	zassert_between_inclusive(stats.pubacks_lost, PUBLISH_MAX / 8, (PUBLISH_MAX * 3) / 8,
+				  "%u PUBACKs lost", stats.pubacks_lost);
+}
+
+ZTEST(mqtt_sim, test_reconnect_timing)
+{
+	struct mqtt_sim_script script;
+	struct mqtt_sim_stats stats;
+
+	/* Dropped on the fifth publish, before any of the messages is acknowledged */
+	mqtt_sim_script_get(&script);
+	script.disconnect_after = 5;
+	script.puback_delay_ms = 1000;
+	mqtt_sim_script_set(&script);
+
+	broker_connect();
+
+	for (size_t i = 0; i < script.disconnect_after; i++) {
+		zassert_ok(broker_publish(NULL));
+	}
+
+	zassert_ok(k_sem_take(&disconnect_sem, K_SECONDS(1)), "Connection not dropped");
+	zassert_equal(disconnect_result, -ECONNRESET);
+	zassert_equal(broker_publish(NULL), -ENOTCONN);
+
+	k_sleep(K_MSEC(RECONNECT_DELAY_MS));
+	broker_connect();
+
+	/* Messages in flight are lost with the connection */
+	zassert_equal(k_sem_take(&puback_sem, K_MSEC(script.puback_delay_ms + MARGIN_MS)),
+		      -EAGAIN);
+
+	mqtt_sim_stats_get(&stats);
+	zassert_equal(stats.disconnects_injected, 1);
+	zassert_equal(stats.publishes, script.disconnect_after);
+	zassert_equal(stats.pubacks, 0);
+	zassert_equal(stats.pubacks_lost, script.disconnect_after);
+	zassert_equal(stats.connects, 2);
+
+	/* From the dropped connection to the next CONNACK */
+	zassert_within(stats.reconnect_last_ms, RECONNECT_DELAY_MS + CONNACK_DELAY_MS, MARGIN_MS,
+		       "%u ms", stats.reconnect_last_ms);
+	zassert_equal(stats.reconnect_max_ms, stats.reconnect_last_ms);
+}
+
+ZTEST(mqtt_sim, test_disconnect_inject)
+{
+	struct mqtt_sim_stats stats;
+
+	zassert_equal(mqtt_sim_disconnect_inject(), -ENOTCONN);
+
+	broker_connect();
+
+	zassert_ok(mqtt_sim_disconnect_inject());
+	zassert_ok(k_sem_take(&disconnect_sem, K_SECONDS(1)));
+	zassert_equal(disconnect_result, -ECONNRESET);
+	zassert_equal(mqtt_sim_disconnect_inject(), -ENOTCONN);
+
+	mqtt_sim_stats_get(&stats);
+	zassert_equal(stats.disconnects_injected, 1);
+	zassert_equal(stats.disconnects, 0);
+}
+
+ZTEST_SUITE(mqtt_sim, NULL, suite_setup, before, after, NULL);
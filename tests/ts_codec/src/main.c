@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2025 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+
+#include "ts_codec.h"
+
+#define SAMPLES 64
+
+static uint8_t block[1024];
+
+/* Timestamps of a sampler with some jitter, and a repeated timestamp */
+static void timestamps_fill(uint64_t *ts)
+{
+	ts[0] = 123456;
+
+	for (size_t i = 1; i < SAMPLES; i++) {
+		ts[i] = ts[i - 1] + 1000 + ((i % 5) * 3) - 6;
+	}
+
+	ts[10] = ts[9];
+}
+
+static void doubles_fill(double *values)
+{
+	for (size_t i = 0; i < SAMPLES; i++) {
+		values[i] = (i % 7 == 0) ? -0.5 * i : 1000.0 + (i * 0.25);
+	}
+
+	/* Repeated value, which XOR encodes to a single bit */
+	values[20] = values[19];
+}
+
+ZTEST(ts_codec, test_double_round_trip)
+{
+	uint64_t ts[SAMPLES];
+	double values[SAMPLES];
+	struct ts_codec_enc enc;
+	struct ts_codec_dec dec;
+	uint64_t ts_out;
+	double value_out;
+	size_t len;
+
+	timestamps_fill(ts);
+	doubles_fill(values);
+
+	zassert_ok(ts_codec_enc_init(&enc, TS_CODEC_VALUE_DOUBLE, block, sizeof(block)));
+
+	for (size_t i = 0; i < SAMPLES; i++) {
+		zassert_ok(ts_codec_enc_add_double(&enc, ts[i], values[i]), "sample %zu", i);
+	}
+
+	zassert_equal(ts_codec_enc_count(&enc), SAMPLES);
+
+	len = ts_codec_enc_finish(&enc);
+	zassert_true(len < (SAMPLES * (sizeof(uint64_t) + sizeof(double))),
+		     "block not compressed: %zu bytes", len);
+
+	zassert_ok(ts_codec_dec_init(&dec, block, len));
+
+	for (size_t i = 0; i < SAMPLES; i++) {
+		zassert_ok(ts_codec_dec_next_double(&dec, &ts_out, &value_out), "sample %zu", i);
+		zassert_equal(ts_out, ts[i], "sample %zu", i);
+		zassert_mem_equal(&value_out, &values[i], sizeof(double), "sample %zu", i);
+	}
+
+	zassert_equal(ts_codec_dec_next_double(&dec, &ts_out, &value_out), -ENODATA);
+}
+
+ZTEST(ts_codec, test_int_round_trip)
+{
+	uint64_t ts[SAMPLES];
+	int64_t values[SAMPLES];
+	struct ts_codec_enc enc;
+	struct ts_codec_dec dec;
+	uint64_t ts_out;
+	int64_t value_out;
+	size_t len;
+
+	timestamps_fill(ts);
+
+	for (size_t i = 0; i < SAMPLES; i++) {
+		values[i] = (i % 2) ? -(int64_t)(i * i) : (int64_t)i << 40;
+	}
+
+	values[1] = INT64_MIN;
+	values[2] = INT64_MAX;
+
+	zassert_ok(ts_codec_enc_init(&enc, TS_CODEC_VALUE_INT, block, sizeof(block)));
+
+	for (size_t i = 0; i < SAMPLES; i++) {
+		zassert_ok(ts_codec_enc_add_int(&enc, ts[i], values[i]), "sample %zu", i);
+	}
+
+	len = ts_codec_enc_finish(&enc);
+
+	zassert_ok(ts_codec_dec_init(&dec, block, len));
+
+	for (size_t i = 0; i < SAMPLES; i++) {
+		zassert_ok(ts_codec_dec_next_int(&dec, &ts_out, &value_out), "sample %zu", i);
+		zassert_equal(ts_out, ts[i], "sample %zu", i);
+		zassert_equal(value_out, values[i], "sample %zu", i);
+	}
+
+	zassert_equal(ts_codec_dec_next_int(&dec, &ts_out, &value_out), -ENODATA);
+}
+
+/* Deltas whose difference does not fit in a signed 64-bit integer */
+ZTEST(ts_codec, test_large_deltas)
+{
+	const uint64_t ts[] = { 0, (1ULL << 63) + 1, UINT64_MAX, UINT64_MAX };
+	struct ts_codec_enc enc;
+	struct ts_codec_dec dec;
+	uint64_t ts_out;
+	int64_t value_out;
+	size_t len;
+
+	zassert_ok(ts_codec_enc_init(&enc, TS_CODEC_VALUE_INT, block, sizeof(block)));
+
+	for (size_t i = 0; i < ARRAY_SIZE(ts); i++) {
+		zassert_ok(ts_codec_enc_add_int(&enc, ts[i], i), "sample %zu", i);
+	}
+
+	len = ts_codec_enc_finish(&enc);
+
+	zassert_ok(ts_codec_dec_init(&dec, block, len));
+
+	for (size_t i = 0; i < ARRAY_SIZE(ts); i++) {
+		zassert_ok(ts_codec_dec_next_int(&dec, &ts_out, &value_out), "sample %zu", i);
+		zassert_equal(ts_out, ts[i], "sample %zu", i);
+		zassert_equal(value_out, i, "sample %zu", i);
+	}
+}
+
+/* A sample that does not fit leaves the block as it was, and the block still decodes */
+ZTEST(ts_codec, test_full_block)
+{
+	uint8_t small[24];
+	struct ts_codec_enc enc;
+	struct ts_codec_dec dec;
+	uint64_t ts = 1000;
+	uint64_t ts_out;
+	double value_out;
+	uint16_t count;
+	size_t len;
+	int err;
+
+	zassert_ok(ts_codec_enc_init(&enc, TS_CODEC_VALUE_DOUBLE, small, sizeof(small)));
+
+	do {
+		/* Values that do not compress well */
+		err = ts_codec_enc_add_double(&enc, ts, (double)(ts * 7919) / 3.0);
+		ts += 1000 + (ts % 7);
+	} while (err == 0);
+
+	zassert_equal(err, -ENOMEM);
+
+	count = ts_codec_enc_count(&enc);
+	zassert_true(count > 0);
+
+	len = ts_codec_enc_finish(&enc);
+	zassert_true(len <= sizeof(small));
+
+	zassert_ok(ts_codec_dec_init(&dec, small, len));
+
+	for (uint16_t i = 0; i < count; i++) {
+		zassert_ok(ts_codec_dec_next_double(&dec, &ts_out, &value_out), "sample %u", i);
+	}
+
+	zassert_equal(ts_codec_dec_next_double(&dec, &ts_out, &value_out), -ENODATA);
+}
+
+ZTEST(ts_codec, test_invalid_input)
+{
+	uint64_t ts[SAMPLES];
+	double values[SAMPLES];
+	struct ts_codec_enc enc;
+	struct ts_codec_dec dec;
+	uint64_t ts_out;
+	double value_out;
+	size_t len;
+	int err = 0;
+
+	timestamps_fill(ts);
+	doubles_fill(values);
+
+	zassert_ok(ts_codec_enc_init(&enc, TS_CODEC_VALUE_DOUBLE, block, sizeof(block)));
+	zassert_ok(ts_codec_enc_add_double(&enc, ts[1], values[1]));
+
+	/* Timestamps must not go backwards, and the value type must match the block's */
+	zassert_equal(ts_codec_enc_add_double(&enc, ts[0], values[0]), -EINVAL);
+	zassert_equal(ts_codec_enc_add_int(&enc, ts[2], 2), -EINVAL);
+
+	for (size_t i = 2; i < SAMPLES; i++) {
+		zassert_ok(ts_codec_enc_add_double(&enc, ts[i], values[i]));
+	}
+
+	len = ts_codec_enc_finish(&enc);
+
+	/* A truncated block runs out of bits before the last sample */
+	zassert_ok(ts_codec_dec_init(&dec, block, len / 2));
+
+	for (size_t i = 1; (i < SAMPLES) && (err == 0); i++) {
+		err = ts_codec_dec_next_double(&dec, &ts_out, &value_out);
+	}
+
+	zassert_equal(err, -EBADMSG);
+
+	/* Unsupported version */
+	block[0] = (block[0] & 0x0F) | ((TS_CODEC_VERSION + 1) << 4);
+	zassert_equal(ts_codec_dec_init(&dec, block, len), -ENOTSUP);
+
+	zassert_equal(ts_codec_dec_init(&dec, block, TS_CODEC_HEADER_SIZE - 1), -EINVAL);
+}
+
+ZTEST_SUITE(ts_codec, NULL, NULL, NULL, NULL, NULL);